@@ -0,0 +1,247 @@
+#include "AgentSim.hh"
+
+#include <cstdint>
+#include <cmath>       // cos sin atan2 sqrt ceil floor M_PI
+
+#include <algorithm>   // min max
+#include <chrono>
+#include <random>      // mt19937 uniform_real_distribution
+#include <utility>     // move swap
+
+
+AgentSim::AgentSim(std::shared_ptr<Layout> _shared_layout) :
+    shared_layout(std::move(_shared_layout)), layout(*shared_layout) {}
+
+void AgentSim::spawn(const uint32_t agent_ct, const uint32_t seed) {
+    pos_x.resize(agent_ct);
+    pos_y.resize(agent_ct);
+    heading.resize(agent_ct);
+    next_pos_x.resize(agent_ct);
+    next_pos_y.resize(agent_ct);
+    next_heading.resize(agent_ct);
+    rng_state.resize(agent_ct);
+    agent_bucket.resize(agent_ct);
+    agent_tile_keys.resize(agent_ct);
+    bucket_agent_is.resize(agent_ct);
+    bucket_pos_x.resize(agent_ct);
+    bucket_pos_y.resize(agent_ct);
+    bucket_tile_keys.resize(agent_ct);
+    for (hash_bucket_ct = 1; hash_bucket_ct < agent_ct * 2; hash_bucket_ct <<= 1);
+
+    std::mt19937 rng { seed };
+    std::uniform_real_distribution<float> unit_dist { 0, 1 };
+    for (uint32_t i { 0 }; i < agent_ct; ++i) {
+        uint32_t tile_x;
+        uint32_t tile_y;
+        do {
+            tile_x = unit_dist(rng) * layout.w;
+            tile_y = unit_dist(rng) * layout.h;
+        } while (tile_x >= layout.w || tile_y >= layout.h ||
+                 layout.tileIsWall(tile_x, tile_y));
+        // fully inside tile, so clear of walls
+        pos_x[i] = tile_x + RADIUS + (unit_dist(rng) * (1 - (2 * RADIUS)));
+        pos_y[i] = tile_y + RADIUS + (unit_dist(rng) * (1 - (2 * RADIUS)));
+        heading[i] = (unit_dist(rng) * 2 - 1) * float(M_PI);
+        // xorshift state must be nonzero
+        rng_state[i] = rng() | 1;
+    }
+    prev_pos_x = pos_x;
+    prev_pos_y = pos_y;
+}
+
+void AgentSim::buildSpatialHash() {
+    const uint32_t agent_ct { size() };
+    // counting sort: count agents per bucket, offset each bucket by the
+    //   counts before it, then place agents at their bucket's next free slot
+    bucket_offsets.assign(hash_bucket_ct + 1, 0);
+    for (uint32_t i { 0 }; i < agent_ct; ++i) {
+        const uint32_t tile_x ( pos_x[i] );
+        const uint32_t tile_y ( pos_y[i] );
+        agent_tile_keys[i] = tileKey(tile_x, tile_y);
+        agent_bucket[i] = tileBucket(tile_x, tile_y);
+        ++bucket_offsets[agent_bucket[i] + 1];
+    }
+    for (uint32_t b { 0 }; b < hash_bucket_ct; ++b)
+        bucket_offsets[b + 1] += bucket_offsets[b];
+    // bucket_offsets[b] is advanced as bucket b fills, ending at the start of
+    //   bucket b + 1, then shifted back
+    for (uint32_t i { 0 }; i < agent_ct; ++i) {
+        const uint32_t k { bucket_offsets[agent_bucket[i]]++ };
+        bucket_agent_is[k] = i;
+        bucket_pos_x[k] = pos_x[i];
+        bucket_pos_y[k] = pos_y[i];
+        bucket_tile_keys[k] = agent_tile_keys[i];
+    }
+    for (uint32_t b { hash_bucket_ct }; b > 0; --b)
+        bucket_offsets[b] = bucket_offsets[b - 1];
+    bucket_offsets[0] = 0;
+}
+
+void AgentSim::avoidNeighbors(const uint32_t i,
+                              float& push_x, float& push_y) const {
+    push_x = 0;
+    push_y = 0;
+    const float x { pos_x[i] };
+    const float y { pos_y[i] };
+    const uint32_t agent_tile_x ( agent_tile_keys[i] >> 32 );
+    const uint32_t agent_tile_y ( agent_tile_keys[i] & 0xFFFFFFFF );
+    // agents only stand in empty tiles, which the map's perimeter walls keep
+    //   off the map edges, so neighboring tiles are always in the map
+    for (uint32_t tile_y ( agent_tile_y - 1 ); tile_y <= agent_tile_y + 1;
+         ++tile_y) {
+        for (uint32_t tile_x ( agent_tile_x - 1 ); tile_x <= agent_tile_x + 1;
+             ++tile_x) {
+            const uint64_t tile_key { tileKey(tile_x, tile_y) };
+            const uint32_t b { tileBucket(tile_x, tile_y) };
+            for (uint32_t k { bucket_offsets[b] }; k < bucket_offsets[b + 1]; ++k) {
+                if (bucket_tile_keys[k] != tile_key)
+                    continue;
+                const uint32_t j { bucket_agent_is[k] };
+                const float offset_x { x - bucket_pos_x[k] };
+                const float offset_y { y - bucket_pos_y[k] };
+                const float dist_sq { (offset_x * offset_x) + (offset_y * offset_y) };
+                if (j == i || !(dist_sq < AVOID_DIST * AVOID_DIST))
+                    continue;
+                // coincident agents split by index
+                if (dist_sq == 0) {
+                    push_x += (i < j) ? 1 : -1;
+                    continue;
+                }
+                const float dist { std::sqrt(dist_sq) };
+                const float weight { (AVOID_DIST - dist) / (AVOID_DIST * dist) };
+                push_x += offset_x * weight;
+                push_y += offset_y * weight;
+            }
+        }
+    }
+}
+
+bool AgentSim::resolveWallOverlap(float& x, float& y,
+                                  float& normal_x, float& normal_y) const {
+    normal_x = 0;
+    normal_y = 0;
+    if (layout.tileIsWall(x, y))
+        return false;
+    // RADIUS is at most half a tile, so the circle overlaps at most 2x2 tiles
+    const uint32_t tile_x0 ( x - RADIUS );
+    const uint32_t tile_x1 ( x + RADIUS );
+    const uint32_t tile_y0 ( y - RADIUS );
+    const uint32_t tile_y1 ( y + RADIUS );
+    for (uint32_t tile_y { tile_y0 }; tile_y <= tile_y1; ++tile_y) {
+        for (uint32_t tile_x { tile_x0 }; tile_x <= tile_x1; ++tile_x) {
+            if (!layout.tileIsWall(tile_x, tile_y))
+                continue;
+            // push center directly away from nearest point of tile square
+            const float offset_x { x -
+                std::min(std::max(x, float(tile_x)), float(tile_x + 1)) };
+            const float offset_y { y -
+                std::min(std::max(y, float(tile_y)), float(tile_y + 1)) };
+            const float dist_sq { (offset_x * offset_x) + (offset_y * offset_y) };
+            if (!(dist_sq < RADIUS * RADIUS) || dist_sq == 0)
+                continue;
+            const float dist { std::sqrt(dist_sq) };
+            x += offset_x * ((RADIUS - dist) / dist);
+            y += offset_y * ((RADIUS - dist) / dist);
+            normal_x += offset_x / dist;
+            normal_y += offset_y / dist;
+        }
+    }
+    return true;
+}
+
+void AgentSim::updateAgent(const uint32_t i, const float dt) {
+    // wander: turn by a random amount each update
+    uint32_t rng { rng_state[i] };
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    rng_state[i] = rng;
+    float h { heading[i] +
+              ((float(rng) / float(UINT32_MAX)) * 2 - 1) * WANDER_RATE * dt };
+    if (h > float(M_PI))
+        h -= float(2 * M_PI);
+    else if (h < -float(M_PI))
+        h += float(2 * M_PI);
+
+    // steer between heading and away from crowding neighbors, no faster
+    //   than SPEED
+    float push_x;
+    float push_y;
+    avoidNeighbors(i, push_x, push_y);
+    float vel_x { std::cos(h) + (AVOID_WEIGHT * push_x) };
+    float vel_y { std::sin(h) + (AVOID_WEIGHT * push_y) };
+    const float vel_mag { std::sqrt((vel_x * vel_x) + (vel_y * vel_y)) };
+    if (vel_mag > 1) {
+        vel_x /= vel_mag;
+        vel_y /= vel_mag;
+    }
+    vel_x *= SPEED * dt;
+    vel_y *= SPEED * dt;
+
+    // move in substeps of at most RADIUS, so that the center can reach no
+    //   further than the edge of a wall tile before being pushed back out
+    const uint16_t step_ct ( std::max(1.0f, std::ceil(
+        std::min(vel_mag, 1.0f) * SPEED * dt / RADIUS)) );
+    vel_x /= step_ct;
+    vel_y /= step_ct;
+    float x { pos_x[i] };
+    float y { pos_y[i] };
+    float wall_normal_x { 0 };
+    float wall_normal_y { 0 };
+    for (uint16_t step_i { 0 }; step_i < step_ct; ++step_i) {
+        const float prev_x { x };
+        const float prev_y { y };
+        x += vel_x;
+        y += vel_y;
+        float normal_x;
+        float normal_y;
+        if (!resolveWallOverlap(x, y, normal_x, normal_y)) {
+            x = prev_x;
+            y = prev_y;
+            normal_x = -vel_x;
+            normal_y = -vel_y;
+        }
+        wall_normal_x += normal_x;
+        wall_normal_y += normal_y;
+    }
+
+    // bounce off walls hit by reflecting heading about their normal
+    const float normal_mag { std::sqrt((wall_normal_x * wall_normal_x) +
+                                       (wall_normal_y * wall_normal_y)) };
+    if (normal_mag > 0) {
+        const float normal_x { wall_normal_x / normal_mag };
+        const float normal_y { wall_normal_y / normal_mag };
+        const float dir_x { std::cos(h) };
+        const float dir_y { std::sin(h) };
+        const float dot { (dir_x * normal_x) + (dir_y * normal_y) };
+        if (dot < 0) {
+            h = std::atan2(dir_y - (2 * dot * normal_y),
+                           dir_x - (2 * dot * normal_x));
+        }
+    }
+
+    next_pos_x[i] = x;
+    next_pos_y[i] = y;
+    next_heading[i] = h;
+}
+
+void AgentSim::update(const double dt, ThreadPool& thread_pool) {
+    const auto start { std::chrono::steady_clock::now() };
+    // longer gaps (eg while the window is dragged) slow agents down rather
+    //   than stepping them through a large number of substeps
+    const float step_dt ( std::min(dt, MAX_DT) );
+    buildSpatialHash();
+    thread_pool.forEachStrip(
+        size(), STRIP_SZ, [&](const uint32_t begin, const uint32_t end) {
+            for (uint32_t k { begin }; k < end; ++k)
+                updateAgent(bucket_agent_is[k], step_dt);
+        });
+    std::swap(prev_pos_x, pos_x);
+    std::swap(prev_pos_y, pos_y);
+    std::swap(pos_x, next_pos_x);
+    std::swap(pos_y, next_pos_y);
+    std::swap(heading, next_heading);
+    const std::chrono::duration<double> elapsed {
+        std::chrono::steady_clock::now() - start };
+    update_duration = elapsed.count();
+}
@@ -9,6 +9,8 @@
 #include <SDL2/SDL_events.h>  // SDL_QUIT SDL_KEY* SDL_PollEvent
 #include <SDL2/SDL_video.h>   // SDL_GetWindowID SDL_WINDOWEVENT_*
 
+#include <algorithm>          // remove_if find_if min
+#include <cmath>              // sqrt
 #include <csignal>            // sigaction SIG* sig_atomic_t
 #include <cstring>            // memset
 
@@ -26,10 +28,9 @@ static void sigwinch_handler(int /*signal*/) {
 }
 
 App::App(const char* efn, const std::string& mfn,
-         const bool _tty_io, TtyDisplayMode tty_display_mode) :
-    exec_filename(efn), map_filename(mfn), tty_io(_tty_io) {
-    if (tty_io)
-        settings.tty_display_mode = tty_display_mode;
+         const bool _tty_io, const Settings& _settings) :
+    exec_filename(efn), map_filename(mfn), tty_io(_tty_io),
+    settings(_settings), thread_pool(settings.thread_ct) {
 
     // wall textures are loaded with IMG_Load even when in tty mode,
     //   with SDL subsystems needed to report errors, so init regardless
@@ -65,7 +66,23 @@ void App::initialize() {
                  SIGWINCH, &sa, nullptr);
 
     // parse map file to get maze and starting actor positions
-    raycast_engine.loadMapFile(map_filename);
+    raycast_engine.loadMapFile(map_filename, settings.layout_storage,
+                               settings.chunk_budget_mb);
+    if (settings.pvs &&
+        !raycast_engine.layout.readPvsFile(map_filename + Layout::PVS_FILE_SUFFIX))
+        raycast_engine.layout.buildPotentiallyVisibleSets(thread_pool);
+    raycast_engine.bakeLighting(settings, thread_pool);
+    // agents wander the whole map and the sprite grid has a cell per tile,
+    //   neither of which chunk maps (too large to hold in memory) allow
+    if (raycast_engine.layout.isPaged()) {
+        agent_sim.spawn(0);
+        sprite_grid.resize(0, 0);
+    } else {
+        agent_sim.spawn(settings.agent_ct);
+        sprite_grid.resize(raycast_engine.layout.w, raycast_engine.layout.h);
+    }
+    tick_player = { raycast_engine.player_pos, raycast_engine.player_dir };
+    prev_tick_player = tick_player;
 
     if (tty_io)
         window_mgr = std::unique_ptr<TtyWindowMgr>(new TtyWindowMgr());
@@ -73,7 +90,7 @@ void App::initialize() {
         window_mgr = std::unique_ptr<SdlWindowMgr>(new SdlWindowMgr());
     window_mgr->initialize(settings, raycast_engine.layout.h);
 
-    raycast_engine.fitToWindow(tty_io, window_mgr->width(), window_mgr->height());
+    fitCamerasToWindow();
 
     if (tty_io) {
         kbd_input_mgr = std::unique_ptr<LinuxKbdInputMgr>(
@@ -92,6 +109,14 @@ void App::run() {
 
         getEvents();
         updateFromInput();
+        // layout only changes here, between frames, so that threads casting
+        //   and rendering the frame all see the same layout; edits queued by
+        //   input are applied before the simulation ticks, so that no agent
+        //   moves into a wall tile closed around it
+        raycast_engine.applyTileEdits(settings, thread_pool);
+        stepSimulation();
+        raycast_engine.pageChunks();
+        updateColumnScale();
 
         if (tty_io && sigwinch_received) {
             window_mgr->drawEmptyFrame();
@@ -100,20 +125,24 @@ void App::run() {
 
             window_mgr->fitToWindow(settings.map_proportion,
                                     raycast_engine.layout.h);
-            raycast_engine.fitToWindow(tty_io, window_mgr->width(),
-                                       window_mgr->height());
+            fitCamerasToWindow();
 
             sigwinch_received = 0;
         }
 
-        raycast_engine.castRays(settings);
-
-        window_mgr->renderView(raycast_engine.fov_rays, settings);
+        if (settings.camera_layout != CameraLayout::Single) {
+            rear_camera.placeCamera(raycast_engine.player_pos,
+                                    { -raycast_engine.player_dir.x,
+                                      -raycast_engine.player_dir.y });
+        }
+        window_mgr->renderViews(camera_views, sprite_grid, settings,
+                                thread_pool);
         if (settings.show_map)
-            window_mgr->renderMap(raycast_engine);
+            window_mgr->renderMap(raycast_engine, sprite_grid);
         window_mgr->renderHud(pt_fps_calc.frame_duration_mvg_avg,
                               rt_fps_calc.frame_duration_mvg_avg.count(),
-                              settings, raycast_engine, kbd_input_mgr.get());
+                              settings, raycast_engine, agent_sim,
+                              kbd_input_mgr.get());
 
         // second opportunity to abort drawing frame if SIGWINCH received
         //   during casting/rendering
@@ -129,6 +158,46 @@ void App::run() {
     }
 }
 
+void App::fitCamerasToWindow() {
+    const uint16_t w { window_mgr->width() };
+    const uint16_t h { window_mgr->height() };
+    camera_views.clear();
+    switch (settings.camera_layout) {
+    case CameraLayout::SplitScreen:
+    {
+        const uint16_t left_w ( w / 2 );
+        camera_views.push_back({ &raycast_engine, { 0, 0, left_w, h } });
+        camera_views.push_back({ &rear_camera,
+                                 { left_w, 0, uint16_t(w - left_w), h } });
+    }
+        break;
+    case CameraLayout::RearInset:
+    {
+        const uint16_t inset_w ( w / REAR_INSET_DIVISOR );
+        const uint16_t inset_h ( h / REAR_INSET_DIVISOR );
+        camera_views.push_back({ &raycast_engine, { 0, 0, w, h } });
+        // listed after the full window view, so drawn over it
+        camera_views.push_back({ &rear_camera,
+                                 { uint16_t((w - inset_w) / 2), 0,
+                                   inset_w, inset_h } });
+    }
+        break;
+    case CameraLayout::Single:
+    default:
+        camera_views.push_back({ &raycast_engine, { 0, 0, w, h } });
+        break;
+    }
+    // very small tty windows can leave no room for a view
+    camera_views.erase(
+        std::remove_if(camera_views.begin(), camera_views.end(),
+                       [](const CameraView& view) {
+                           return view.viewport.w == 0 || view.viewport.h == 0;
+                       }), camera_views.end());
+    for (const CameraView& view : camera_views) {
+        view.camera->fitToWindow(tty_io, view.viewport.w, view.viewport.h);
+    }
+}
+
 void App::getEvents() {
     if (tty_io) {
         kbd_input_mgr->consumeKeyEvents();
@@ -148,8 +217,7 @@ void App::getEvents() {
                     e.window.windowID == window_mgr->id() ) {
                     window_mgr->fitToWindow(settings.map_proportion,
                                            raycast_engine.layout.h);
-                    raycast_engine.fitToWindow(tty_io, window_mgr->width(),
-                                               window_mgr->height());
+                    fitCamerasToWindow();
                 }
                 break;
             case SDL_KEYDOWN:
@@ -163,6 +231,128 @@ void App::getEvents() {
     }
 }
 
+void App::stepSimulation() {
+    const double tick_duration { 1 / settings.sim_tick_rate };
+    sim_time_accum = std::min(
+        sim_time_accum + rt_fps_calc.frame_duration.count(),
+        tick_duration * MAX_SIM_TICKS_PER_FRAME);
+    // raycast_engine's player, placed between ticks for the last frame, is
+    //   moved back to tick_player to be moved by each tick
+    if (sim_time_accum >= tick_duration)
+        placeCamera(tick_player);
+    for (; sim_time_accum >= tick_duration; sim_time_accum -= tick_duration) {
+        prev_tick_player = tick_player;
+        updatePlayerFromInput(tick_duration);
+        tick_player = { raycast_engine.player_pos, raycast_engine.player_dir };
+        if (agent_sim.size() > 0)
+            agent_sim.update(tick_duration, thread_pool);
+    }
+
+    // Camera trails the simulation by up to a tick, so that it moves smoothly
+    //   at any frame rate: position interpolated linearly, direction likewise
+    //   then renormalized (turns per tick are small enough for this to stay
+    //   close to turning at a constant rate). A player that has not turned
+    //   keeps its direction exactly, so that an idle camera stays unchanged
+    //   and its rays can be reused.
+    const double t { sim_time_accum / tick_duration };
+    const Vector2d& p0 { prev_tick_player.pos };
+    const Vector2d& p1 { tick_player.pos };
+    const Vector2d& d0 { prev_tick_player.dir };
+    const Vector2d& d1 { tick_player.dir };
+    Vector2d dir { d1 };
+    if (d0.x != d1.x || d0.y != d1.y) {
+        dir = { d0.x + ((d1.x - d0.x) * t), d0.y + ((d1.y - d0.y) * t) };
+        const double dir_mag { std::sqrt((dir.x * dir.x) + (dir.y * dir.y)) };
+        dir = (dir_mag > 0) ? dir * (1 / dir_mag) : d1;
+    }
+    placeCamera({ { p0.x + ((p1.x - p0.x) * t), p0.y + ((p1.y - p0.y) * t) },
+                  dir });
+    // agents are drawn between their last two ticks likewise
+    if (agent_sim.size() > 0)
+        updateSprites(t);
+}
+
+void App::placeCamera(const PlayerState& player) {
+    // placing the camera where it already is would still rebuild the
+    //   view_plane from player_dir, so is skipped
+    const Vector2d& pos { raycast_engine.player_pos };
+    const Vector2d& dir { raycast_engine.player_dir };
+    if (pos.x == player.pos.x && pos.y == player.pos.y &&
+        dir.x == player.dir.x && dir.y == player.dir.y)
+        return;
+    raycast_engine.placeCamera(player.pos, player.dir);
+}
+
+void App::updateColumnScale() {
+    if (settings.target_fps <= 0) {
+        settings.column_scale = 1;
+        return;
+    }
+    if (column_scale_settle_ct > 0) {
+        --column_scale_settle_ct;
+        return;
+    }
+    const double target_frame_duration { 1 / settings.target_fps };
+    const double frame_duration { rt_fps_calc.frame_duration_mvg_avg.count() };
+    if (frame_duration > target_frame_duration &&
+        settings.column_scale < MAX_COLUMN_SCALE) {
+        settings.column_scale *= 2;
+        column_scale_settle_ct = COLUMN_SCALE_SETTLE_FRAME_CT;
+    } else if (frame_duration <
+               target_frame_duration * COLUMN_SCALE_HEADROOM_RATIO &&
+               settings.column_scale > 1) {
+        settings.column_scale /= 2;
+        column_scale_settle_ct = COLUMN_SCALE_SETTLE_FRAME_CT;
+    }
+}
+
+void App::updateSprites(const double t) {
+    const float ft ( t );
+    sprite_grid.clear();
+    for (uint32_t i { 0 }; i < agent_sim.size(); ++i) {
+        const float x0 { agent_sim.prev_pos_x[i] };
+        const float y0 { agent_sim.prev_pos_y[i] };
+        // color agents by index, to tell them apart
+        sprite_grid.add(Sprite {
+                x0 + ((agent_sim.pos_x[i] - x0) * ft),
+                y0 + ((agent_sim.pos_y[i] - y0) * ft), AGENT_SPRITE_SCALE,
+                uint8_t(i % WindowMgr::spriteTexCount()) });
+    }
+    sprite_grid.build();
+}
+
+void App::toggleWallAhead() {
+    Layout& layout { raycast_engine.layout };
+    // player as of the last tick, not as last rendered
+    const Vector2d& pos { tick_player.pos };
+    const Vector2d& dir { tick_player.dir };
+    const uint32_t x ( pos.x + dir.x );
+    const uint32_t y ( pos.y + dir.y );
+    // perimeter, segment map and chunk map tiles cannot be edited
+    if (layout.hasSegments() || layout.isPaged() || x == 0 || y == 0 ||
+        x >= layout.w - 1 || y >= layout.h - 1 ||
+        (x == uint32_t(pos.x) && y == uint32_t(pos.y)))
+        return;
+    if (layout.tileIsWall(x, y)) {
+        opened_walls.push_back({ x, y, layout.tile(x, y) });
+        layout.queueTileEdit(x, y, 0);
+        return;
+    }
+    const auto opened_wall { std::find_if(
+        opened_walls.begin(), opened_walls.end(),
+        [&](const OpenedWall& wall) { return wall.x == x && wall.y == y; }) };
+    if (opened_wall == opened_walls.end())
+        return;
+    // agents closed in would be stuck (checked at their last tick, as
+    //   sprite_grid holds them as drawn, up to a tick behind)
+    for (uint32_t i { 0 }; i < agent_sim.size(); ++i) {
+        if (uint32_t(agent_sim.pos_x[i]) == x && uint32_t(agent_sim.pos_y[i]) == y)
+            return;
+    }
+    layout.queueTileEdit(x, y, opened_wall->tex_key);
+    opened_walls.erase(opened_wall);
+}
+
 void App::updateFromInput() {
     if (tty_io) {
         updateFromLinuxInput();
@@ -171,23 +361,17 @@ void App::updateFromInput() {
     }
 }
 
-void App::updateFromLinuxInput() {
-    // ctrl+c: simulate SIGINT (quit)
-    if ((kbd_input_mgr->isPressed(KEY_LEFTCTRL) ||
-         kbd_input_mgr->isPressed(KEY_RIGHTCTRL)) &&
-        kbd_input_mgr->isPressed(KEY_C)) {
-        stop = true;
-        return;
-    }
-
-    // escape key: quit
-    if (kbd_input_mgr->isPressed(KEY_ESC)) {
-        stop = true;
-        return;
+void App::updatePlayerFromInput(const double tick_duration) {
+    if (tty_io) {
+        updatePlayerFromLinuxInput(tick_duration);
+    } else {
+        updatePlayerFromSdlInput(tick_duration);
     }
+}
 
-    double move_speed { pt_fps_calc.frame_duration_mvg_avg * settings.base_movement_rate };
-    double rot_speed  { pt_fps_calc.frame_duration_mvg_avg *
+void App::updatePlayerFromLinuxInput(const double tick_duration) {
+    double move_speed { tick_duration * settings.base_movement_rate };
+    double rot_speed  { tick_duration *
                         settings.base_movement_rate * settings.turn_rate };
 
     // shift key: run
@@ -226,6 +410,26 @@ void App::updateFromLinuxInput() {
             raycast_engine.playerTurnRight(rot_speed);
         }
     }
+}
+
+void App::updateFromLinuxInput() {
+    // ctrl+c: simulate SIGINT (quit)
+    if ((kbd_input_mgr->isPressed(KEY_LEFTCTRL) ||
+         kbd_input_mgr->isPressed(KEY_RIGHTCTRL)) &&
+        kbd_input_mgr->isPressed(KEY_C)) {
+        stop = true;
+        return;
+    }
+
+    // escape key: quit
+    if (kbd_input_mgr->isPressed(KEY_ESC)) {
+        stop = true;
+        return;
+    }
+
+    // space key: open or close wall ahead
+    if (kbd_input_mgr->keyDownThisFrame(KEY_SPACE))
+        toggleWallAhead();
 
     // F1 key: toggle FPS overlay
     if (kbd_input_mgr->keyDownThisFrame(KEY_F1))
@@ -243,6 +447,38 @@ void App::updateFromLinuxInput() {
     if (kbd_input_mgr->keyDownThisFrame(KEY_F4))
         settings.euclidean = !settings.euclidean;
 
+    // F5 key: toggle SIMD ray packet casting
+    if (kbd_input_mgr->keyDownThisFrame(KEY_F5))
+        settings.ray_packets = !settings.ray_packets;
+
+    // F6 key: toggle reuse of rays cast in previous frame
+    if (kbd_input_mgr->keyDownThisFrame(KEY_F6))
+        settings.ray_cache = !settings.ray_cache;
+
+    // F7 key: cycle empty space skipping modes
+    if (kbd_input_mgr->keyDownThisFrame(KEY_F7)) {
+        switch (settings.empty_space_skip) {
+        case EmptySpaceSkip::None:
+            settings.empty_space_skip = EmptySpaceSkip::DistanceField;
+            break;
+        case EmptySpaceSkip::DistanceField:
+            settings.empty_space_skip = EmptySpaceSkip::OccupancyPyramid;
+            break;
+        case EmptySpaceSkip::OccupancyPyramid:
+        default:
+            settings.empty_space_skip = EmptySpaceSkip::None;
+            break;
+        }
+    }
+
+    // F8 key: toggle reduced textures for far walls
+    if (kbd_input_mgr->keyDownThisFrame(KEY_F8))
+        settings.texture_lod = !settings.texture_lod;
+
+    // F9 key: toggle temporal column interleaving
+    if (kbd_input_mgr->keyDownThisFrame(KEY_F9))
+        settings.interleave = !settings.interleave;
+
     // F10 key: ascii pixels in tty mode
     if (kbd_input_mgr->keyDownThisFrame(KEY_F10))
         settings.tty_display_mode = TtyDisplayMode::Ascii;
@@ -268,23 +504,9 @@ void App::updateFromLinuxInput() {
     kbd_input_mgr->decayToAutorepeat();
 }
 
-void App::updateFromSdlInput() {
-    // ctrl+c: simulate SIGINT (quit)
-    if ((kbd_input_mgr->isPressed(SDLK_LCTRL) ||
-         kbd_input_mgr->isPressed(SDLK_RCTRL)) &&
-        kbd_input_mgr->isPressed(SDLK_c)) {
-        stop = true;
-        return;
-    }
-
-    // escape key: quit
-    if (kbd_input_mgr->isPressed(SDLK_ESCAPE)) {
-        stop = true;
-        return;
-    }
-
-    double move_speed { pt_fps_calc.frame_duration_mvg_avg * settings.base_movement_rate };
-    double rot_speed  { pt_fps_calc.frame_duration_mvg_avg *
+void App::updatePlayerFromSdlInput(const double tick_duration) {
+    double move_speed { tick_duration * settings.base_movement_rate };
+    double rot_speed  { tick_duration *
                         settings.base_movement_rate * settings.turn_rate };
 
     // shift key: run
@@ -323,6 +545,26 @@ void App::updateFromSdlInput() {
             raycast_engine.playerTurnRight(rot_speed);
         }
     }
+}
+
+void App::updateFromSdlInput() {
+    // ctrl+c: simulate SIGINT (quit)
+    if ((kbd_input_mgr->isPressed(SDLK_LCTRL) ||
+         kbd_input_mgr->isPressed(SDLK_RCTRL)) &&
+        kbd_input_mgr->isPressed(SDLK_c)) {
+        stop = true;
+        return;
+    }
+
+    // escape key: quit
+    if (kbd_input_mgr->isPressed(SDLK_ESCAPE)) {
+        stop = true;
+        return;
+    }
+
+    // space key: open or close wall ahead
+    if (kbd_input_mgr->keyDownThisFrame(SDLK_SPACE))
+        toggleWallAhead();
 
     // F1 key: toggle FPS overlay
     if (kbd_input_mgr->keyDownThisFrame(SDLK_F1))
@@ -340,5 +582,37 @@ void App::updateFromSdlInput() {
     if (kbd_input_mgr->keyDownThisFrame(SDLK_F4))
         settings.euclidean = !settings.euclidean;
 
+    // F5 key: toggle SIMD ray packet casting
+    if (kbd_input_mgr->keyDownThisFrame(SDLK_F5))
+        settings.ray_packets = !settings.ray_packets;
+
+    // F6 key: toggle reuse of rays cast in previous frame
+    if (kbd_input_mgr->keyDownThisFrame(SDLK_F6))
+        settings.ray_cache = !settings.ray_cache;
+
+    // F7 key: cycle empty space skipping modes
+    if (kbd_input_mgr->keyDownThisFrame(SDLK_F7)) {
+        switch (settings.empty_space_skip) {
+        case EmptySpaceSkip::None:
+            settings.empty_space_skip = EmptySpaceSkip::DistanceField;
+            break;
+        case EmptySpaceSkip::DistanceField:
+            settings.empty_space_skip = EmptySpaceSkip::OccupancyPyramid;
+            break;
+        case EmptySpaceSkip::OccupancyPyramid:
+        default:
+            settings.empty_space_skip = EmptySpaceSkip::None;
+            break;
+        }
+    }
+
+    // F8 key: toggle reduced textures for far walls
+    if (kbd_input_mgr->keyDownThisFrame(SDLK_F8))
+        settings.texture_lod = !settings.texture_lod;
+
+    // F9 key: toggle temporal column interleaving
+    if (kbd_input_mgr->keyDownThisFrame(SDLK_F9))
+        settings.interleave = !settings.interleave;
+
     kbd_input_mgr->decayToAutorepeat();
 }
@@ -1,13 +1,41 @@
 #include "DdaRaycastEngine.hh"
 
+#include "FixedPoint.hh"
+
 #include <cstdint>
-#include <cmath>     // cos, sin, sqrt
+#include <cmath>     // cos, sin, sqrt floor ceil round abs isnan M_PI
+
+#include <algorithm> // min max fill sort
+#include <utility>   // swap
+#include <sstream>   // ostringstream
+#include <stdexcept> // runtime_error
 
 
 void DdaRaycastEngine::fitToWindow(const bool tty_io,
                                    const uint16_t w, const uint16_t h) {
     window_w = w;
     fov_rays.resize(window_w);
+    prev_fov_rays.resize(window_w);
+    reuse_src.resize(window_w);
+    reuse_dist_scale.resize(window_w);
+    reuse_err.assign(window_w, 0);
+    prev_reuse_err.assign(window_w, 0);
+    pvs_nearest_face.resize(window_w);
+    pvs_nearest_dist.resize(window_w);
+    pvs_nearest_hit_along.resize(window_w);
+    invalidateRayCache();
+
+    // x coordinate in the camera plane represented by each screen x
+    //   coordinate, calculated so that the left edge of the camera plane is
+    //   -1.0, center 0.0, and right edge is 1.0
+    column_camera_x.resize(window_w);
+    for (uint16_t x { 0 }; x < window_w; ++x)
+        column_camera_x[x] = (2 * x / double(window_w)) - 1;
+    column_dir_x.resize(window_w);
+    column_dir_y.resize(window_w);
+    column_dist_per_unit_x.resize(window_w);
+    column_dist_per_unit_y.resize(window_w);
+    tables_valid = false;
 
     // widen FOV to match aspect ratio to always render square-looking wall units
     double curr_aspect_ratio { double(w) / h };
@@ -21,38 +49,222 @@ void DdaRaycastEngine::fitToWindow(const bool tty_io,
     double target_vpm_to_curr_vpm_ratio { target_view_plane_mag / curr_view_plane_mag };
     view_plane.x *= target_vpm_to_curr_vpm_ratio;
     view_plane.y *= target_vpm_to_curr_vpm_ratio;
+    view_plane_mag = target_view_plane_mag;
 }
 
-void DdaRaycastEngine::castRay(const uint16_t window_x,
-                               const Settings& settings) {
-    // x coordinate in the camera plane represented by the current
-    //   screen x coordinate, calculated so that the left edge of the
-    //   camera plane is -1.0, center 0.0, and right edge is 1.0
-    double camera_x { 2 * window_x / double(window_w) - 1 };
-    FovRay ray;
+/**
+ * @brief count grid line crossings along one axis that a ray makes before a
+ *   given distance
+ *
+ * @param dist_next_unit - distance to next crossing on axis
+ * @param dist_per_unit  - distance between crossings on axis
+ * @param dist_limit     - distance of first crossing not counted
+ * @param max_ct         - largest count returned
+ */
+// jumps across fewer empty tiles than this cost more than stepping over them
+static constexpr uint8_t MIN_SKIP_RADIUS { 2 };
+
+template <typename ScalarT>
+static inline int32_t crossingsBefore(const ScalarT dist_next_unit,
+                                      const ScalarT dist_per_unit,
+                                      const ScalarT dist_limit,
+                                      const int32_t max_ct) {
+    using std::ceil;
+    if (!(dist_next_unit < dist_limit))
+        return 0;
+    int32_t ct ( static_cast<int32_t>(
+                     ceil((dist_limit - dist_next_unit) / dist_per_unit)) );
+    ct = std::max(1, std::min(ct, max_ct));
+    // correct for rounding in the division, so that the crossings counted are
+    //   exactly those the DDA loop would compare as before dist_limit
+    while (ct > 0 &&
+           !(dist_next_unit + ScalarT(ct - 1) * dist_per_unit < dist_limit))
+        --ct;
+    while (ct < max_ct &&
+           dist_next_unit + ScalarT(ct) * dist_per_unit < dist_limit)
+        ++ct;
+    return ct;
+}
+
+/**
+ * @brief find empty box of tiles around current map tile to jump across
+ *
+ * @param layout           - stage layout
+ * @param empty_space_skip - skipping mode (not None)
+ * @param map_x            - map tile x
+ * @param map_y            - map tile y
+ * @param map_step_x       - -1 or +1
+ * @param map_step_y       - -1 or +1
+ * @param x_inside_ct      - set to grid verticals the ray can cross while
+ *                             staying in the box
+ * @param y_inside_ct      - set to grid horizontals the ray can cross while
+ *                             staying in the box
+ *
+ * @return false if no box worth jumping across
+ */
+template <typename MapCoordT, typename MapStepT>
+static inline bool emptyBox(const Layout& layout,
+                            const EmptySpaceSkip empty_space_skip,
+                            const MapCoordT map_x, const MapCoordT map_y,
+                            const MapStepT map_step_x, const MapStepT map_step_y,
+                            int32_t& x_inside_ct, int32_t& y_inside_ct) {
+    if (empty_space_skip == EmptySpaceSkip::DistanceField) {
+        // square centered on map tile
+        const uint8_t radius { layout.emptyRadius(map_x, map_y) };
+        x_inside_ct = radius;
+        y_inside_ct = radius;
+        return radius >= MIN_SKIP_RADIUS;
+    }
+    // aligned block containing map tile, so only the tiles between map tile
+    //   and the block edge the ray is heading toward
+    const uint8_t block_log2 { layout.emptyBlockLog2(map_x, map_y) };
+    if (block_log2 == 0)
+        return false;
+    const int32_t block_mask { (1 << block_log2) - 1 };
+    const int32_t x_offset ( map_x & block_mask );
+    const int32_t y_offset ( map_y & block_mask );
+    x_inside_ct = (map_step_x > 0) ? block_mask - x_offset : x_offset;
+    y_inside_ct = (map_step_y > 0) ? block_mask - y_offset : y_offset;
+    return x_inside_ct > 0 || y_inside_ct > 0;
+}
+
+/**
+ * @brief advance DDA state across an empty box of tiles around the current map
+ *   tile in one jump, stopping at the last grid line crossing before the ray
+ *   leaves the box, as the DDA loop would have stepped one crossing at a time
+ *
+ * @param x_inside_ct      - grid verticals ray can cross while staying in box
+ * @param y_inside_ct      - grid horizontals ray can cross while staying in box
+ * @param dist_next_unit_x - distance to next grid vertical, updated
+ * @param dist_next_unit_y - distance to next grid horizontal, updated
+ * @param dist_per_unit_x  - distance between grid verticals
+ * @param dist_per_unit_y  - distance between grid horizontals
+ * @param map_x            - map tile x, updated
+ * @param map_y            - map tile y, updated
+ * @param map_step_x       - -1 or +1
+ * @param map_step_y       - -1 or +1
+ */
+template <typename ScalarT, typename MapCoordT, typename MapStepT>
+static inline void skipEmptyBox(const int32_t x_inside_ct,
+                                const int32_t y_inside_ct,
+                                ScalarT& dist_next_unit_x,
+                                ScalarT& dist_next_unit_y,
+                                const ScalarT dist_per_unit_x,
+                                const ScalarT dist_per_unit_y,
+                                MapCoordT& map_x, MapCoordT& map_y,
+                                const MapStepT map_step_x,
+                                const MapStepT map_step_y) {
+    // the next crossing after those inside leaves the box, so the ray exits on
+    //   the axis that gets there first, after making all inside crossings on it
+    //   (crossing counts of 0 are not multiplied, as 0 times an infinite
+    //   dist_per_unit_* of an axis aligned ray is NaN)
+    const ScalarT dist_exit_x { x_inside_ct ? dist_next_unit_x +
+                                ScalarT(x_inside_ct) * dist_per_unit_x :
+                                dist_next_unit_x };
+    const ScalarT dist_exit_y { y_inside_ct ? dist_next_unit_y +
+                                ScalarT(y_inside_ct) * dist_per_unit_y :
+                                dist_next_unit_y };
+    int32_t x_ct { x_inside_ct };
+    int32_t y_ct { y_inside_ct };
+    // (ties, including Fixed16_16 saturating on both axes, need both counted)
+    if (!(dist_exit_y < dist_exit_x)) {
+        y_ct = crossingsBefore(dist_next_unit_y, dist_per_unit_y,
+                               dist_exit_x, y_inside_ct);
+    }
+    if (!(dist_exit_x < dist_exit_y)) {
+        x_ct = crossingsBefore(dist_next_unit_x, dist_per_unit_x,
+                               dist_exit_y, x_inside_ct);
+    }
+    if (x_ct > 0)
+        dist_next_unit_x += ScalarT(x_ct) * dist_per_unit_x;
+    if (y_ct > 0)
+        dist_next_unit_y += ScalarT(y_ct) * dist_per_unit_y;
+    map_x += x_ct * map_step_x;
+    map_y += y_ct * map_step_y;
+}
+
+/**
+ * @brief convert distance per grid unit from column tables to scalar type
+ *
+ * @param dist_per_unit - distance, possibly infinite
+ */
+template <typename ScalarT>
+static inline ScalarT distPerUnitAs(const double dist_per_unit) {
+    // IEEE 754 floating point values in C++ protect against division by 0,
+    //   but Fixed16_16 has no infinity, so is capped by ScalarTraits so that
+    //   later additions cannot overflow
+    return ScalarT(std::min(dist_per_unit,
+                            double(ScalarTraits<ScalarT>::MAX_DIST_PER_UNIT)));
+}
+
+/**
+ * @brief convert draw distance to scalar type
+ *
+ * @param draw_dist - Settings::draw_dist (when bounded)
+ */
+template <typename ScalarT>
+static inline ScalarT drawDistAs(const double draw_dist) {
+    // (Fixed16_16 distances cannot exceed MAX_DIST_PER_UNIT regardless)
+    return ScalarT(std::min(draw_dist,
+                            double(ScalarTraits<ScalarT>::MAX_DIST_PER_UNIT)));
+}
+
+void DdaRaycastEngine::updateColumnTables() {
+    for (uint16_t x { 0 }; x < window_w; ++x) {
+        // multiply camera_plane vector by scalar x, then add to direction
+        //   vector to get ray direction
+        const double dir_x { player_dir.x + (view_plane.x * column_camera_x[x]) };
+        const double dir_y { player_dir.y + (view_plane.y * column_camera_x[x]) };
+        column_dir_x[x] = dir_x;
+        column_dir_y[x] = dir_y;
+        // IEEE 754 division by 0 gives infinity
+        column_dist_per_unit_x[x] = std::abs(1 / dir_x);
+        column_dist_per_unit_y[x] = std::abs(1 / dir_y);
+    }
+    tables_player_dir = player_dir;
+    tables_view_plane = view_plane;
+    tables_valid = true;
+}
+
+template <typename ScalarT>
+uint32_t DdaRaycastEngine::castRayAs(const uint16_t window_x,
+                                     const Settings& settings) {
+    // std:: versions for floating point types, Fixed16_16 versions found by ADL
+    using std::abs;
+    using std::floor;
+    using std::min;
+
+    // player position converted once to scalar type, relative to the cast
+    //   origin; all further ray math happens in ScalarT
+    const Vector2d origin { castOrigin(player_pos, settings) };
+    const Vector2<ScalarT> pos { ScalarT(player_pos.x - origin.x),
+                                 ScalarT(player_pos.y - origin.y) };
 
     // ray origin is player_pos
-    // multiply camera_plane vector by scalar x, then add to direction vector
-    //   to get ray direction
-    ray.dir = player_dir + (view_plane * camera_x);
+    // ray direction is player_dir + view_plane * camera_x, kept per column in
+    //   column_dir_* (see updateColumnTables)
+    const Vector2<ScalarT> dir { ScalarT(column_dir_x[window_x]),
+                                 ScalarT(column_dir_y[window_x]) };
 
     // current map grid coordinates of ray
-    uint16_t map_x ( player_pos.x );
-    uint16_t map_y ( player_pos.y );
+    int32_t map_x ( player_pos.x );
+    int32_t map_y ( player_pos.y );
 
     // Initially the distances from the ray origin (player position) to its
     //   first intersections with a map unit grid vertical and horizonal,
     //   respectively. These map grid lines, or integer values of x and y,
     //   serve to represent wall boundaries when they border a grid square
     //   designated as a wall.
-    double dist_next_unit_x;
-    double dist_next_unit_y;
+    ScalarT dist_next_unit_x;
+    ScalarT dist_next_unit_y;
 
     // distances the ray has to travel to go from one unit grid vertical
-    //   to the next, or one horizontal to the next, respectively
-    // IEEE 754 floating point values in C++ protect against division by 0
-    double dist_per_unit_x { std::abs(1 / ray.dir.x) };
-    double dist_per_unit_y { std::abs(1 / ray.dir.y) };
+    //   to the next, or one horizontal to the next, respectively, or
+    //   |1 / dir.x| and |1 / dir.y| (see updateColumnTables)
+    ScalarT dist_per_unit_x {
+        distPerUnitAs<ScalarT>(column_dist_per_unit_x[window_x]) };
+    ScalarT dist_per_unit_y {
+        distPerUnitAs<ScalarT>(column_dist_per_unit_y[window_x]) };
 
     // DDA algorithm will always jump exactly one map grid square each
     //   loop, either in the x or y. These vars record those increments,
@@ -61,25 +273,56 @@ void DdaRaycastEngine::castRay(const uint16_t window_x,
     int8_t map_step_y;
 
     // setup map grid step and initial ray distance to next grid unit values
-    if (ray.dir.x < 0) {
+    if (dir.x < ScalarT(0)) {
         map_step_x = -1;
-        dist_next_unit_x = (player_pos.x - map_x) * dist_per_unit_x;
+        dist_next_unit_x = (pos.x - ScalarT(map_x - origin.x)) * dist_per_unit_x;
     } else {
         map_step_x = 1;
-        dist_next_unit_x = (map_x + 1.0 - player_pos.x) * dist_per_unit_x;
+        dist_next_unit_x = (ScalarT(map_x + 1 - origin.x) - pos.x) * dist_per_unit_x;
     }
-    if (ray.dir.y < 0) {
+    if (dir.y < ScalarT(0)) {
         map_step_y = -1;
-        dist_next_unit_y = (player_pos.y - map_y) * dist_per_unit_y;
+        dist_next_unit_y = (pos.y - ScalarT(map_y - origin.y)) * dist_per_unit_y;
     } else {
         map_step_y = 1;
-        dist_next_unit_y = (map_y + 1.0 - player_pos.y) * dist_per_unit_y;
+        dist_next_unit_y = (ScalarT(map_y + 1 - origin.y) - pos.y) * dist_per_unit_y;
     }
 
     // perform DDA algo, or the incremental casting of the ray
     // moves to a new map unit square every loop, as directed by map_step values
-    WallOrientation alignment;
+    //   (after first jumping across any empty space around the current square,
+    //   if enabled)
+    // (initialized only for the case of player_pos inside a wall)
+    WallOrientation alignment { WallOrientation::EW };
+    const bool skip_empty { settings.empty_space_skip != EmptySpaceSkip::None };
+    // the next grid line crossing is at the perpendicular distance of any wall
+    //   hit there, so the ray can stop once that is past the draw distance
+    const bool bounded { settings.draw_dist > 0 };
+    const ScalarT draw_dist { drawDistAs<ScalarT>(settings.draw_dist) };
+    FovRay ray;
+    ray.dir = Vector2d { double(dir.x), double(dir.y) };
+    uint32_t step_ct { 0 };
     while (!layout.tileIsWall(map_x, map_y)) {
+        ++step_ct;
+        int32_t x_inside_ct;
+        int32_t y_inside_ct;
+        if (skip_empty &&
+            emptyBox(layout, settings.empty_space_skip, map_x, map_y,
+                     map_step_x, map_step_y, x_inside_ct, y_inside_ct)) {
+            skipEmptyBox(x_inside_ct, y_inside_ct,
+                         dist_next_unit_x, dist_next_unit_y,
+                         dist_per_unit_x, dist_per_unit_y,
+                         map_x, map_y, map_step_x, map_step_y);
+        }
+        if (bounded && min(dist_next_unit_x, dist_next_unit_y) > draw_dist) {
+            ray.wall_hit.algnmt = WallOrientation::EW;
+            ray.wall_hit.tex_key = FovRayBuffer::NO_HIT_TEX_KEY;
+            ray.wall_hit.dist = settings.draw_dist;
+            ray.wall_hit.x = 0;
+            ray.wall_hit.light = Layout::LIGHT_LEVEL_ONE;
+            fov_rays.store(window_x, ray);
+            return step_ct;
+        }
         if (dist_next_unit_x < dist_next_unit_y) {
             dist_next_unit_x += dist_per_unit_x;
             map_x += map_step_x;
@@ -93,6 +336,8 @@ void DdaRaycastEngine::castRay(const uint16_t window_x,
 
     ray.wall_hit.algnmt = alignment;
     ray.wall_hit.tex_key = layout.tile(map_x, map_y);
+    ray.wall_hit.light = hitLight(map_x, map_y, alignment == WallOrientation::NS,
+                                  map_step_x, map_step_y, step_ct > 0);
 
     // Calculate distance to wall hit from camera plane, moving
     //   perpendicular to the camera plane. If the actual length of the
@@ -109,31 +354,1424 @@ void DdaRaycastEngine::castRay(const uint16_t window_x,
     //   camera plane distance. It is only ncessary to subtract dist_per_unit_*
     //   once, or go one step back in the casting, as the DDA loop above ends
     //   once inside a wall.
+    ScalarT dist;
     if (settings.euclidean) {  // actual ray distance from player_pos
-        ray.wall_hit.dist = (ray.wall_hit.algnmt == WallOrientation::NS) ?
+        dist = (alignment == WallOrientation::NS) ?
             dist_next_unit_x : dist_next_unit_y;
     } else {                   // perpendicular distance from camera plane
-        ray.wall_hit.dist = (ray.wall_hit.algnmt == WallOrientation::NS) ?
+        dist = (alignment == WallOrientation::NS) ?
             dist_next_unit_x - dist_per_unit_x :
             dist_next_unit_y - dist_per_unit_y;
     }
+    ray.wall_hit.dist = double(dist);
 
     // Translate coordinate vector of ray's wall hit (in map view, from "above")
     //   into x coordinate in wall segment as seen from the perspective of a
     //   player facing the wall.
-    ray.wall_hit.x = (ray.wall_hit.algnmt == WallOrientation::EW) ?
-            player_pos.x + (ray.wall_hit.dist * ray.dir.x) :
-            player_pos.y + (ray.wall_hit.dist * ray.dir.y);
+    ScalarT wall_x { (alignment == WallOrientation::EW) ?
+                     pos.x + (dist * dir.x) :
+                     pos.y + (dist * dir.y) };
     // Expressed as fraction of 1 grid unit (0.0 on the left)
-    ray.wall_hit.x -= std::floor(ray.wall_hit.x);
+    wall_x -= floor(wall_x);
+    ray.wall_hit.x = double(wall_x);
+
+    fov_rays.store(window_x, ray);
+    return step_ct;
+}
+
+// Same algorithm as castRayAs (see there for a full explanation), but with each
+//   variable held per lane in a fixed size array. Lane loops are written
+//   without branches, so that the compiler can vectorize them for the target
+//   (SSE2/AVX2/NEON); lanes that have already hit a wall are masked out of
+//   further steps, and the packet is done once every lane has hit. Wall
+//   lookups for all lanes are made together by Layout::tilesAreWall, which
+//   checks the storage once per step rather than per lane, leaving branch-free
+//   indexed loads. These are not vectorized as yet: AVX2 has no byte gather
+//   for row-major maps, and GCC 12 does not gather the 64-bit words of tiled
+//   bitmaps either, so each lane still loads on its own.
+template <typename ScalarT>
+uint32_t DdaRaycastEngine::castRayPacketAs(const uint16_t first_window_x,
+                                           const uint16_t column_step,
+                                           const Settings& settings) {
+    using std::abs;
+    using std::floor;
+    using std::min;
+
+    constexpr uint16_t N { rayPacketSize<ScalarT>() };
+    ScalarT dir_x[N];
+    ScalarT dir_y[N];
+    ScalarT dist_per_unit_x[N];
+    ScalarT dist_per_unit_y[N];
+    ScalarT dist_next_unit_x[N];
+    ScalarT dist_next_unit_y[N];
+    int32_t map_x[N];
+    int32_t map_y[N];
+    int32_t map_step_x[N];
+    int32_t map_step_y[N];
+    // lane masks
+    bool    done[N];
+    bool    hit_ns[N];
+    bool    no_hit[N];
+
+    const Vector2d origin { castOrigin(player_pos, settings) };
+    const Vector2<ScalarT> pos { ScalarT(player_pos.x - origin.x),
+                                 ScalarT(player_pos.y - origin.y) };
+    // all rays in packet begin in the player's map tile
+    const int32_t start_map_x ( player_pos.x );
+    const int32_t start_map_y ( player_pos.y );
+    const ScalarT start_tile_x ( start_map_x - origin.x );
+    const ScalarT start_tile_y ( start_map_y - origin.y );
+    for (uint16_t l { 0 }; l < N; ++l) {
+        const uint16_t window_x ( first_window_x + (l * column_step) );
+        dir_x[l] = ScalarT(column_dir_x[window_x]);
+        dir_y[l] = ScalarT(column_dir_y[window_x]);
+        dist_per_unit_x[l] =
+            distPerUnitAs<ScalarT>(column_dist_per_unit_x[window_x]);
+        dist_per_unit_y[l] =
+            distPerUnitAs<ScalarT>(column_dist_per_unit_y[window_x]);
+        map_x[l] = start_map_x;
+        map_y[l] = start_map_y;
+        map_step_x[l] = (dir_x[l] < ScalarT(0)) ? -1 : 1;
+        map_step_y[l] = (dir_y[l] < ScalarT(0)) ? -1 : 1;
+        dist_next_unit_x[l] = ((dir_x[l] < ScalarT(0)) ?
+                               pos.x - start_tile_x :
+                               start_tile_x + ScalarT(1) - pos.x) * dist_per_unit_x[l];
+        dist_next_unit_y[l] = ((dir_y[l] < ScalarT(0)) ?
+                               pos.y - start_tile_y :
+                               start_tile_y + ScalarT(1) - pos.y) * dist_per_unit_y[l];
+        done[l] = false;
+        hit_ns[l] = false;
+        no_hit[l] = false;
+    }
 
-    fov_rays[window_x] = ray;
+    // packet DDA loop
+    const bool skip_empty { settings.empty_space_skip != EmptySpaceSkip::None };
+    const bool bounded { settings.draw_dist > 0 };
+    const ScalarT draw_dist { drawDistAs<ScalarT>(settings.draw_dist) };
+    uint32_t step_ct { 0 };
+    while (true) {
+        // gathered wall lookups, one per lane (lanes already done still
+        //   index the wall tile they stopped in, or a tile short of
+        //   draw_dist, so every load is in the map)
+        bool is_wall[N];
+        layout.tilesAreWall<N>(map_x, map_y, is_wall);
+        bool all_done { true };
+        for (uint16_t l { 0 }; l < N; ++l) {
+            done[l] = done[l] | is_wall[l];
+            all_done = all_done && done[l];
+            step_ct += !done[l];
+        }
+        if (all_done)
+            break;
+        // jumps vary in length per lane, so are not vectorized
+        if (skip_empty) {
+            for (uint16_t l { 0 }; l < N; ++l) {
+                int32_t x_inside_ct;
+                int32_t y_inside_ct;
+                if (done[l] ||
+                    !emptyBox(layout, settings.empty_space_skip,
+                              map_x[l], map_y[l], map_step_x[l], map_step_y[l],
+                              x_inside_ct, y_inside_ct)) {
+                    continue;
+                }
+                skipEmptyBox(x_inside_ct, y_inside_ct,
+                             dist_next_unit_x[l], dist_next_unit_y[l],
+                             dist_per_unit_x[l], dist_per_unit_y[l],
+                             map_x[l], map_y[l], map_step_x[l], map_step_y[l]);
+            }
+        }
+        for (uint16_t l { 0 }; l < N; ++l) {
+            // lanes past the draw distance stop without a hit
+            no_hit[l] = no_hit[l] || (bounded && !done[l] &&
+                min(dist_next_unit_x[l], dist_next_unit_y[l]) > draw_dist);
+            done[l] = done[l] || no_hit[l];
+            const bool step_x { !done[l] &&
+                                dist_next_unit_x[l] < dist_next_unit_y[l] };
+            const bool step_y { !done[l] && !step_x };
+            // selects rather than multiplying by masks, as dist_per_unit_*
+            //   may be infinite
+            dist_next_unit_x[l] = step_x ?
+                dist_next_unit_x[l] + dist_per_unit_x[l] : dist_next_unit_x[l];
+            dist_next_unit_y[l] = step_y ?
+                dist_next_unit_y[l] + dist_per_unit_y[l] : dist_next_unit_y[l];
+            map_x[l] += step_x ? map_step_x[l] : 0;
+            map_y[l] += step_y ? map_step_y[l] : 0;
+            hit_ns[l] = step_x || (hit_ns[l] && !step_y);
+        }
+    }
+
+    // lanes written straight to their columns in each of the fov_rays arrays
+    //   (strided when column_step is above 1)
+    float*           out_dist    { fov_rays.dist.data() + first_window_x };
+    uint8_t*         out_tex_key { fov_rays.tex_key.data() + first_window_x };
+    float*           out_hit_x   { fov_rays.hit_x.data() + first_window_x };
+    WallOrientation* out_algnmt  { fov_rays.algnmt.data() + first_window_x };
+    uint8_t*         out_light   { fov_rays.light.data() + first_window_x };
+    float*           out_dir_x   { fov_rays.dir_x.data() + first_window_x };
+    float*           out_dir_y   { fov_rays.dir_y.data() + first_window_x };
+    const ScalarT    zero        { 0 };
+    for (uint16_t l { 0 }; l < N; ++l) {
+        // euclidean mode omits stepping back out of the wall
+        const ScalarT dist { hit_ns[l] ?
+            dist_next_unit_x[l] - (settings.euclidean ? zero : dist_per_unit_x[l]) :
+            dist_next_unit_y[l] - (settings.euclidean ? zero : dist_per_unit_y[l]) };
+        ScalarT hit_x { hit_ns[l] ?
+            pos.y + (dist * dir_y[l]) :
+            pos.x + (dist * dir_x[l]) };
+        hit_x -= floor(hit_x);
+        // (map tile of no_hit lanes is empty, but still valid)
+        out_dist[l * column_step] = no_hit[l] ? float(settings.draw_dist) : float(dist);
+        out_tex_key[l * column_step] = no_hit[l] ? FovRayBuffer::NO_HIT_TEX_KEY :
+            layout.tile(map_x[l], map_y[l]);
+        out_hit_x[l * column_step] = no_hit[l] ? 0 : FovRayBuffer::narrowHitX(double(hit_x));
+        out_algnmt[l * column_step] = (hit_ns[l] && !no_hit[l]) ?
+            WallOrientation::NS : WallOrientation::EW;
+        out_light[l * column_step] = no_hit[l] ? Layout::LIGHT_LEVEL_ONE :
+            hitLight(map_x[l], map_y[l], hit_ns[l], map_step_x[l], map_step_y[l],
+                     map_x[l] != start_map_x || map_y[l] != start_map_y);
+        out_dir_x[l * column_step] = float(dir_x[l]);
+        out_dir_y[l * column_step] = float(dir_y[l]);
+    }
+    return step_ct;
 }
 
-void DdaRaycastEngine::castRays(const Settings& settings) {
-    for (uint16_t window_x { 0 }; window_x < window_w; ++window_x) {
-        castRay(window_x, settings);
+template <typename ScalarT>
+void DdaRaycastEngine::castRaysAs(const uint16_t begin_x, const uint16_t end_x,
+                                  const Settings& settings) {
+    if (pvs_frame) {
+        frame_step_ct += castPvsFacesAs<ScalarT>(begin_x, end_x, settings);
+        std::fill(reuse_err.begin() + begin_x, reuse_err.begin() + end_x, 0);
+        frame_miss_ct += end_x - begin_x;
+        return;
     }
+    // wall spans need every column cast, with perpendicular distances
+    if (settings.wall_spans && ray_cache_mode == RayCacheMode::Disabled &&
+        settings.column_scale == 1 && !settings.euclidean) {
+        frame_step_ct += castWallSpansAs<ScalarT>(begin_x, end_x, settings);
+        std::fill(reuse_err.begin() + begin_x, reuse_err.begin() + end_x, 0);
+        frame_miss_ct += end_x - begin_x;
+        return;
+    }
+    constexpr uint16_t packet_sz { rayPacketSize<ScalarT>() };
+    const bool reproject { ray_cache_mode == RayCacheMode::Reproject };
+    const bool interleave { ray_cache_mode == RayCacheMode::Interleave };
+    // (column_scale is always 1 when interleaving)
+    const uint16_t column_step ( interleave ? 2 : settings.column_scale );
+    // columns spanned by one packet
+    const uint16_t packet_w ( packet_sz * column_step );
+    // columns filled, whether cast or reused
+    uint32_t column_ct { 0 };
+    uint32_t hit_ct { 0 };
+    uint64_t step_ct { 0 };
+    // first column in range to cast: next with the frame's parity when
+    //   interleaving, or next multiple of column_step
+    uint16_t window_x ( interleave ?
+                        begin_x + ((begin_x & 1) != interleave_parity) :
+                        ((begin_x + column_step - 1) / column_step) * column_step );
+    if (settings.ray_packets) {
+        for (; window_x + packet_w - column_step < end_x; window_x += packet_w) {
+            // packets are only worth skipping when no lane needs casting
+            //   (column_step is always 1 when reprojecting)
+            if (reproject && raysReusable(window_x, window_x + packet_sz)) {
+                for (uint16_t l { 0 }; l < packet_sz; ++l)
+                    reuseRay(window_x + l);
+                hit_ct += packet_sz;
+            } else {
+                step_ct += castRayPacketAs<ScalarT>(window_x, column_step,
+                                                    settings);
+                for (uint16_t l { 0 }; l < packet_sz; ++l)
+                    reuse_err[window_x + (l * column_step)] = 0;
+            }
+            column_ct += packet_sz;
+        }
+    }
+    // scalar fallback, also used for remainder of range too narrow for a packet
+    for (; window_x < end_x; window_x += column_step) {
+        if (reproject && reuseRay(window_x)) {
+            ++hit_ct;
+        } else {
+            step_ct += castRayAs<ScalarT>(window_x, settings);
+            reuse_err[window_x] = 0;
+        }
+        ++column_ct;
+    }
+    // fill columns of the other parity, now that their neighbors are cast
+    //   (those at range edges have a neighbor in another thread's range, so
+    //   are cast)
+    if (interleave) {
+        for (window_x = begin_x + ((begin_x & 1) == interleave_parity);
+             window_x < end_x; window_x += 2) {
+            if (window_x > begin_x && window_x + 1 < end_x &&
+                reprojectPrevHit(window_x, settings)) {
+                ++hit_ct;
+            } else {
+                step_ct += castRayAs<ScalarT>(window_x, settings);
+            }
+            reuse_err[window_x] = 0;
+            ++column_ct;
+        }
+    }
+    frame_hit_ct += hit_ct;
+    frame_miss_ct += column_ct - hit_ct;
+    frame_step_ct += step_ct;
+}
+
+uint32_t DdaRaycastEngine::castSegmentRay(const uint16_t window_x,
+                                          const Settings& settings) {
+    const double dir_x { column_dir_x[window_x] };
+    const double dir_y { column_dir_y[window_x] };
+    const double dist_per_unit_x { column_dist_per_unit_x[window_x] };
+    const double dist_per_unit_y { column_dist_per_unit_y[window_x] };
+
+    // tiles are stepped through exactly as in castRayAs, with distances
+    //   along the ray in units of its direction, so perpendicular distances
+    //   from the camera plane
+    uint32_t map_x ( player_pos.x );
+    uint32_t map_y ( player_pos.y );
+    int8_t map_step_x;
+    int8_t map_step_y;
+    double dist_next_unit_x;
+    double dist_next_unit_y;
+    if (dir_x < 0) {
+        map_step_x = -1;
+        dist_next_unit_x = (player_pos.x - map_x) * dist_per_unit_x;
+    } else {
+        map_step_x = 1;
+        dist_next_unit_x = (map_x + 1 - player_pos.x) * dist_per_unit_x;
+    }
+    if (dir_y < 0) {
+        map_step_y = -1;
+        dist_next_unit_y = (player_pos.y - map_y) * dist_per_unit_y;
+    } else {
+        map_step_y = 1;
+        dist_next_unit_y = (map_y + 1 - player_pos.y) * dist_per_unit_y;
+    }
+
+    // last tile crossed that no segment passes through the interior of,
+    //   which lights any hit
+    uint32_t lit_x { map_x };
+    uint32_t lit_y { map_y };
+    // nearest hit so far: segment, distance, and fraction along segment
+    const WallSegment* hit_segment { nullptr };
+    double hit_dist { std::numeric_limits<double>::infinity() };
+    double hit_along { 0 };
+    const bool bounded { settings.draw_dist > 0 };
+    uint32_t step_ct { 0 };
+    // segments closing the map stop every ray before it leaves the map (the
+    //   bounds check only catches rays slipping through their corners)
+    while (map_x < layout.w && map_y < layout.h) {
+        ++step_ct;
+        if (!layout.tileIsWall(map_x, map_y)) {
+            lit_x = map_x;
+            lit_y = map_y;
+        }
+        for (const WallSegment* segment { layout.segmentsBegin(map_x, map_y) };
+             segment != layout.segmentsEnd(map_x, map_y); ++segment) {
+            // solve player_pos + dist * dir = segment start + along *
+            //   (segment end - segment start) by 2D cross products
+            const double seg_x { segment->x1 - segment->x0 };
+            const double seg_y { segment->y1 - segment->y0 };
+            const double denom { (dir_x * seg_y) - (dir_y * seg_x) };
+            // parallel to ray
+            if (denom == 0)
+                continue;
+            const double offset_x { segment->x0 - player_pos.x };
+            const double offset_y { segment->y0 - player_pos.y };
+            const double dist { ((offset_x * seg_y) - (offset_y * seg_x)) / denom };
+            const double along { ((offset_x * dir_y) - (offset_y * dir_x)) / denom };
+            if (dist > 0 && dist < hit_dist &&
+                along >= -SEGMENT_END_MARGIN && along <= 1 + SEGMENT_END_MARGIN) {
+                hit_segment = segment;
+                hit_dist = dist;
+                hit_along = along;
+            }
+        }
+        // Any segment hit before the ray leaves this tile passes within it, so
+        //   is listed in it: later tiles can hold no nearer hit.
+        const double exit_dist { std::min(dist_next_unit_x, dist_next_unit_y) };
+        if (hit_dist <= exit_dist || (bounded && exit_dist > settings.draw_dist))
+            break;
+        if (dist_next_unit_x < dist_next_unit_y) {
+            dist_next_unit_x += dist_per_unit_x;
+            map_x += map_step_x;
+        } else {
+            dist_next_unit_y += dist_per_unit_y;
+            map_y += map_step_y;
+        }
+    }
+
+    FovRay ray;
+    ray.dir = Vector2d { dir_x, dir_y };
+    if (hit_segment == nullptr || (bounded && hit_dist > settings.draw_dist)) {
+        ray.wall_hit.algnmt = WallOrientation::EW;
+        ray.wall_hit.tex_key = FovRayBuffer::NO_HIT_TEX_KEY;
+        ray.wall_hit.dist = bounded ? settings.draw_dist :
+            std::min(dist_next_unit_x, dist_next_unit_y);
+        ray.wall_hit.x = 0;
+        ray.wall_hit.light = Layout::LIGHT_LEVEL_ONE;
+        fov_rays.store(window_x, ray);
+        return step_ct;
+    }
+    const double seg_x { hit_segment->x1 - hit_segment->x0 };
+    const double seg_y { hit_segment->y1 - hit_segment->y0 };
+    // shaded as the tile face closest in direction
+    ray.wall_hit.algnmt = (std::abs(seg_x) < std::abs(seg_y)) ?
+        WallOrientation::NS : WallOrientation::EW;
+    ray.wall_hit.tex_key = hit_segment->tex_key;
+    ray.wall_hit.light = layout.tileLight(lit_x, lit_y);
+    // actual ray distance from player_pos, as dir is not a unit vector
+    ray.wall_hit.dist = settings.euclidean ?
+        hit_dist * std::sqrt((dir_x * dir_x) + (dir_y * dir_y)) : hit_dist;
+    // texture repeats every map unit along segment
+    const double wall_x { std::max(0.0, hit_along) *
+                          std::sqrt((seg_x * seg_x) + (seg_y * seg_y)) };
+    ray.wall_hit.x = wall_x - std::floor(wall_x);
+    fov_rays.store(window_x, ray);
+    return step_ct;
+}
+
+void DdaRaycastEngine::castSegmentRays(const uint16_t begin_x,
+                                       const uint16_t end_x,
+                                       const Settings& settings) {
+    const uint16_t column_step { settings.column_scale };
+    uint32_t column_ct { 0 };
+    uint64_t step_ct { 0 };
+    for (uint16_t window_x ( ((begin_x + column_step - 1) / column_step) *
+                             column_step );
+         window_x < end_x; window_x += column_step) {
+        step_ct += castSegmentRay(window_x, settings);
+        ++column_ct;
+    }
+    frame_miss_ct += column_ct;
+    frame_step_ct += step_ct;
+}
+
+void DdaRaycastEngine::castRay(const uint16_t window_x,
+                               const Settings& settings) {
+    if (layout.hasSegments()) {
+        castSegmentRay(window_x, settings);
+        return;
+    }
+    switch (settings.scalar_type) {
+    case ScalarType::Float:
+        castRayAs<float>(window_x, settings);
+        break;
+    case ScalarType::Fixed16_16:
+        castRayAs<Fixed16_16>(window_x, settings);
+        break;
+    case ScalarType::Double:
+    default:
+        castRayAs<double>(window_x, settings);
+        break;
+    }
+}
+
+void RayQueryBuffer::setRay(const uint32_t i, const Vector2d& origin,
+                            const Vector2d& dir, const double _max_dist) {
+    const double dir_mag { std::sqrt((dir.x * dir.x) + (dir.y * dir.y)) };
+    origin_x[i] = origin.x;
+    origin_y[i] = origin.y;
+    dir_x[i] = dir.x / dir_mag;
+    dir_y[i] = dir.y / dir_mag;
+    max_dist[i] = _max_dist;
+}
+
+void RayQueryBuffer::setSightLine(const uint32_t i, const Vector2d& a,
+                                  const Vector2d& b) {
+    const Vector2d a_to_b { b.x - a.x, b.y - a.y };
+    const double dist { std::sqrt((a_to_b.x * a_to_b.x) + (a_to_b.y * a_to_b.y)) };
+    // coincident points need only the wall test of their own tile, which
+    //   happens in any direction
+    setRay(i, a, (dist > 0) ? a_to_b : Vector2d { 1, 0 }, dist);
+}
+
+// Same algorithm as castRayAs (see there for a full explanation), but from the
+//   query's own origin, stopping at its own max_dist; distances are along the
+//   ray rather than from a camera plane, as dir is a unit vector.
+template <typename ScalarT>
+void DdaRaycastEngine::castRayQueryAs(RayQueryBuffer& rays, const uint32_t i,
+                                      const Settings& settings) const {
+    using std::min;
+
+    const Vector2d origin_pos { rays.origin_x[i], rays.origin_y[i] };
+    const Vector2d origin { castOrigin(origin_pos, settings) };
+    const Vector2<ScalarT> pos { ScalarT(origin_pos.x - origin.x),
+                                 ScalarT(origin_pos.y - origin.y) };
+    const double dir_x { rays.dir_x[i] };
+    const double dir_y { rays.dir_y[i] };
+    // IEEE 754 division by 0 gives infinity
+    const ScalarT dist_per_unit_x { distPerUnitAs<ScalarT>(std::abs(1 / dir_x)) };
+    const ScalarT dist_per_unit_y { distPerUnitAs<ScalarT>(std::abs(1 / dir_y)) };
+    const ScalarT max_dist { drawDistAs<ScalarT>(rays.max_dist[i]) };
+    int32_t map_x ( origin_pos.x );
+    int32_t map_y ( origin_pos.y );
+    const int8_t map_step_x ( (dir_x < 0) ? -1 : 1 );
+    const int8_t map_step_y ( (dir_y < 0) ? -1 : 1 );
+    ScalarT dist_next_unit_x { ((dir_x < 0) ?
+                                pos.x - ScalarT(map_x - origin.x) :
+                                ScalarT(map_x + 1 - origin.x) - pos.x) * dist_per_unit_x };
+    ScalarT dist_next_unit_y { ((dir_y < 0) ?
+                                pos.y - ScalarT(map_y - origin.y) :
+                                ScalarT(map_y + 1 - origin.y) - pos.y) * dist_per_unit_y };
+
+    // (initialized only for the case of origin inside a wall)
+    WallOrientation alignment { WallOrientation::EW };
+    const bool skip_empty { settings.empty_space_skip != EmptySpaceSkip::None };
+    bool no_hit { false };
+    while (!layout.tileIsWall(map_x, map_y)) {
+        int32_t x_inside_ct;
+        int32_t y_inside_ct;
+        if (skip_empty &&
+            emptyBox(layout, settings.empty_space_skip, map_x, map_y,
+                     map_step_x, map_step_y, x_inside_ct, y_inside_ct)) {
+            skipEmptyBox(x_inside_ct, y_inside_ct,
+                         dist_next_unit_x, dist_next_unit_y,
+                         dist_per_unit_x, dist_per_unit_y,
+                         map_x, map_y, map_step_x, map_step_y);
+        }
+        if (min(dist_next_unit_x, dist_next_unit_y) > max_dist) {
+            no_hit = true;
+            break;
+        }
+        if (dist_next_unit_x < dist_next_unit_y) {
+            dist_next_unit_x += dist_per_unit_x;
+            map_x += map_step_x;
+            alignment = WallOrientation::NS;
+        } else {
+            dist_next_unit_y += dist_per_unit_y;
+            map_y += map_step_y;
+            alignment = WallOrientation::EW;
+        }
+    }
+
+    // origins inside a wall took no steps, so stepping back gives a negative
+    //   (or NaN, if axis aligned) distance
+    const ScalarT dist { (alignment == WallOrientation::NS) ?
+                         dist_next_unit_x - dist_per_unit_x :
+                         dist_next_unit_y - dist_per_unit_y };
+    rays.dist[i] = no_hit ? float(rays.max_dist[i]) :
+        ((dist > ScalarT(0)) ? float(dist) : 0.0f);
+    rays.map_x[i] = map_x;
+    rays.map_y[i] = map_y;
+    rays.tex_key[i] = no_hit ? RayQueryBuffer::NO_HIT_TEX_KEY :
+        layout.tile(map_x, map_y);
+    // rays stepping +x enter a tile through its W side, and so on
+    rays.side[i] = (alignment == WallOrientation::NS) ?
+        ((map_step_x > 0) ? TileSide::W : TileSide::E) :
+        ((map_step_y > 0) ? TileSide::S : TileSide::N);
+}
+
+// Same algorithm as castRayPacketAs, but with each lane casting its own
+//   queries, stopping at their own max_dist; distances are along the ray
+//   rather than from a camera plane, as dir is a unit vector. Queries from
+//   different origins in different directions take very different step
+//   counts, so rather than waiting for the longest ray of a packet, each lane
+//   stores its hit and loads the next query in the range as soon as it is
+//   done, keeping the lanes full until the range runs out.
+template <typename ScalarT>
+void DdaRaycastEngine::castRayQueryPacketsAs(RayQueryBuffer& rays,
+                                             const uint32_t begin_i,
+                                             const uint32_t end_i,
+                                             const Settings& settings) const {
+    using std::min;
+
+    constexpr uint16_t N { rayPacketSize<ScalarT>() };
+    ScalarT dist_per_unit_x[N];
+    ScalarT dist_per_unit_y[N];
+    ScalarT dist_next_unit_x[N];
+    ScalarT dist_next_unit_y[N];
+    ScalarT max_dist[N];
+    int32_t map_x[N];
+    int32_t map_y[N];
+    int32_t map_step_x[N];
+    int32_t map_step_y[N];
+    // query cast by each lane
+    uint32_t query_i[N];
+    // lane masks
+    bool    active[N];
+    bool    hit_wall[N];
+    bool    hit_ns[N];
+    bool    no_hit[N];
+
+    const auto loadQuery { [&](const uint16_t l, const uint32_t i) {
+        const Vector2d origin_pos { rays.origin_x[i], rays.origin_y[i] };
+        const Vector2d origin { castOrigin(origin_pos, settings) };
+        const Vector2<ScalarT> pos { ScalarT(origin_pos.x - origin.x),
+                                     ScalarT(origin_pos.y - origin.y) };
+        const double dir_x { rays.dir_x[i] };
+        const double dir_y { rays.dir_y[i] };
+        // IEEE 754 division by 0 gives infinity
+        dist_per_unit_x[l] = distPerUnitAs<ScalarT>(std::abs(1 / dir_x));
+        dist_per_unit_y[l] = distPerUnitAs<ScalarT>(std::abs(1 / dir_y));
+        max_dist[l] = drawDistAs<ScalarT>(rays.max_dist[i]);
+        map_x[l] = static_cast<int32_t>(origin_pos.x);
+        map_y[l] = static_cast<int32_t>(origin_pos.y);
+        map_step_x[l] = (dir_x < 0) ? -1 : 1;
+        map_step_y[l] = (dir_y < 0) ? -1 : 1;
+        const ScalarT tile_x ( map_x[l] - origin.x );
+        const ScalarT tile_y ( map_y[l] - origin.y );
+        dist_next_unit_x[l] = ((dir_x < 0) ?
+                               pos.x - tile_x :
+                               tile_x + ScalarT(1) - pos.x) * dist_per_unit_x[l];
+        dist_next_unit_y[l] = ((dir_y < 0) ?
+                               pos.y - tile_y :
+                               tile_y + ScalarT(1) - pos.y) * dist_per_unit_y[l];
+        query_i[l] = i;
+        active[l] = true;
+        hit_ns[l] = false;
+    } };
+    const auto storeHit { [&](const uint16_t l) {
+        const uint32_t i { query_i[l] };
+        // lanes with origins inside a wall took no steps, so stepping back
+        //   gives a negative (or NaN, if axis aligned) distance
+        const ScalarT dist { hit_ns[l] ?
+            dist_next_unit_x[l] - dist_per_unit_x[l] :
+            dist_next_unit_y[l] - dist_per_unit_y[l] };
+        rays.dist[i] = no_hit[l] ? float(rays.max_dist[i]) :
+            ((dist > ScalarT(0)) ? float(dist) : 0.0f);
+        rays.map_x[i] = map_x[l];
+        rays.map_y[i] = map_y[l];
+        rays.tex_key[i] = no_hit[l] ? RayQueryBuffer::NO_HIT_TEX_KEY :
+            layout.tile(map_x[l], map_y[l]);
+        // rays stepping +x enter a tile through its W side, and so on
+        rays.side[i] = hit_ns[l] ?
+            ((map_step_x[l] > 0) ? TileSide::W : TileSide::E) :
+            ((map_step_y[l] > 0) ? TileSide::S : TileSide::N);
+    } };
+
+    uint32_t next_i { begin_i };
+    uint16_t active_ct { 0 };
+    for (uint16_t l { 0 }; l < N; ++l) {
+        // idle lanes keep valid (in map) state so that lane loops need no
+        //   bounds checks
+        loadQuery(l, begin_i);
+        active[l] = next_i < end_i;
+        if (active[l]) {
+            loadQuery(l, next_i++);
+            ++active_ct;
+        }
+    }
+
+    // packet DDA loop
+    const bool skip_empty { settings.empty_space_skip != EmptySpaceSkip::None };
+    while (active_ct > 0) {
+        // gathered wall lookups, one per lane (idle lanes hold a valid
+        //   query's state, so are looked up and masked out after)
+        layout.tilesAreWall<N>(map_x, map_y, hit_wall);
+        for (uint16_t l { 0 }; l < N; ++l)
+            hit_wall[l] = hit_wall[l] & active[l];
+        // jumps vary in length per lane, so are not vectorized
+        if (skip_empty) {
+            for (uint16_t l { 0 }; l < N; ++l) {
+                int32_t x_inside_ct;
+                int32_t y_inside_ct;
+                if (!active[l] || hit_wall[l] ||
+                    !emptyBox(layout, settings.empty_space_skip,
+                              map_x[l], map_y[l], map_step_x[l], map_step_y[l],
+                              x_inside_ct, y_inside_ct)) {
+                    continue;
+                }
+                skipEmptyBox(x_inside_ct, y_inside_ct,
+                             dist_next_unit_x[l], dist_next_unit_y[l],
+                             dist_per_unit_x[l], dist_per_unit_y[l],
+                             map_x[l], map_y[l], map_step_x[l], map_step_y[l]);
+            }
+        }
+        bool any_done { false };
+        for (uint16_t l { 0 }; l < N; ++l) {
+            // lanes past their max_dist stop without a hit
+            no_hit[l] = active[l] && !hit_wall[l] &&
+                min(dist_next_unit_x[l], dist_next_unit_y[l]) > max_dist[l];
+            const bool done { hit_wall[l] || no_hit[l] };
+            any_done = any_done || done;
+            const bool step_x { active[l] && !done &&
+                                dist_next_unit_x[l] < dist_next_unit_y[l] };
+            const bool step_y { active[l] && !done && !step_x };
+            // selects rather than multiplying by masks, as dist_per_unit_*
+            //   may be infinite
+            dist_next_unit_x[l] = step_x ?
+                dist_next_unit_x[l] + dist_per_unit_x[l] : dist_next_unit_x[l];
+            dist_next_unit_y[l] = step_y ?
+                dist_next_unit_y[l] + dist_per_unit_y[l] : dist_next_unit_y[l];
+            map_x[l] += step_x ? map_step_x[l] : 0;
+            map_y[l] += step_y ? map_step_y[l] : 0;
+            hit_ns[l] = step_x || (hit_ns[l] && !step_y);
+        }
+        if (!any_done)
+            continue;
+        // refill lanes that are done (their state was left unstepped)
+        for (uint16_t l { 0 }; l < N; ++l) {
+            if (!hit_wall[l] && !no_hit[l])
+                continue;
+            storeHit(l);
+            if (next_i < end_i) {
+                loadQuery(l, next_i++);
+            } else {
+                active[l] = false;
+                --active_ct;
+            }
+        }
+    }
+}
+
+template <typename ScalarT>
+void DdaRaycastEngine::castRayQueriesAs(RayQueryBuffer& rays,
+                                        const uint32_t begin_i,
+                                        const uint32_t end_i,
+                                        const Settings& settings) const {
+    if (settings.ray_packets) {
+        castRayQueryPacketsAs<ScalarT>(rays, begin_i, end_i, settings);
+        return;
+    }
+    for (uint32_t i { begin_i }; i < end_i; ++i)
+        castRayQueryAs<ScalarT>(rays, i, settings);
+}
+
+void DdaRaycastEngine::castRayQueries(RayQueryBuffer& rays,
+                                      const Settings& settings,
+                                      ThreadPool& thread_pool) const {
+    // origins outside the map would step beyond its perimeter walls
+    for (uint32_t i { 0 }; i < rays.size(); ++i) {
+        if (!(rays.origin_x[i] >= 0 && rays.origin_x[i] < layout.w &&
+              rays.origin_y[i] >= 0 && rays.origin_y[i] < layout.h)) {
+            std::ostringstream err_msg;
+            err_msg << "Ray query " << i << " origin (" << rays.origin_x[i] <<
+                ", " << rays.origin_y[i] << ") outside of map.";
+            throw std::runtime_error(err_msg.str());
+        }
+    }
+    thread_pool.forEachStrip(
+        rays.size(), RAY_QUERY_STRIP_SZ,
+        [&](const uint32_t begin, const uint32_t end) {
+            switch (settings.scalar_type) {
+            case ScalarType::Float:
+                castRayQueriesAs<float>(rays, begin, end, settings);
+                break;
+            case ScalarType::Fixed16_16:
+                castRayQueriesAs<Fixed16_16>(rays, begin, end, settings);
+                break;
+            case ScalarType::Double:
+            default:
+                castRayQueriesAs<double>(rays, begin, end, settings);
+                break;
+            }
+        });
+}
+
+void DdaRaycastEngine::bakeLighting(const Settings& settings,
+                                    ThreadPool& thread_pool) {
+    bakeLighting({ 0, 0, layout.w, layout.h }, settings, thread_pool);
+}
+
+void DdaRaycastEngine::bakeLighting(const TileRect& region,
+                                    const Settings& settings,
+                                    ThreadPool& thread_pool) {
+    if (layout.lights.empty())
+        return;
+    const uint32_t region_w { region.x1 - region.x0 };
+    // light per tile of region, in units of full texture brightness
+    std::vector<double> tile_light(size_t(region_w) * (region.y1 - region.y0),
+                                   AMBIENT_LIGHT);
+    // light each sight line adds to its tile if clear
+    struct LightSample {
+        size_t   tile_i;
+        double   added;
+        Vector2d center;
+        Vector2d light_pos;
+    };
+    std::vector<LightSample> samples;
+    for (const PointLight& light : layout.lights) {
+        const uint32_t light_x ( light.x );
+        const uint32_t light_y ( light.y );
+        // tiles of region with centers inside the light's radius
+        const TileRect reach { layout.lightTiles(light) };
+        const uint32_t begin_x { std::max(reach.x0, region.x0) };
+        const uint32_t begin_y { std::max(reach.y0, region.y0) };
+        const uint32_t end_x { std::min(reach.x1, region.x1) };
+        const uint32_t end_y { std::min(reach.y1, region.y1) };
+        for (uint32_t y { begin_y }; y < end_y; ++y) {
+            for (uint32_t x { begin_x }; x < end_x; ++x) {
+                if (layout.tileIsWall(x, y))
+                    continue;
+                const Vector2d center { x + 0.5, y + 0.5 };
+                const double offset_x { center.x - light.x };
+                const double offset_y { center.y - light.y };
+                const double dist { std::sqrt((offset_x * offset_x) +
+                                              (offset_y * offset_y)) };
+                if (!(dist < light.radius))
+                    continue;
+                // falls off to nothing at the radius, smoothly
+                const double falloff { 1 - (dist / light.radius) };
+                const double added { light.brightness * falloff * falloff };
+                const size_t tile_i { (size_t(y - region.y0) * region_w) +
+                                      (x - region.x0) };
+                // light's own tile needs no sight line (which would have no
+                //   direction for a light at the center)
+                if (x == light_x && y == light_y)
+                    tile_light[tile_i] += added;
+                else
+                    samples.push_back({ tile_i, added, center, { light.x, light.y } });
+            }
+        }
+    }
+    RayQueryBuffer rays;
+    rays.resize(samples.size());
+    for (uint32_t i { 0 }; i < samples.size(); ++i)
+        rays.setSightLine(i, samples[i].center, samples[i].light_pos);
+    castRayQueries(rays, settings, thread_pool);
+    for (uint32_t i { 0 }; i < samples.size(); ++i) {
+        if (!rays.hit(i))
+            tile_light[samples[i].tile_i] += samples[i].added;
+    }
+    for (uint32_t y { region.y0 }; y < region.y1; ++y) {
+        for (uint32_t x { region.x0 }; x < region.x1; ++x) {
+            layout.setTileLight(x, y, uint8_t(std::min(
+                std::round(tile_light[(size_t(y - region.y0) * region_w) +
+                                      (x - region.x0)] *
+                           Layout::LIGHT_LEVEL_ONE),
+                double(Layout::LIGHT_LEVEL_CT - 1))));
+        }
+    }
+    // rays cast before baking are unlit
+    invalidateRayCache();
+}
+
+bool DdaRaycastEngine::applyTileEdits(const Settings& settings,
+                                      ThreadPool& thread_pool) {
+    TileRect dirty;
+    if (!layout.applyTileEdits(dirty, thread_pool))
+        return false;
+    // An edit changes the light of tiles whose sight lines to a light it
+    //   opens or blocks, which all lie in reach of that light, so the tiles
+    //   in reach of every light reaching the edits are baked again.
+    TileRect relit { dirty };
+    bool lit { false };
+    for (const PointLight& light : layout.lights) {
+        const TileRect reach { layout.lightTiles(light) };
+        if (!(reach.x0 < dirty.x1 && dirty.x0 < reach.x1 &&
+              reach.y0 < dirty.y1 && dirty.y0 < reach.y1))
+            continue;
+        relit = { std::min(relit.x0, reach.x0), std::min(relit.y0, reach.y0),
+                  std::max(relit.x1, reach.x1), std::max(relit.y1, reach.y1) };
+        lit = true;
+    }
+    if (lit) {
+        bakeLighting(relit, settings, thread_pool);
+    } else {
+        // edited tiles (walls among them) at ambient light, as when baked
+        for (uint32_t y { dirty.y0 }; y < dirty.y1; ++y) {
+            for (uint32_t x { dirty.x0 }; x < dirty.x1; ++x) {
+                layout.setTileLight(x, y, layout.lights.empty() ?
+                    Layout::LIGHT_LEVEL_ONE :
+                    uint8_t(std::round(AMBIENT_LIGHT * Layout::LIGHT_LEVEL_ONE)));
+            }
+        }
+    }
+    // (other engines sharing the layout drop their cached rays on seeing the
+    //   layout's edit count change)
+    invalidateRayCache();
+    return true;
+}
+
+bool DdaRaycastEngine::pageChunks() {
+    if (!layout.pageChunks(player_pos, player_dir))
+        return false;
+    // rays hitting fog where chunks have since loaded are cast again
+    invalidateRayCache();
+    return true;
+}
+
+DdaRaycastEngine::RayCacheKey DdaRaycastEngine::currentRayCacheKey(
+    const Settings& settings) const {
+    RayCacheKey curr_key;
+    curr_key.player_pos = player_pos;
+    curr_key.player_dir = player_dir;
+    curr_key.view_plane = view_plane;
+    curr_key.window_w = window_w;
+    curr_key.euclidean = settings.euclidean;
+    curr_key.draw_dist = settings.draw_dist;
+    curr_key.column_scale = settings.column_scale;
+    curr_key.scalar_type = settings.scalar_type;
+    curr_key.layout_edit_ct = layout.editCount();
+    return curr_key;
+}
+
+bool DdaRaycastEngine::prevRayInsideWallFace(const uint16_t prev_x) const {
+    if (prev_x == 0 || prev_x + 1 >= window_w)
+        return false;
+    // the draw distance turns with the camera plane, so a ray that reached it
+    //   may hit a wall after turning
+    if (prev_fov_rays.tex_key[prev_x] == FovRayBuffer::NO_HIT_TEX_KEY)
+        return false;
+    const float dist { prev_fov_rays.dist[prev_x] };
+    for (const uint16_t x : { uint16_t(prev_x - 1), uint16_t(prev_x + 1) }) {
+        if (prev_fov_rays.tex_key[x] != prev_fov_rays.tex_key[prev_x] ||
+            prev_fov_rays.algnmt[x] != prev_fov_rays.algnmt[prev_x] ||
+            std::abs(prev_fov_rays.dist[x] - dist) >
+            dist * RAY_CACHE_MAX_NEIGHBOR_DIST_RATIO) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DdaRaycastEngine::planReprojection() {
+    // Previous rays are parameterized by their unnormalized direction
+    //   prev_dir = key.player_dir + key.view_plane * prev_camera_x, and a
+    //   current ray's direction, expressed in the previous camera's basis,
+    //   gives the previous camera_x with the same direction.
+    const double dir_mag_sq { key.player_dir.x * key.player_dir.x +
+                              key.player_dir.y * key.player_dir.y };
+    const double plane_mag_sq { key.view_plane.x * key.view_plane.x +
+                                key.view_plane.y * key.view_plane.y };
+    bool any_reusable { false };
+    for (uint16_t x { 0 }; x < window_w; ++x) {
+        reuse_src[x] = -1;
+        const Vector2d dir { column_dir_x[x], column_dir_y[x] };
+        const double along_dir { (dir.x * key.player_dir.x +
+                                  dir.y * key.player_dir.y) / dir_mag_sq };
+        // direction behind or level with previous camera plane
+        if (along_dir <= 0)
+            continue;
+        const double prev_camera_x { (dir.x * key.view_plane.x +
+                                      dir.y * key.view_plane.y) /
+                                     plane_mag_sq / along_dir };
+        const double prev_x { (prev_camera_x + 1) * window_w / 2 };
+        const double src_x { std::round(prev_x) };
+        if (src_x < 0 || src_x >= window_w)
+            continue;
+        const float err ( std::abs(prev_x - src_x) +
+                          prev_reuse_err[uint16_t(src_x)] );
+        if (err > RAY_CACHE_MAX_COLUMN_ERR ||
+            !prevRayInsideWallFace(uint16_t(src_x)))
+            continue;
+        reuse_src[x] = src_x;
+        reuse_err[x] = err;
+        // Previous ray hit at player_pos + prev_dist * prev_dir; as
+        //   dir.player_dir is 1, and dir is parallel to prev_dir, the
+        //   perpendicular distance along dir to the same point is
+        //   prev_dist * (prev_dir . player_dir).
+        const Vector2d prev_dir {
+            key.player_dir + (key.view_plane * column_camera_x[src_x]) };
+        reuse_dist_scale[x] = prev_dir.x * player_dir.x + prev_dir.y * player_dir.y;
+        any_reusable = true;
+    }
+    return any_reusable;
+}
+
+bool DdaRaycastEngine::raysReusable(const uint16_t begin_x,
+                                    const uint16_t end_x) const {
+    for (uint16_t x { begin_x }; x < end_x; ++x) {
+        if (reuse_src[x] < 0)
+            return false;
+    }
+    return true;
+}
+
+bool DdaRaycastEngine::reuseRay(const uint16_t window_x) {
+    const int32_t src_x { reuse_src[window_x] };
+    if (src_x < 0)
+        return false;
+    fov_rays.dist[window_x] = prev_fov_rays.dist[src_x] * reuse_dist_scale[window_x];
+    fov_rays.tex_key[window_x] = prev_fov_rays.tex_key[src_x];
+    fov_rays.hit_x[window_x] = prev_fov_rays.hit_x[src_x];
+    fov_rays.algnmt[window_x] = prev_fov_rays.algnmt[src_x];
+    fov_rays.light[window_x] = prev_fov_rays.light[src_x];
+    // exact direction of this column, rather than that of the source ray
+    fov_rays.dir_x[window_x] = column_dir_x[window_x];
+    fov_rays.dir_y[window_x] = column_dir_y[window_x];
+    return true;
+}
+
+DdaRaycastEngine::WallFace DdaRaycastEngine::rayWallFace(
+    const FovRayBuffer& rays, const uint16_t window_x, const Vector2d& pos) {
+    WallFace face;
+    face.algnmt = rays.algnmt[window_x];
+    face.tex_key = rays.tex_key[window_x];
+    // NS walls lie on grid verticals (x = line), EW walls on grid horizontals
+    //   (y = line)
+    const bool ns { face.algnmt == WallOrientation::NS };
+    const double dist { rays.dist[window_x] };
+    const double dir_across { ns ? rays.dir_x[window_x] : rays.dir_y[window_x] };
+    const double dir_along { ns ? rays.dir_y[window_x] : rays.dir_x[window_x] };
+    const double hit_across { (ns ? pos.x : pos.y) + dist * dir_across };
+    const double hit_along { (ns ? pos.y : pos.x) + dist * dir_along };
+    face.line = std::round(hit_across);
+    // a ray heading toward +x (+y) hits the west (south) face of the tile
+    //   starting at the line
+    face.tile_across = (dir_across > 0) ? face.line : face.line - 1;
+    face.tile_along = std::floor(hit_along);
+    return face;
+}
+
+bool DdaRaycastEngine::rayOnFaceLine(const uint16_t window_x,
+                                     const WallFace& face) const {
+    if (fov_rays.tex_key[window_x] != face.tex_key ||
+        fov_rays.algnmt[window_x] != face.algnmt)
+        return false;
+    const bool ns { face.algnmt == WallOrientation::NS };
+    const double hit_across { ns ?
+        player_pos.x + fov_rays.dist[window_x] * double(fov_rays.dir_x[window_x]) :
+        player_pos.y + fov_rays.dist[window_x] * double(fov_rays.dir_y[window_x]) };
+    return std::abs(hit_across - face.line) <= FACE_LINE_MAX_ERR;
+}
+
+bool DdaRaycastEngine::faceHit(const uint16_t window_x, const WallFace& face,
+                               double& dist, double& hit_along) const {
+    const bool ns { face.algnmt == WallOrientation::NS };
+    const double dir_across { ns ? column_dir_x[window_x] : column_dir_y[window_x] };
+    const double dir_along { ns ? column_dir_y[window_x] : column_dir_x[window_x] };
+    // ray must reach the same side of the line
+    if (dir_across == 0 ||
+        ((dir_across > 0) ? face.line : face.line - 1) != face.tile_across)
+        return false;
+    // (perpendicular distance, as dir is scaled to a player_dir component of 1)
+    dist = (face.line - (ns ? player_pos.x : player_pos.y)) / dir_across;
+    hit_along = (ns ? player_pos.y : player_pos.x) + dist * dir_along;
+    return dist > 0 && std::floor(hit_along) == face.tile_along;
+}
+
+void DdaRaycastEngine::storeFaceHit(const uint16_t window_x,
+                                    const WallFace& face,
+                                    const double dist, const double hit_along) {
+    fov_rays.dist[window_x] = dist;
+    fov_rays.tex_key[window_x] = face.tex_key;
+    fov_rays.hit_x[window_x] =
+        FovRayBuffer::narrowHitX(hit_along - std::floor(hit_along));
+    fov_rays.algnmt[window_x] = face.algnmt;
+    // lit by the tile on the other side of the face line from the wall tile
+    const uint32_t lit_across ( (face.tile_across == face.line) ?
+                                face.line - 1 : face.line );
+    const uint32_t lit_along ( face.tile_along );
+    fov_rays.light[window_x] = (face.algnmt == WallOrientation::NS) ?
+        layout.tileLight(lit_across, lit_along) :
+        layout.tileLight(lit_along, lit_across);
+    fov_rays.dir_x[window_x] = column_dir_x[window_x];
+    fov_rays.dir_y[window_x] = column_dir_y[window_x];
+}
+
+bool DdaRaycastEngine::storeFaceHit(const uint16_t window_x,
+                                    const WallFace& face,
+                                    const Settings& settings) {
+    double dist;
+    double hit_along;
+    if (!faceHit(window_x, face, dist, hit_along) ||
+        (settings.draw_dist > 0 && dist > settings.draw_dist))
+        return false;
+    storeFaceHit(window_x, face, dist, hit_along);
+    return true;
+}
+
+double DdaRaycastEngine::pointColumn(const Vector2d& point) const {
+    const Vector2d rel { point.x - player_pos.x, point.y - player_pos.y };
+    // player_dir is a unit vector
+    const double depth { rel.x * player_dir.x + rel.y * player_dir.y };
+    if (!(depth > 0))
+        return std::numeric_limits<double>::quiet_NaN();
+    const double plane_mag_sq { view_plane.x * view_plane.x +
+                                view_plane.y * view_plane.y };
+    const double camera_x { (rel.x * view_plane.x + rel.y * view_plane.y) /
+                            plane_mag_sq / depth };
+    return (camera_x + 1) * window_w / 2;
+}
+
+template <typename ScalarT>
+uint64_t DdaRaycastEngine::castWallSpansAs(const uint16_t begin_x,
+                                           const uint16_t end_x,
+                                           const Settings& settings) {
+    uint64_t step_ct { 0 };
+    // column whose ray was already cast while finding the previous span
+    int32_t cast_x { -1 };
+    uint16_t window_x { begin_x };
+    while (window_x < end_x) {
+        if (window_x != cast_x)
+            step_ct += castRayAs<ScalarT>(window_x, settings);
+        if (fov_rays.tex_key[window_x] == FovRayBuffer::NO_HIT_TEX_KEY ||
+            window_x + 2 >= end_x) {
+            ++window_x;
+            continue;
+        }
+        const WallFace face { rayWallFace(fov_rays, window_x, player_pos) };
+        const bool ns { face.algnmt == WallOrientation::NS };
+        // the rays of all columns before the rightmost face end column meet
+        //   the face line within the face (unless the face extends behind the
+        //   camera, when the span may run to the end of the range)
+        const Vector2d face_end_0 { ns ?
+            Vector2d { face.line, face.tile_along } :
+            Vector2d { face.tile_along, face.line } };
+        const Vector2d face_end_1 { ns ?
+            Vector2d { face.line, face.tile_along + 1 } :
+            Vector2d { face.tile_along + 1, face.line } };
+        const double end_col_0 { pointColumn(face_end_0) };
+        const double end_col_1 { pointColumn(face_end_1) };
+        const double span_end_col { (std::isnan(end_col_0) || std::isnan(end_col_1)) ?
+            double(end_x) : std::max(end_col_0, end_col_1) };
+        // (no columns between)
+        if (span_end_col <= window_x + 2) {
+            ++window_x;
+            continue;
+        }
+        uint16_t last_x ( std::min(double(end_x - 1), std::ceil(span_end_col) - 1) );
+        step_ct += castRayAs<ScalarT>(last_x, settings);
+        if (!(rayOnFaceLine(last_x, face) &&
+              storeFaceHit(last_x, face, settings))) {
+            // face hidden at span end, so bisect for the last column it is
+            //   visible in
+            uint16_t hit_x { window_x };
+            uint16_t miss_x { last_x };
+            while (miss_x - hit_x > 1) {
+                const uint16_t mid_x ( (hit_x + miss_x) / 2 );
+                step_ct += castRayAs<ScalarT>(mid_x, settings);
+                if (rayOnFaceLine(mid_x, face) &&
+                    storeFaceHit(mid_x, face, settings)) {
+                    hit_x = mid_x;
+                } else {
+                    miss_x = mid_x;
+                }
+            }
+            last_x = hit_x;
+            cast_x = miss_x;
+        }
+        // fill columns between analytically
+        for (uint16_t x ( window_x + 1 ); x < last_x; ++x) {
+            if (!storeFaceHit(x, face, settings))
+                step_ct += castRayAs<ScalarT>(x, settings);
+        }
+        window_x = last_x + 1;
+    }
+    return step_ct;
+}
+
+void DdaRaycastEngine::cullPvsFaces(const Settings& settings) {
+    pvs_faces.clear();
+    const uint32_t tile_x ( player_pos.x );
+    const uint32_t tile_y ( player_pos.y );
+    for (const uint32_t* face_i { layout.pvsBegin(tile_x, tile_y) };
+         face_i != layout.pvsEnd(tile_x, tile_y); ++face_i) {
+        const WallTileFace& tile_face { layout.wallFace(*face_i) };
+        PvsFace pvs_face;
+        WallFace& face { pvs_face.face };
+        face.tex_key = layout.tile(tile_face.x, tile_face.y);
+        // E and W faces lie on grid verticals, so are hit as NS walls
+        const bool ns { tile_face.side == TileSide::E ||
+                        tile_face.side == TileSide::W };
+        face.algnmt = ns ? WallOrientation::NS : WallOrientation::EW;
+        face.tile_across = ns ? tile_face.x : tile_face.y;
+        face.tile_along = ns ? tile_face.y : tile_face.x;
+        face.line = (tile_face.side == TileSide::E || tile_face.side == TileSide::N) ?
+            face.tile_across + 1 : face.tile_across;
+        // player must be in front of face
+        const double pos_across { ns ? player_pos.x : player_pos.y };
+        if ((face.tile_across == face.line) ?
+            !(pos_across < face.line) : !(pos_across > face.line))
+            continue;
+        const Vector2d face_end_0 { ns ?
+            Vector2d { face.line, face.tile_along } :
+            Vector2d { face.tile_along, face.line } };
+        const Vector2d face_end_1 { ns ?
+            Vector2d { face.line, face.tile_along + 1 } :
+            Vector2d { face.tile_along + 1, face.line } };
+        const double end_col_0 { pointColumn(face_end_0) };
+        const double end_col_1 { pointColumn(face_end_1) };
+        if (std::isnan(end_col_0) && std::isnan(end_col_1))
+            continue;
+        // faces reaching behind the camera may project to any column
+        double begin_col { 0 };
+        double end_col { double(window_w) };
+        if (!std::isnan(end_col_0) && !std::isnan(end_col_1)) {
+            // (a column of margin either side)
+            begin_col = std::max(begin_col,
+                                 std::floor(std::min(end_col_0, end_col_1)));
+            end_col = std::min(end_col,
+                               std::ceil(std::max(end_col_0, end_col_1)) + 1);
+        }
+        if (!(begin_col < end_col))
+            continue;
+        pvs_face.begin_x = begin_col;
+        pvs_face.end_x = end_col;
+        // player_dir is a unit vector
+        const auto depth { [this](const Vector2d& point) {
+            return ((point.x - player_pos.x) * player_dir.x) +
+                ((point.y - player_pos.y) * player_dir.y); } };
+        pvs_face.near_dist = std::max(0.0, std::min(depth(face_end_0),
+                                                    depth(face_end_1)));
+        if (settings.draw_dist > 0 && pvs_face.near_dist > settings.draw_dist)
+            continue;
+        pvs_faces.push_back(pvs_face);
+    }
+    std::sort(pvs_faces.begin(), pvs_faces.end(),
+              [](const PvsFace& a, const PvsFace& b) {
+                  return a.near_dist < b.near_dist; });
+}
+
+template <typename ScalarT>
+uint64_t DdaRaycastEngine::castPvsFacesAs(const uint16_t begin_x,
+                                          const uint16_t end_x,
+                                          const Settings& settings) {
+    // nearest hit so far per column in range
+    const WallFace** nearest_face { pvs_nearest_face.data() };
+    double*          nearest_dist { pvs_nearest_dist.data() };
+    double*          nearest_hit_along { pvs_nearest_hit_along.data() };
+    std::fill(nearest_face + begin_x, nearest_face + end_x, nullptr);
+    std::fill(nearest_dist + begin_x, nearest_dist + end_x,
+              std::numeric_limits<double>::infinity());
+    double farthest_nearest_dist { std::numeric_limits<double>::infinity() };
+    for (const PvsFace& pvs_face : pvs_faces) {
+        // no later face can be nearer than the hit of any column
+        if (pvs_face.near_dist >= farthest_nearest_dist)
+            break;
+        bool stored { false };
+        for (uint16_t window_x { std::max(begin_x, pvs_face.begin_x) };
+             window_x < std::min(end_x, pvs_face.end_x); ++window_x) {
+            double dist;
+            double hit_along;
+            if (pvs_face.near_dist < nearest_dist[window_x] &&
+                faceHit(window_x, pvs_face.face, dist, hit_along) &&
+                dist < nearest_dist[window_x]) {
+                nearest_face[window_x] = &pvs_face.face;
+                nearest_dist[window_x] = dist;
+                nearest_hit_along[window_x] = hit_along;
+                stored = true;
+            }
+        }
+        if (stored) {
+            farthest_nearest_dist =
+                *std::max_element(nearest_dist + begin_x, nearest_dist + end_x);
+        }
+    }
+    uint64_t step_ct { 0 };
+    for (uint16_t window_x { begin_x }; window_x < end_x; ++window_x) {
+        if (nearest_face[window_x] != nullptr &&
+            !(settings.draw_dist > 0 &&
+              nearest_dist[window_x] > settings.draw_dist)) {
+            storeFaceHit(window_x, *nearest_face[window_x],
+                         nearest_dist[window_x], nearest_hit_along[window_x]);
+        } else {
+            step_ct += castRayAs<ScalarT>(window_x, settings);
+        }
+    }
+    return step_ct;
+}
+
+bool DdaRaycastEngine::reprojectPrevHit(const uint16_t window_x,
+                                        const Settings& settings) {
+    if (prev_fov_rays.tex_key[window_x] == FovRayBuffer::NO_HIT_TEX_KEY)
+        return false;
+    const WallFace face { rayWallFace(prev_fov_rays, window_x, prev_player_pos) };
+    // newly cast neighbors must hit the same face line
+    for (const uint16_t x : { uint16_t(window_x - 1), uint16_t(window_x + 1) }) {
+        if (!rayOnFaceLine(x, face))
+            return false;
+    }
+    // and the column's new ray the same face
+    return storeFaceHit(window_x, face, settings);
+}
+
+void DdaRaycastEngine::beginFrame(const Settings& settings) {
+    prev_frames_hit_ct += frame_hit_ct.exchange(0);
+    prev_frames_miss_ct += frame_miss_ct.exchange(0);
+    frame_step_ct = 0;
+
+    // only frames where the player has turned (or the window was resized)
+    //   recalculate ray directions
+    if (!tables_valid ||
+        player_dir.x != tables_player_dir.x || player_dir.y != tables_player_dir.y ||
+        view_plane.x != tables_view_plane.x || view_plane.y != tables_view_plane.y)
+        updateColumnTables();
+
+    const RayCacheKey curr_key { currentRayCacheKey(settings) };
+    const bool same_pos { curr_key.player_pos.x == key.player_pos.x &&
+                          curr_key.player_pos.y == key.player_pos.y };
+    const bool same_dir { curr_key.player_dir.x == key.player_dir.x &&
+                          curr_key.player_dir.y == key.player_dir.y &&
+                          curr_key.view_plane.x == key.view_plane.x &&
+                          curr_key.view_plane.y == key.view_plane.y };
+    const bool same_rays { key_valid && curr_key.window_w == key.window_w &&
+                           curr_key.euclidean == key.euclidean &&
+                           curr_key.draw_dist == key.draw_dist &&
+                           curr_key.column_scale == key.column_scale &&
+                           curr_key.scalar_type == key.scalar_type &&
+                           curr_key.layout_edit_ct == key.layout_edit_ct };
+    // euclidean distances do not scale with the camera plane, columns
+    //   skipped by column scaling have no rays to check neighbors against, and
+    //   wall segments may be narrower than a column (so hidden between
+    //   neighbors hitting the same wall)
+    const bool reprojectable { same_rays && !settings.euclidean &&
+                               settings.column_scale == 1 &&
+                               !layout.hasSegments() };
+    ray_cache_mode = RayCacheMode::Disabled;
+    if (settings.ray_cache && same_rays && same_pos && same_dir) {
+        ray_cache_mode = RayCacheMode::AllValid;
+    } else if (settings.ray_cache && reprojectable && same_pos) {
+        std::swap(prev_fov_rays, fov_rays);
+        std::swap(prev_reuse_err, reuse_err);
+        if (planReprojection()) {
+            ray_cache_mode = RayCacheMode::Reproject;
+        } else {
+            std::swap(prev_fov_rays, fov_rays);
+            std::swap(prev_reuse_err, reuse_err);
+        }
+    }
+    if (ray_cache_mode == RayCacheMode::Disabled &&
+        settings.interleave && reprojectable) {
+        std::swap(prev_fov_rays, fov_rays);
+        std::swap(prev_reuse_err, reuse_err);
+        interleave_parity ^= 1;
+        ray_cache_mode = RayCacheMode::Interleave;
+    }
+    // faces give every ray of the frame, so are only used when none are
+    //   reused, and give perpendicular distances for every column
+    pvs_frame = settings.pvs && layout.hasPvs() &&
+        ray_cache_mode == RayCacheMode::Disabled &&
+        settings.column_scale == 1 && !settings.euclidean;
+    if (pvs_frame)
+        cullPvsFaces(settings);
+    prev_player_pos = key.player_pos;
+    key = curr_key;
+    key_valid = true;
+}
+
+void DdaRaycastEngine::castRays(const uint16_t begin_x, const uint16_t end_x,
+                                const Settings& settings) {
+    if (ray_cache_mode == RayCacheMode::AllValid) {
+        // multiples of column_scale in range
+        const uint16_t column_step { settings.column_scale };
+        frame_hit_ct += ((end_x + column_step - 1) / column_step) -
+            ((begin_x + column_step - 1) / column_step);
+        return;
+    }
+    if (layout.hasSegments()) {
+        castSegmentRays(begin_x, end_x, settings);
+        return;
+    }
+    switch (settings.scalar_type) {
+    case ScalarType::Float:
+        castRaysAs<float>(begin_x, end_x, settings);
+        break;
+    case ScalarType::Fixed16_16:
+        castRaysAs<Fixed16_16>(begin_x, end_x, settings);
+        break;
+    case ScalarType::Double:
+    default:
+        castRaysAs<double>(begin_x, end_x, settings);
+        break;
+    }
+}
+
+RayCacheStats DdaRaycastEngine::rayCacheStats() const {
+    RayCacheStats stats;
+    stats.frame_hit_ct = frame_hit_ct;
+    stats.frame_miss_ct = frame_miss_ct;
+    stats.hit_ct = prev_frames_hit_ct + stats.frame_hit_ct;
+    stats.miss_ct = prev_frames_miss_ct + stats.frame_miss_ct;
+    return stats;
+}
+
+double DdaRaycastEngine::frameStepsPerRay() const {
+    const uint32_t cast_ct { frame_miss_ct };
+    return cast_ct ? double(frame_step_ct) / cast_ct : 0;
+}
+
+void DdaRaycastEngine::addRayErrors(const Settings& reference_settings,
+                                    const Settings& test_settings,
+                                    const uint16_t turn_ct,
+                                    ScalarAccuracyReport& report,
+                                    double& dist_err_sum) {
+    for (uint16_t turn_i { 0 }; turn_i < turn_ct; ++turn_i) {
+        playerTurnLeft(2 * M_PI / turn_ct);
+        castRays(reference_settings);
+        const FovRayBuffer reference { fov_rays };
+        castRays(test_settings);
+        for (uint16_t i { 0 }; i < window_w; ++i) {
+            ++report.ray_ct;
+            if (fov_rays.tex_key[i] != reference.tex_key[i] ||
+                fov_rays.algnmt[i] != reference.algnmt[i]) {
+                ++report.wall_mismatch_ct;
+                continue;
+            }
+            double dist_err ( std::abs(fov_rays.dist[i] - reference.dist[i]) );
+            double rel_dist_err { dist_err / reference.dist[i] };
+            double hit_x_err ( std::abs(fov_rays.hit_x[i] - reference.hit_x[i]) );
+            // hits straddling a texture seam are equally accurate
+            hit_x_err = std::min(hit_x_err, 1 - hit_x_err);
+            dist_err_sum += dist_err;
+            report.max_dist_err = std::max(report.max_dist_err, dist_err);
+            report.max_rel_dist_err = std::max(report.max_rel_dist_err, rel_dist_err);
+            report.max_hit_x_err = std::max(report.max_hit_x_err, hit_x_err);
+        }
+    }
+}
+
+ScalarAccuracyReport DdaRaycastEngine::scalarAccuracyReport(
+    const ScalarType scalar_type, const Settings& settings,
+    const uint16_t turn_ct) {
+    ScalarAccuracyReport report;
+    const Vector2d start_player_dir { player_dir };
+    const Vector2d start_view_plane { view_plane };
+    Settings reference_settings { settings };
+    // every ray cast, so each type is measured on its own
+    reference_settings.ray_cache = false;
+    reference_settings.scalar_type = ScalarType::Double;
+    Settings test_settings { reference_settings };
+    test_settings.scalar_type = scalar_type;
+    double dist_err_sum { 0 };
+    addRayErrors(reference_settings, test_settings, turn_ct, report,
+                 dist_err_sum);
+    uint32_t match_ct { report.ray_ct - report.wall_mismatch_ct };
+    report.mean_dist_err = match_ct ? dist_err_sum / match_ct : 0;
+    player_dir = start_player_dir;
+    view_plane = start_view_plane;
+    return report;
+}
+
+ScalarAccuracyReport DdaRaycastEngine::wallSpanAccuracyReport(
+    const Settings& settings, const uint16_t turn_ct, const uint16_t pos_ct) {
+    ScalarAccuracyReport report;
+    const Vector2d start_player_pos { player_pos };
+    const Vector2d start_player_dir { player_dir };
+    const Vector2d start_view_plane { view_plane };
+    Settings reference_settings { settings };
+    // every ray cast, with the perpendicular distances wall spans need
+    reference_settings.ray_cache = false;
+    reference_settings.interleave = false;
+    reference_settings.column_scale = 1;
+    reference_settings.euclidean = false;
+    reference_settings.pvs = false;
+    reference_settings.wall_spans = false;
+    Settings test_settings { reference_settings };
+    test_settings.wall_spans = true;
+    double dist_err_sum { 0 };
+    addRayErrors(reference_settings, test_settings, turn_ct, report,
+                 dist_err_sum);
+    // then from the centers of empty tiles at evenly spaced tile indices
+    //   (skipping to the next empty tile), so that spans are checked against
+    //   walls seen from many sides
+    const size_t tile_ct { size_t(layout.w) * layout.h };
+    for (uint16_t pos_i { 1 }; pos_i < pos_ct && !layout.isPaged(); ++pos_i) {
+        size_t tile_i { tile_ct * pos_i / pos_ct };
+        while (tile_i < tile_ct &&
+               layout.tileIsWall(tile_i % layout.w, tile_i / layout.w))
+            ++tile_i;
+        if (tile_i == tile_ct)
+            break;
+        player_pos = { (tile_i % layout.w) + 0.5, (tile_i / layout.w) + 0.5 };
+        addRayErrors(reference_settings, test_settings, turn_ct, report,
+                     dist_err_sum);
+    }
+    uint32_t match_ct { report.ray_ct - report.wall_mismatch_ct };
+    report.mean_dist_err = match_ct ? dist_err_sum / match_ct : 0;
+    player_pos = start_player_pos;
+    player_dir = start_player_dir;
+    view_plane = start_view_plane;
+    return report;
+}
+
+void DdaRaycastEngine::placeCamera(const Vector2d& pos, const Vector2d& dir) {
+    player_pos = pos;
+    player_dir = dir;
+    // view_plane is player_dir turned clockwise
+    view_plane.x = dir.y * view_plane_mag;
+    view_plane.y = -dir.x * view_plane_mag;
 }
 
 void DdaRaycastEngine::playerTurnLeft(const double rot_speed) {
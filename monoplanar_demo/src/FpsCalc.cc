@@ -28,7 +28,7 @@ void RealTimeFpsCalc::initialize() {
 
 void RealTimeFpsCalc::calculate() {
     curr_tp = std::chrono::steady_clock::now();
-    std::chrono::duration<double> frame_duration { curr_tp - prev_tp };
+    frame_duration = curr_tp - prev_tp;
     prev_tp = curr_tp;
     frame_duration_mvg_avg =
         ((frame_duration_mvg_avg * (alpha - 1)) + frame_duration) / alpha;
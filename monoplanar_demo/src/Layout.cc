@@ -2,10 +2,15 @@
 #include "Vector2d.hh"
 
 #include <iostream>
-#include <algorithm>   // max
+#include <algorithm>   // max min
+#include <array>
+#include <cmath>       // floor ceil
+#include <limits>      // numeric_limits
 #include <fstream>     // ifstream
-#include <sstream>     // ostringstream
+#include <sstream>     // ostringstream istringstream
+#include <stdexcept>   // runtime_error
 #include <string>
+#include <utility>     // move
 
 
 void Layout::loadMapFile(const std::string& map_filename, Vector2d& player_pos) {
@@ -16,24 +21,134 @@ void Layout::loadMapFile(const std::string& map_filename, Vector2d& player_pos)
         throw std::runtime_error(err_msg.str());
     }
 
+    lights.clear();
+    pending_tile_edits.clear();
+    segments.clear();
+    tile_segment_offsets.clear();
+    tile_segments.clear();
+    wall_faces.clear();
+    pvs_offsets.clear();
+    pvs_face_is.clear();
+    chunks.reset();
+    if (storage == LayoutStorage::Paged)
+        storage = LayoutStorage::RowMajor;
+    std::string line;
+    if (std::getline(map_ifs, line) &&
+        line == TileChunkCache::CHUNK_MAP_HEADER) {
+        map_ifs.close();
+        loadChunkMapFile(map_filename, player_pos);
+        return;
+    }
+    if (line == SEGMENT_MAP_HEADER) {
+        parseSegmentMap(map_ifs, player_pos);
+    } else {
+        map_ifs.clear();  // reset eof
+        map_ifs.seekg(0);
+        parseTileMap(map_ifs, player_pos);
+    }
+    map_ifs.close();
+    for (const PointLight& light : lights) {
+        if (!(light.x >= 0 && light.x < w && light.y >= 0 && light.y < h) ||
+            tile(light.x, light.y) != 0) {
+            err_msg <<
+                "Light outside of map or inside a wall. Check map file for errors.";
+            throw std::runtime_error(err_msg.str());
+        }
+    }
+    tile_light.assign(size_t(w) * h, LIGHT_LEVEL_ONE);
+
+    if (storage == LayoutStorage::TiledBitmap)
+        buildWallBitmap();
+    buildWallDistanceField();
+    buildOccupancyPyramid();
+    ++edit_ct;
+
+    std::cout << "Parsed map file: " << map_filename << "\n";
+    if (hasSegments()) {
+        std::cout << "Built segment grid: " << segments.size() <<
+            " wall segments, " << tile_segments.size() << " listed in tiles\n";
+    }
+}
+
+void Layout::loadChunkMapFile(const std::string& map_filename,
+                              Vector2d& player_pos) {
+    chunks.reset(new TileChunkCache());
+    chunks->open(map_filename, chunk_budget_mb, player_pos);
+    w = chunks->w;
+    h = chunks->h;
+    storage = LayoutStorage::Paged;
+    // tiles are only in chunks, and the structures derived from them would
+    //   need the whole map in memory
+    map.clear();
+    map.shrink_to_fit();
+    wall_bits.clear();
+    wall_dist.clear();
+    occupancy_levels.clear();
+    tile_light.clear();
+    ++edit_ct;
+
+    std::cout << "Opened chunk map file: " << map_filename << "\n";
+}
+
+bool Layout::pageChunks(const Vector2d& player_pos, const Vector2d& player_dir) {
+    if (storage != LayoutStorage::Paged || !chunks->update(player_pos, player_dir))
+        return false;
+    ++edit_ct;
+    return true;
+}
+
+void Layout::writeChunkMapFile(const std::string& map_filename,
+                               const Vector2d& player_pos) const {
+    // segment walls would be lost to their tiles
+    if (storage == LayoutStorage::Paged || hasSegments()) {
+        std::ostringstream err_msg;
+        err_msg << "Only tile maps can be written as chunk maps";
+        throw std::runtime_error(err_msg.str());
+    }
+    TileChunkCache::writeFile(map_filename, map.data(), w, h, player_pos);
+}
+
+/**
+ * @brief parse a "light x y radius brightness" map file line
+ *
+ * @param line_iss - map file line, at its start
+ * @param light    - set to light, with x and y as given
+ *
+ * @return false if the line is not a well formed light
+ */
+static bool parseLightLine(std::istringstream& line_iss, PointLight& light) {
+    std::string keyword;
+    return bool(line_iss >> keyword >> light.x >> light.y >>
+                light.radius >> light.brightness) &&
+        keyword == "light" && (line_iss >> std::ws).eof() &&
+        light.x >= 0 && light.y >= 0 && light.radius > 0 && light.brightness > 0;
+}
+
+void Layout::parseTileMap(std::ifstream& map_ifs, Vector2d& player_pos) {
+    std::ostringstream err_msg;
     // get raw map grid size
-    uint16_t row_ct { 0 };
-    uint16_t col_ct { 0 };
+    uint32_t row_ct { 0 };
+    uint32_t col_ct { 0 };
     std::string line;
     while (std::getline(map_ifs, line) && line.size()) { // empty lines end map parsing
         ++row_ct;
         // columns set to max width of variable width maps
-        col_ct = std::max(static_cast<uint16_t>(line.size()), col_ct);
+        col_ct = std::max(static_cast<uint32_t>(line.size()), col_ct);
     }
     // prevent unbounded stage by adding tiles for outer perimiter wall
     col_ct += 2;
     row_ct += 2;
+    if (col_ct > MAX_DIM || row_ct > MAX_DIM) {
+        err_msg << "Map larger than " << MAX_DIM << " tiles in either dimension. " <<
+            "Check map file for errors.";
+        throw std::runtime_error(err_msg.str());
+    }
     resize(col_ct, row_ct);
 
     // add N and S perimeter walls
-    for (uint16_t col_i { 0 }; col_i < col_ct; ++col_i) {
-        tile(col_i, 0) = 1;
-        tile(col_i, row_ct - 1) = 1;
+    for (uint32_t col_i { 0 }; col_i < col_ct; ++col_i) {
+        mapTile(col_i, 0) = 1;
+        mapTile(col_i, row_ct - 1) = 1;
     }
 
     bool viable_start_exists { false };
@@ -41,20 +156,20 @@ void Layout::loadMapFile(const std::string& map_filename, Vector2d& player_pos)
     map_ifs.clear();  // reset eof
     map_ifs.seekg(0);
     // y values inverted to convert map file row indices +y to coordinate grid +y
-    for (int16_t row_i ( row_ct - 1 ); row_i >= 0; --row_i) {
+    for (int64_t row_i ( row_ct - 1 ); row_i >= 0; --row_i) {
         // add N and S perimeter walls
         if (row_i == 0 || row_i == row_ct - 1) {
-            for (uint16_t col_i { 0 }; col_i < col_ct; ++col_i)
-                tile(col_i, row_i) = 1;
+            for (uint32_t col_i { 0 }; col_i < col_ct; ++col_i)
+                mapTile(col_i, row_i) = 1;
             continue;
         }
         // add W perimeter wall
-        tile(0, row_i) = 1;
-        uint16_t col_i { 1 };
+        mapTile(0, row_i) = 1;
+        uint32_t col_i { 1 };
         std::getline(map_ifs, line);  // proven to succeed in sizing loop
         // pad out non-rectangular western maze edges on map
         for (; line[col_i - 1] == ' '; ++col_i)  // width of other whitespace unpredictable
-            tile(col_i, row_i) = 1;
+            mapTile(col_i, row_i) = 1;
         // parse map line
         for (; line[col_i - 1]; ++col_i) {
             if (line[col_i - 1] == 'x') {
@@ -67,7 +182,7 @@ void Layout::loadMapFile(const std::string& map_filename, Vector2d& player_pos)
                 viable_start_exists = true;
                 player_pos.x = col_i;  // x
                 player_pos.y = row_i;  // y
-                tile(col_i, row_ct - 1 - row_i) = 0;
+                mapTile(col_i, row_ct - 1 - row_i) = 0;
             } else if (std::isdigit(line[col_i - 1])) {
                 // default start is first empty map tile found
                 //   (most northern, then eastern)
@@ -77,7 +192,7 @@ void Layout::loadMapFile(const std::string& map_filename, Vector2d& player_pos)
                     player_pos.y = row_i;  // y
                 }
                 // TBD: idiomatic conversion to integer?
-                tile(col_i, row_i) = line[col_i - 1] - '0';
+                mapTile(col_i, row_i) = line[col_i - 1] - '0';
             } else {
                 err_msg <<
                     "Unrecognized character in map encoding. Check map file for errors.";
@@ -86,11 +201,10 @@ void Layout::loadMapFile(const std::string& map_filename, Vector2d& player_pos)
         }
         // pad out non-rectangular eastern maze edges on map
         for (; col_i < col_ct - 1; ++col_i)
-            tile(col_i, row_i) = 1;
+            mapTile(col_i, row_i) = 1;
         // add E perimeter wall
-        tile(col_i, row_i) = 1;
+        mapTile(col_i, row_i) = 1;
     }
-    map_ifs.close();
     if (!viable_start_exists) {
         err_msg <<
             "No valid start location possible. Check map file for errors.";
@@ -101,5 +215,1055 @@ void Layout::loadMapFile(const std::string& map_filename, Vector2d& player_pos)
     player_pos.x += 0.5;
     player_pos.y += 0.5;
 
-    std::cout << "Parsed map file: " << map_filename << "\n";
+    // lights follow the empty line ending the map rows
+    for (uint32_t line_i ( row_ct - 1u ); std::getline(map_ifs, line); ++line_i) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream line_iss { line };
+        PointLight light;
+        if (!parseLightLine(line_iss, light)) {
+            err_msg << "Malformed line " << line_i <<
+                " of map. Check map file for errors.";
+            throw std::runtime_error(err_msg.str());
+        }
+        // center of map character, with rows inverted and offset by the
+        //   perimeter walls, as for tiles
+        light.x += 1.5;
+        light.y = row_ct - 1.5 - light.y;
+        lights.push_back(light);
+    }
+}
+
+/**
+ * @brief call func(x, y) for each map tile that a segment passes within
+ *   margin of, clipping the segment to each row of tiles in turn
+ *
+ * @param segment - wall segment
+ * @param margin  - distance tiles are grown by on every side (negative to
+ *                    shrink them, eg to find tiles whose interior is crossed)
+ * @param w       - map width in tiles
+ * @param h       - map height in tiles
+ * @param func    - called for each tile
+ */
+template <typename FuncT>
+static void forEachSegmentTile(const WallSegment& segment, const double margin,
+                               const uint32_t w, const uint32_t h,
+                               FuncT&& func) {
+    const double seg_x { segment.x1 - segment.x0 };
+    const double seg_y { segment.y1 - segment.y0 };
+    const double min_y { std::min(segment.y0, segment.y1) };
+    const double max_y { std::max(segment.y0, segment.y1) };
+    const int32_t begin_row { std::max(0, int32_t(std::floor(min_y - margin))) };
+    const int32_t end_row { std::min(int32_t(h),
+                                     int32_t(std::floor(max_y + margin)) + 1) };
+    for (int32_t row { begin_row }; row < end_row; ++row) {
+        // fractions along segment where it is within the row
+        double along_0 { 0 };
+        double along_1 { 1 };
+        if (seg_y != 0) {
+            along_0 = (row - margin - segment.y0) / seg_y;
+            along_1 = (row + 1 + margin - segment.y0) / seg_y;
+            if (along_0 > along_1)
+                std::swap(along_0, along_1);
+            along_0 = std::max(along_0, 0.0);
+            along_1 = std::min(along_1, 1.0);
+            if (along_0 > along_1)
+                continue;
+        } else if (!(segment.y0 >= row - margin && segment.y0 <= row + 1 + margin)) {
+            continue;
+        }
+        const double x_0 { segment.x0 + (along_0 * seg_x) };
+        const double x_1 { segment.x0 + (along_1 * seg_x) };
+        const int32_t begin_col { std::max(
+            0, int32_t(std::floor(std::min(x_0, x_1) - margin))) };
+        const int32_t end_col { std::min(
+            int32_t(w), int32_t(std::floor(std::max(x_0, x_1) + margin)) + 1) };
+        for (int32_t col { begin_col }; col < end_col; ++col)
+            func(uint32_t(col), uint32_t(row));
+    }
+}
+
+void Layout::parseSegmentMap(std::ifstream& map_ifs, Vector2d& player_pos) {
+    // largest coordinate, leaving room for the perimeter tiles
+    static constexpr double MAX_COORD { MAX_DIM - 2 };
+    std::ostringstream err_msg;
+    bool start_exists { false };
+    // extent of interior of map, in map units
+    double extent_x { 1 };
+    double extent_y { 1 };
+    std::string line;
+    // (header already read)
+    for (uint32_t line_i { 2 }; std::getline(map_ifs, line); ++line_i) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream line_iss { line };
+        std::string keyword;
+        double x0, y0, x1, y1;
+        int32_t tex_key;
+        bool valid;
+        if (line.compare(0, 6, "player") == 0) {
+            if (start_exists) {
+                err_msg <<
+                    "Mulitple start points specified. Check map file for errors.";
+                throw std::runtime_error(err_msg.str());
+            }
+            valid = bool(line_iss >> keyword >> x0 >> y0) &&
+                x0 >= 0 && x0 <= MAX_COORD && y0 >= 0 && y0 <= MAX_COORD;
+            start_exists = true;
+            // +1 to each dim for perimeter tiles
+            player_pos.x = x0 + 1;
+            player_pos.y = y0 + 1;
+            x1 = x0;
+            y1 = y0;
+        } else if (line.compare(0, 5, "light") == 0) {
+            PointLight light;
+            valid = parseLightLine(line_iss, light);
+            // +1 to each dim for perimeter tiles
+            lights.push_back({ light.x + 1, light.y + 1,
+                               light.radius, light.brightness });
+            x0 = x1 = light.x;
+            y0 = y1 = light.y;
+        } else {
+            valid = bool(line_iss >> x0 >> y0 >> x1 >> y1 >> tex_key) &&
+                tex_key >= 1 && tex_key <= 9 &&
+                x0 >= 0 && x0 <= MAX_COORD && y0 >= 0 && y0 <= MAX_COORD &&
+                x1 >= 0 && x1 <= MAX_COORD && y1 >= 0 && y1 <= MAX_COORD &&
+                (x0 != x1 || y0 != y1);
+            if (valid) {
+                segments.push_back({ x0 + 1, y0 + 1, x1 + 1, y1 + 1,
+                                     uint8_t(tex_key) });
+            }
+        }
+        if (!valid || !(line_iss >> std::ws).eof()) {
+            err_msg << "Malformed line " << line_i <<
+                " of segment map. Check map file for errors.";
+            throw std::runtime_error(err_msg.str());
+        }
+        extent_x = std::max({ extent_x, std::ceil(x0), std::ceil(x1) });
+        extent_y = std::max({ extent_y, std::ceil(y0), std::ceil(y1) });
+    }
+    if (!start_exists) {
+        err_msg <<
+            "No valid start location possible. Check map file for errors.";
+        throw std::runtime_error(err_msg.str());
+    }
+
+    // interior tiles span [1, extent + 1) in each dim, inside perimeter tiles
+    resize(uint32_t(extent_x) + 2, uint32_t(extent_y) + 2);
+    std::fill(map.begin(), map.end(), 0);
+    for (uint32_t x { 0 }; x < w; ++x) {
+        mapTile(x, 0) = 1;
+        mapTile(x, h - 1) = 1;
+    }
+    for (uint32_t y { 0 }; y < h; ++y) {
+        mapTile(0, y) = 1;
+        mapTile(w - 1, y) = 1;
+    }
+    // rays stop at segments closing the map along the inside edges of the
+    //   perimeter tiles
+    const double max_x ( w - 1 );
+    const double max_y ( h - 1 );
+    segments.push_back({ 1, 1, max_x, 1, 1 });
+    segments.push_back({ max_x, 1, max_x, max_y, 1 });
+    segments.push_back({ max_x, max_y, 1, max_y, 1 });
+    segments.push_back({ 1, max_y, 1, 1, 1 });
+    for (const WallSegment& segment : segments) {
+        forEachSegmentTile(segment, -SEGMENT_TILE_MARGIN, w, h,
+                           [&](const uint32_t x, const uint32_t y) {
+                               mapTile(x, y) = segment.tex_key; });
+    }
+    if (!(player_pos.x > 1 && player_pos.x < max_x &&
+          player_pos.y > 1 && player_pos.y < max_y) ||
+        tile(player_pos.x, player_pos.y) != 0) {
+        err_msg <<
+            "Start point inside a wall tile. Check map file for errors.";
+        throw std::runtime_error(err_msg.str());
+    }
+
+    buildSegmentGrid();
+}
+
+void Layout::buildSegmentGrid() {
+    // counting sort, as in SpriteGrid::build: count segments per tile, offset
+    //   each tile by the counts before it, then copy segments into place
+    tile_segment_offsets.assign((size_t(w) * h) + 1, 0);
+    for (const WallSegment& segment : segments) {
+        forEachSegmentTile(segment, SEGMENT_TILE_MARGIN, w, h,
+                           [&](const uint32_t x, const uint32_t y) {
+                               ++tile_segment_offsets[tileIndex(x, y) + 1]; });
+    }
+    for (size_t i { 0 }; i < size_t(w) * h; ++i)
+        tile_segment_offsets[i + 1] += tile_segment_offsets[i];
+    tile_segments.resize(tile_segment_offsets[size_t(w) * h]);
+    // next free slot per tile
+    std::vector<uint32_t> tile_ends(tile_segment_offsets.begin(),
+                                    tile_segment_offsets.end() - 1);
+    for (const WallSegment& segment : segments) {
+        forEachSegmentTile(segment, SEGMENT_TILE_MARGIN, w, h,
+                           [&](const uint32_t x, const uint32_t y) {
+                               tile_segments[tile_ends[tileIndex(x, y)]++] = segment; });
+    }
+}
+
+void Layout::buildWallBitmap() {
+    wall_blocks_w = (w + WALL_BLOCK_MASK) >> WALL_BLOCK_LOG2;
+    const uint32_t wall_blocks_h ( (h + WALL_BLOCK_MASK) >> WALL_BLOCK_LOG2 );
+    wall_bits.assign(size_t(wall_blocks_w) * wall_blocks_h, 0);
+    for (uint32_t y { 0 }; y < h; ++y) {
+        for (uint32_t x { 0 }; x < w; ++x) {
+            if (map[tileIndex(x, y)] == 0)
+                continue;
+            wall_bits[(size_t(y >> WALL_BLOCK_LOG2) * wall_blocks_w) +
+                      (x >> WALL_BLOCK_LOG2)] |=
+                uint64_t(1) << (((y & WALL_BLOCK_MASK) << WALL_BLOCK_LOG2) |
+                                (x & WALL_BLOCK_MASK));
+        }
+    }
+}
+
+void Layout::buildWallDistanceField() {
+    constexpr uint8_t MAX_DIST { 255 };
+    wall_dist.resize(map.size());
+    for (size_t i { 0 }; i < map.size(); ++i)
+        wall_dist[i] = (map[i] != 0) ? 0 : MAX_DIST;
+    // Chebyshev distance grows by 1 to each of the 8 neighboring tiles, so a
+    //   forward pass propagating from the 4 already visited neighbors (W, SW, S,
+    //   SE) and a backward pass from the other 4 (E, NE, N, NW) is exact.
+    //   Perimeter tiles are always walls, so neighbors are always in bounds.
+    for (uint32_t y { 1 }; y < h - 1; ++y) {
+        for (uint32_t x { 1 }; x < w - 1; ++x) {
+            uint8_t& dist { wall_dist[tileIndex(x, y)] };
+            for (const size_t n_i : { tileIndex(x - 1, y), tileIndex(x - 1, y - 1),
+                                      tileIndex(x, y - 1), tileIndex(x + 1, y - 1) }) {
+                dist = std::min(dist, uint8_t(std::min(wall_dist[n_i] + 1,
+                                                       int(MAX_DIST))));
+            }
+        }
+    }
+    for (uint32_t y ( h - 2 ); y > 0; --y) {
+        for (uint32_t x ( w - 2 ); x > 0; --x) {
+            uint8_t& dist { wall_dist[tileIndex(x, y)] };
+            for (const size_t n_i : { tileIndex(x + 1, y), tileIndex(x + 1, y + 1),
+                                      tileIndex(x, y + 1), tileIndex(x - 1, y + 1) }) {
+                dist = std::min(dist, uint8_t(std::min(wall_dist[n_i] + 1,
+                                                       int(MAX_DIST))));
+            }
+        }
+    }
+}
+
+void Layout::buildOccupancyPyramid() {
+    constexpr uint8_t CHILD_W { 1 << OCCUPANCY_LEVEL_LOG2 };
+    occupancy_levels.clear();
+    // level below the first is the map itself, as blocks of 1 tile
+    uint32_t child_w { w };
+    uint32_t child_h { h };
+    do {
+        OccupancyLevel level;
+        level.w = (child_w + CHILD_W - 1) / CHILD_W;
+        level.h = (child_h + CHILD_W - 1) / CHILD_W;
+        level.occupied.assign(size_t(level.w) * level.h, 0);
+        const OccupancyLevel* child_level {
+            occupancy_levels.empty() ? nullptr : &occupancy_levels.back() };
+        for (uint32_t child_y { 0 }; child_y < child_h; ++child_y) {
+            for (uint32_t child_x { 0 }; child_x < child_w; ++child_x) {
+                const bool child_occupied { child_level ?
+                    child_level->occupied[(size_t(child_y) * child_w) + child_x] != 0 :
+                    tileIsWall(child_x, child_y) };
+                if (child_occupied) {
+                    level.occupied[(size_t(child_y / CHILD_W) * level.w) +
+                                   (child_x / CHILD_W)] = 1;
+                }
+            }
+        }
+        child_w = level.w;
+        child_h = level.h;
+        occupancy_levels.push_back(std::move(level));
+    } while (child_w > 1 || child_h > 1);
+}
+
+
+TileRect Layout::lightTiles(const PointLight& light) const {
+    // (clamped before narrowing, as for SpriteGrid::forEachNear)
+    return { uint32_t(std::max(0.0, light.x - light.radius)),
+             uint32_t(std::max(0.0, light.y - light.radius)),
+             uint32_t(std::min(double(w), light.x + light.radius + 1)),
+             uint32_t(std::min(double(h), light.y + light.radius + 1)) };
+}
+
+void Layout::queueTileEdit(const uint32_t x, const uint32_t y,
+                           const uint8_t tex_key) {
+    std::ostringstream err_msg;
+    if (hasSegments()) {
+        err_msg << "Tiles of segment maps cannot be edited";
+        throw std::runtime_error(err_msg.str());
+    }
+    if (storage == LayoutStorage::Paged) {
+        err_msg << "Tiles of chunk maps cannot be edited";
+        throw std::runtime_error(err_msg.str());
+    }
+    if (!(x > 0 && x < w - 1 && y > 0 && y < h - 1) || tex_key > 9) {
+        err_msg << "Invalid tile edit: (" << x << ", " << y << ") to " <<
+            int(tex_key) << " on " << w << "x" << h << " map";
+        throw std::runtime_error(err_msg.str());
+    }
+    pending_tile_edits.push_back({ x, y, tex_key });
+}
+
+bool Layout::applyTileEdits(TileRect& dirty, ThreadPool& thread_pool) {
+    std::vector<size_t> removed_is;
+    std::vector<size_t> added_is;
+    dirty = { w, h, 0, 0 };
+    for (const TileEdit& edit : pending_tile_edits) {
+        uint8_t& tex_key { mapTile(edit.x, edit.y) };
+        if (tex_key == edit.tex_key)
+            continue;
+        const size_t tile_i { tileIndex(edit.x, edit.y) };
+        // walls removed then added again in one batch (or the reverse) are
+        //   left in both lists, which updateWallDistanceField allows for
+        if (tex_key != 0 && edit.tex_key == 0)
+            removed_is.push_back(tile_i);
+        else if (tex_key == 0 && edit.tex_key != 0)
+            added_is.push_back(tile_i);
+        tex_key = edit.tex_key;
+        dirty.x0 = std::min(dirty.x0, edit.x);
+        dirty.y0 = std::min(dirty.y0, edit.y);
+        dirty.x1 = std::max(dirty.x1, uint32_t(edit.x + 1));
+        dirty.y1 = std::max(dirty.y1, uint32_t(edit.y + 1));
+    }
+    pending_tile_edits.clear();
+    if (!(dirty.x0 < dirty.x1))
+        return false;
+
+    // texture changes leave wall flags as they were
+    for (const std::vector<size_t>* tile_is : { &removed_is, &added_is }) {
+        for (const size_t tile_i : *tile_is) {
+            const uint32_t x ( tile_i % w );
+            const uint32_t y ( tile_i / w );
+            if (storage == LayoutStorage::TiledBitmap) {
+                const uint64_t bit { uint64_t(1) <<
+                    (((y & WALL_BLOCK_MASK) << WALL_BLOCK_LOG2) |
+                     (x & WALL_BLOCK_MASK)) };
+                uint64_t& block { wall_bits[(size_t(y >> WALL_BLOCK_LOG2) *
+                                             wall_blocks_w) +
+                                            (x >> WALL_BLOCK_LOG2)] };
+                block = (map[tile_i] != 0) ? (block | bit) : (block & ~bit);
+            }
+            updateOccupancy(x, y);
+        }
+    }
+    updateWallDistanceField(removed_is, added_is);
+    if (hasPvs() && !(removed_is.empty() && added_is.empty())) {
+        std::vector<size_t> changed_is { removed_is };
+        changed_is.insert(changed_is.end(), added_is.begin(), added_is.end());
+        updatePotentiallyVisibleSets(changed_is, thread_pool);
+    }
+    ++edit_ct;
+    return true;
+}
+
+void Layout::updateWallDistanceField(const std::vector<size_t>& removed_is,
+                                     const std::vector<size_t>& added_is) {
+    constexpr uint8_t MAX_DIST { 255 };
+    // Perimeter tiles are never edited and always walls, so never change
+    //   distance, and the 8 neighbors of any tile that does are in bounds.
+    const int64_t w_i ( w );
+    const std::array<int64_t, 8> neighbor_offsets {
+        -1, 1, -w_i, w_i, -w_i - 1, -w_i + 1, w_i - 1, w_i + 1 };
+    // Raise: a tile may have measured its distance through a neighbor one
+    //   less, so starting from removed walls, such tiles are reset to
+    //   MAX_DIST, with their previous distance kept to continue from. Removing
+    //   walls only raises distances, so tiles at MAX_DIST stay there.
+    std::vector<std::pair<size_t, uint8_t>> reset;
+    for (const size_t tile_i : removed_is) {
+        // (walls added back in the same batch stay walls, and walls removed
+        //   twice are reset once)
+        if (map[tile_i] != 0 || wall_dist[tile_i] != 0)
+            continue;
+        reset.push_back({ tile_i, 0 });
+        wall_dist[tile_i] = MAX_DIST;
+    }
+    for (uint32_t reset_i { 0 }; reset_i < reset.size(); ++reset_i) {
+        const auto [tile_i, prev_dist] = reset[reset_i];
+        if (prev_dist + 1 >= MAX_DIST)
+            continue;
+        for (const int64_t offset : neighbor_offsets) {
+            const size_t n_i ( tile_i + offset );
+            if (wall_dist[n_i] != prev_dist + 1)
+                continue;
+            reset.push_back({ n_i, wall_dist[n_i] });
+            wall_dist[n_i] = MAX_DIST;
+        }
+    }
+    // Lower: added walls, and reset tiles measured from the tiles around
+    //   them, lower their neighbors in order of distance, with a bucket of
+    //   tiles per distance.
+    std::vector<std::vector<size_t>> buckets(MAX_DIST);
+    for (const size_t tile_i : added_is) {
+        if (map[tile_i] == 0)
+            continue;
+        wall_dist[tile_i] = 0;
+        buckets[0].push_back(tile_i);
+    }
+    for (const auto& reset_tile : reset) {
+        const size_t tile_i { reset_tile.first };
+        uint8_t& dist { wall_dist[tile_i] };
+        for (const int64_t offset : neighbor_offsets) {
+            dist = std::min(dist, uint8_t(std::min(wall_dist[tile_i + offset] + 1,
+                                                   int(MAX_DIST))));
+        }
+        if (dist < MAX_DIST)
+            buckets[dist].push_back(tile_i);
+    }
+    for (uint32_t dist { 0 }; dist < MAX_DIST; ++dist) {
+        const uint8_t next_dist ( dist + 1 );
+        // (buckets of later distances grow as this one is visited)
+        for (const size_t tile_i : buckets[dist]) {
+            // tiles lowered again after being bucketed are left to their
+            //   lower bucket
+            if (wall_dist[tile_i] != dist)
+                continue;
+            for (const int64_t offset : neighbor_offsets) {
+                const size_t n_i ( tile_i + offset );
+                if (wall_dist[n_i] <= next_dist)
+                    continue;
+                wall_dist[n_i] = next_dist;
+                if (next_dist < MAX_DIST)
+                    buckets[next_dist].push_back(n_i);
+            }
+        }
+    }
+}
+
+void Layout::updateOccupancy(const uint32_t x, const uint32_t y) {
+    constexpr uint8_t CHILD_W { 1 << OCCUPANCY_LEVEL_LOG2 };
+    // level below the first is the map itself, as blocks of 1 tile
+    uint32_t child_w { w };
+    uint32_t child_h { h };
+    for (uint8_t level_i { 0 }; level_i < occupancy_levels.size(); ++level_i) {
+        OccupancyLevel& level { occupancy_levels[level_i] };
+        const OccupancyLevel* child_level {
+            level_i > 0 ? &occupancy_levels[level_i - 1] : nullptr };
+        const uint8_t level_log2 ( (level_i + 1) * OCCUPANCY_LEVEL_LOG2 );
+        const uint32_t block_x ( x >> level_log2 );
+        const uint32_t block_y ( y >> level_log2 );
+        // reduce block's children, as in buildOccupancyPyramid
+        const uint32_t end_child_x { std::min((block_x + 1u) * CHILD_W, child_w) };
+        const uint32_t end_child_y { std::min((block_y + 1u) * CHILD_W, child_h) };
+        uint8_t occupied { 0 };
+        for (uint32_t child_y ( block_y * CHILD_W ); child_y < end_child_y; ++child_y) {
+            for (uint32_t child_x ( block_x * CHILD_W ); child_x < end_child_x;
+                 ++child_x) {
+                occupied |= child_level ?
+                    child_level->occupied[(size_t(child_y) * child_w) + child_x] :
+                    uint8_t(tileIsWall(child_x, child_y));
+            }
+        }
+        uint8_t& block_occupied { level.occupied[
+            (size_t(block_y) * level.w) + block_x] };
+        if (block_occupied == occupied)
+            break;
+        block_occupied = occupied;
+        child_w = level.w;
+        child_h = level.h;
+    }
+}
+
+// Potentially visible set building
+//
+// A face is seen from an empty tile if some segment from a point in the tile
+//   to a point on the face passes through no wall tile interior. Such a
+//   segment leaves the tile through one of its edges, so each edge facing the
+//   face is tested against it as a pair of segments: visible as soon as the
+//   segment between their midpoints is clear, and hidden if one wall run
+//   stands across every segment between them, else halved into four pairs.
+// Only faces that a segment from the tile could reach at all are tested: each
+//   tile a clear segment passes through is empty and a step in x, y or both
+//   (through a corner) from the one before, in the directions of the
+//   segment, so the segment ends at a face from a tile reached by such steps.
+
+void Layout::reachTiles(const uint32_t x, const uint32_t y,
+                        std::vector<uint8_t>& reach) const {
+    reach.assign(map.size(), 0);
+    for (uint8_t quadrant { 0 }; quadrant < 4; ++quadrant) {
+        const uint8_t bit ( 1 << quadrant );
+        const int64_t step_x { (quadrant & 1) ? -1 : 1 };
+        const int64_t step_y { (quadrant & 2) ? -1 : 1 };
+        // rows and columns of the quadrant, including those of (x, y)
+        const uint32_t col_ct { (quadrant & 1) ? x + 1 : w - x };
+        const uint32_t row_ct { (quadrant & 2) ? y + 1 : h - y };
+        // one past the last column reached in the row before: tiles of a row
+        //   beyond it are only reached from the tile before them in the row
+        uint32_t prev_end_col { 0 };
+        for (uint32_t row { 0 }; row < row_ct; ++row) {
+            const uint32_t tile_y ( y + (step_y * row) );
+            const uint32_t prev_tile_y ( tile_y - step_y );
+            uint32_t end_col { 0 };
+            // whether the tile before in the row was reached
+            bool prev_col_reached { false };
+            for (uint32_t col { 0 }; col < col_ct; ++col) {
+                const uint32_t tile_x ( x + (step_x * col) );
+                bool reached { prev_col_reached };
+                if (row == 0) {
+                    reached = reached || col == 0;
+                } else if (col <= prev_end_col) {
+                    reached = reached ||
+                        (col < prev_end_col &&
+                         (reach[tileIndex(tile_x, prev_tile_y)] & bit)) ||
+                        (col > 0 &&
+                         (reach[tileIndex(tile_x - step_x, prev_tile_y)] & bit));
+                } else if (!reached) {
+                    break;
+                }
+                prev_col_reached = reached && !tileIsWall(tile_x, tile_y);
+                if (prev_col_reached) {
+                    reach[tileIndex(tile_x, tile_y)] |= bit;
+                    end_col = col + 1;
+                }
+            }
+            if (end_col == 0)
+                break;
+            prev_end_col = end_col;
+        }
+    }
+}
+
+template <typename WallFunc>
+bool Layout::segmentClear(const Vector2d& a, const Vector2d& b,
+                          WallFunc&& on_wall) const {
+    bool clear { true };
+    const double dx { b.x - a.x };
+    const double dy { b.y - a.y };
+    // grid lines are crossed in order of t along a + t * (b - a), and each
+    //   interval between crossings lies in one tile, found from its midpoint
+    constexpr double NO_CROSSING { std::numeric_limits<double>::infinity() };
+    const int32_t step_x { dx > 0 ? 1 : -1 };
+    const int32_t step_y { dy > 0 ? 1 : -1 };
+    int32_t line_x ( dx > 0 ? std::floor(a.x) + 1 : std::ceil(a.x) - 1 );
+    int32_t line_y ( dy > 0 ? std::floor(a.y) + 1 : std::ceil(a.y) - 1 );
+    double t_x { dx != 0 ? (line_x - a.x) / dx : NO_CROSSING };
+    double t_y { dy != 0 ? (line_y - a.y) / dy : NO_CROSSING };
+    double t { 0 };
+    while (t < 1) {
+        double t_next { std::min({ t_x, t_y, 1.0 }) };
+        const double t_mid { (t + t_next) / 2 };
+        const uint32_t x ( std::floor(a.x + (dx * t_mid)) );
+        const uint32_t y ( std::floor(a.y + (dy * t_mid)) );
+        if (t_next > t && tileIsWall(x, y)) {
+            clear = false;
+            if (on_wall(uint32_t(tileIndex(x, y))))
+                break;
+        } else if (const uint8_t radius { emptyRadius(x, y) }) {
+            // skip to where the segment leaves the square of empty tiles
+            //   around (x, y)
+            const double exit_x ( dx > 0 ? x + radius + 1 : x - radius );
+            const double exit_y ( dy > 0 ? y + radius + 1 : y - radius );
+            t_next = std::max(t_next, std::min({
+                dx != 0 ? (exit_x - a.x) / dx : NO_CROSSING,
+                dy != 0 ? (exit_y - a.y) / dy : NO_CROSSING, 1.0 }));
+        }
+        while (t_x <= t_next) {
+            line_x += step_x;
+            t_x = (line_x - a.x) / dx;
+        }
+        while (t_y <= t_next) {
+            line_y += step_y;
+            t_y = (line_y - a.y) / dy;
+        }
+        t = t_next;
+    }
+    return clear;
+}
+
+bool Layout::runBlocksAll(const WallRun& run,
+                          const Vector2d& a0, const Vector2d& a1,
+                          const Vector2d& b0, const Vector2d& b1) {
+    // Any segment through the interior of a rectangle, with both ends
+    //   outside it, crosses one of its open diagonals. Every segment between
+    //   a and b crosses a diagonal if a and b lie on opposite sides of its
+    //   line, and the four segments between their ends cross it inside its
+    //   ends, as the rest cross the line between those crossings.
+    constexpr double EPSILON { 1e-9 };
+    const auto cross { [](const double ux, const double uy,
+                          const double vx, const double vy) {
+        return (ux * vy) - (uy * vx); } };
+    for (const auto& diag : {
+            std::pair<Vector2d, Vector2d> { { double(run.x0), double(run.y0) },
+                                            { double(run.x1), double(run.y1) } },
+            std::pair<Vector2d, Vector2d> { { double(run.x0), double(run.y1) },
+                                            { double(run.x1), double(run.y0) } } }) {
+        const Vector2d& d0 { diag.first };
+        const double ddx { diag.second.x - d0.x };
+        const double ddy { diag.second.y - d0.y };
+        const auto side { [&](const Vector2d& p) {
+            return cross(ddx, ddy, p.x - d0.x, p.y - d0.y); } };
+        const double side_a0 { side(a0) };
+        const double side_a1 { side(a1) };
+        const double side_b0 { side(b0) };
+        const double side_b1 { side(b1) };
+        if (!((side_a0 > EPSILON && side_a1 > EPSILON &&
+               side_b0 < -EPSILON && side_b1 < -EPSILON) ||
+              (side_a0 < -EPSILON && side_a1 < -EPSILON &&
+               side_b0 > EPSILON && side_b1 > EPSILON)))
+            continue;
+        bool all_inside { true };
+        for (const Vector2d* a : { &a0, &a1 }) {
+            for (const Vector2d* b : { &b0, &b1 }) {
+                const double ex { b->x - a->x };
+                const double ey { b->y - a->y };
+                // fraction of the way along the diagonal of the crossing
+                const double u { cross(ex, ey, a->x - d0.x, a->y - d0.y) /
+                                 cross(ex, ey, ddx, ddy) };
+                all_inside = all_inside && u > EPSILON && u < 1 - EPSILON;
+            }
+        }
+        if (all_inside)
+            return true;
+    }
+    return false;
+}
+
+bool Layout::segmentsMaySee(const Vector2d& a0, const Vector2d& a1,
+                            const Vector2d& b0, const Vector2d& b1,
+                            const uint8_t depth) const {
+    const Vector2d a_mid { (a0.x + a1.x) / 2, (a0.y + a1.y) / 2 };
+    const Vector2d b_mid { (b0.x + b1.x) / 2, (b0.y + b1.y) / 2 };
+    // any run blocking every segment must block the middle one, and is
+    //   tested once, when first crossed
+    bool blocked { false };
+    uint32_t prev_row_run_i { UINT32_MAX };
+    uint32_t prev_col_run_i { UINT32_MAX };
+    if (segmentClear(a_mid, b_mid, [&](const uint32_t wall_i) {
+            const uint32_t row_run_i { tile_row_run_is[wall_i] };
+            const uint32_t col_run_i { tile_col_run_is[wall_i] };
+            blocked =
+                (row_run_i != prev_row_run_i &&
+                 runBlocksAll(wall_runs[row_run_i], a0, a1, b0, b1)) ||
+                (col_run_i != prev_col_run_i &&
+                 runBlocksAll(wall_runs[col_run_i], a0, a1, b0, b1));
+            prev_row_run_i = row_run_i;
+            prev_col_run_i = col_run_i;
+            return blocked; }))
+        return true;
+    if (blocked)
+        return false;
+    if (depth == PVS_MAX_SPLIT_DEPTH)
+        return true;
+    for (const auto& a : { std::pair<Vector2d, Vector2d> { a0, a_mid },
+                           std::pair<Vector2d, Vector2d> { a_mid, a1 } }) {
+        for (const auto& b : { std::pair<Vector2d, Vector2d> { b0, b_mid },
+                               std::pair<Vector2d, Vector2d> { b_mid, b1 } }) {
+            if (segmentsMaySee(a.first, a.second, b.first, b.second, depth + 1))
+                return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief ends of a wall face segment, and the tile just in front of it
+ *
+ * @param face               - wall face
+ * @param f0, f1             - set to face segment ends in map coordinates
+ * @param front_x, front_y   - set to tile in front of face
+ */
+static void faceGeometry(const WallTileFace& face, Vector2d& f0, Vector2d& f1,
+                         int64_t& front_x, int64_t& front_y) {
+    front_x = face.x;
+    front_y = face.y;
+    switch (face.side) {
+    case TileSide::N:
+        f0 = { double(face.x), double(face.y + 1) };
+        f1 = { double(face.x + 1), double(face.y + 1) };
+        ++front_y;
+        break;
+    case TileSide::S:
+        f0 = { double(face.x), double(face.y) };
+        f1 = { double(face.x + 1), double(face.y) };
+        --front_y;
+        break;
+    case TileSide::E:
+        f0 = { double(face.x + 1), double(face.y) };
+        f1 = { double(face.x + 1), double(face.y + 1) };
+        ++front_x;
+        break;
+    case TileSide::W:
+    default:
+        f0 = { double(face.x), double(face.y) };
+        f1 = { double(face.x), double(face.y + 1) };
+        --front_x;
+        break;
+    }
+}
+
+bool Layout::sightMayCross(const uint32_t x, const uint32_t y,
+                           const WallTileFace& face,
+                           const uint32_t cross_x, const uint32_t cross_y) {
+    Vector2d f0;
+    Vector2d f1;
+    int64_t front_x;
+    int64_t front_y;
+    faceGeometry(face, f0, f1, front_x, front_y);
+    // Separating axes: the hull's edges are edges of the tile, the face, or
+    //   lines from a face end to a tile corner, and the crossed tile's edges
+    //   are along x and y, which the tile's and face's are also. Touching
+    //   counts as meeting, as segments along tile edges count as passing
+    //   through one of the tiles beside them.
+    const std::array<Vector2d, 6> hull_points { {
+        { double(x), double(y) }, { double(x + 1), double(y) },
+        { double(x), double(y + 1) }, { double(x + 1), double(y + 1) },
+        f0, f1 } };
+    const std::array<Vector2d, 4> cross_corners { {
+        { double(cross_x), double(cross_y) }, { double(cross_x + 1), double(cross_y) },
+        { double(cross_x), double(cross_y + 1) },
+        { double(cross_x + 1), double(cross_y + 1) } } };
+    const auto separated { [&](const double axis_x, const double axis_y) {
+        double hull_min { std::numeric_limits<double>::infinity() };
+        double hull_max { -hull_min };
+        double cross_min { hull_min };
+        double cross_max { hull_max };
+        for (const Vector2d& p : hull_points) {
+            const double along { (p.x * axis_x) + (p.y * axis_y) };
+            hull_min = std::min(hull_min, along);
+            hull_max = std::max(hull_max, along);
+        }
+        for (const Vector2d& p : cross_corners) {
+            const double along { (p.x * axis_x) + (p.y * axis_y) };
+            cross_min = std::min(cross_min, along);
+            cross_max = std::max(cross_max, along);
+        }
+        return hull_max < cross_min || cross_max < hull_min; } };
+    if (separated(1, 0) || separated(0, 1))
+        return false;
+    for (const Vector2d* end : { &f0, &f1 }) {
+        for (uint8_t corner_i { 0 }; corner_i < 4; ++corner_i) {
+            const Vector2d& corner { hull_points[corner_i] };
+            if (separated(end->y - corner.y, corner.x - end->x))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool Layout::tileMaySeeFace(const uint32_t x, const uint32_t y,
+                            const WallTileFace& face) const {
+    // face segment, and the tile just in front of it
+    Vector2d f0;
+    Vector2d f1;
+    int64_t front_x;
+    int64_t front_y;
+    faceGeometry(face, f0, f1, front_x, front_y);
+    // tile must reach in front of the face
+    const int64_t tile_x { x };
+    const int64_t tile_y { y };
+    if ((face.side == TileSide::N && tile_y < front_y) ||
+        (face.side == TileSide::S && tile_y > front_y) ||
+        (face.side == TileSide::E && tile_x < front_x) ||
+        (face.side == TileSide::W && tile_x > front_x))
+        return false;
+    if (tile_x == front_x && tile_y == front_y)
+        return true;
+    // tile edges with part of the face on or beyond them
+    const Vector2d sw { double(x), double(y) };
+    const Vector2d se { double(x + 1), double(y) };
+    const Vector2d nw { double(x), double(y + 1) };
+    const Vector2d ne { double(x + 1), double(y + 1) };
+    return (std::max(f0.y, f1.y) >= y + 1 && segmentsMaySee(nw, ne, f0, f1, 0)) ||
+        (std::min(f0.y, f1.y) <= y && segmentsMaySee(sw, se, f0, f1, 0)) ||
+        (std::max(f0.x, f1.x) >= x + 1 && segmentsMaySee(se, ne, f0, f1, 0)) ||
+        (std::min(f0.x, f1.x) <= x && segmentsMaySee(sw, nw, f0, f1, 0));
+}
+
+std::vector<WallTileFace> Layout::findWallFaces() const {
+    // perimeter tiles are always walls, so faces of inner wall tiles and
+    //   faces bordering inner tiles are all that need checking
+    std::vector<WallTileFace> faces;
+    for (uint32_t y { 0 }; y < h; ++y) {
+        for (uint32_t x { 0 }; x < w; ++x) {
+            if (!tileIsWall(x, y))
+                continue;
+            if (y + 1 < h && !tileIsWall(x, y + 1))
+                faces.push_back({ x, y, TileSide::N });
+            if (y > 0 && !tileIsWall(x, y - 1))
+                faces.push_back({ x, y, TileSide::S });
+            if (x + 1 < w && !tileIsWall(x + 1, y))
+                faces.push_back({ x, y, TileSide::E });
+            if (x > 0 && !tileIsWall(x - 1, y))
+                faces.push_back({ x, y, TileSide::W });
+        }
+    }
+    return faces;
+}
+
+void Layout::buildWallRuns() {
+    wall_runs.clear();
+    tile_row_run_is.assign(map.size(), 0);
+    tile_col_run_is.assign(map.size(), 0);
+    for (uint32_t y { 0 }; y < h; ++y) {
+        for (uint32_t x { 0 }; x < w; ++x) {
+            if (!tileIsWall(x, y))
+                continue;
+            if (x == 0 || !tileIsWall(x - 1, y)) {
+                uint32_t x1 ( x + 1 );
+                for (; x1 < w && tileIsWall(x1, y); ++x1) {}
+                wall_runs.push_back({ x, y, x1, uint32_t(y + 1) });
+            }
+            tile_row_run_is[tileIndex(x, y)] = wall_runs.size() - 1;
+        }
+    }
+    for (uint32_t x { 0 }; x < w; ++x) {
+        for (uint32_t y { 0 }; y < h; ++y) {
+            if (!tileIsWall(x, y))
+                continue;
+            if (y == 0 || !tileIsWall(x, y - 1)) {
+                uint32_t y1 ( y + 1 );
+                for (; y1 < h && tileIsWall(x, y1); ++y1) {}
+                wall_runs.push_back({ x, y, uint32_t(x + 1), y1 });
+            }
+            tile_col_run_is[tileIndex(x, y)] = wall_runs.size() - 1;
+        }
+    }
+}
+
+void Layout::buildPotentiallyVisibleSets(ThreadPool& thread_pool) {
+    // potentially visible sets are of tile faces, so of no use for segments
+    if (hasSegments() || storage == LayoutStorage::Paged)
+        return;
+    std::ostringstream err_msg;
+    // (in size_t, as w * h may not fit in 32 bits)
+    if (size_t(w) * h > PVS_MAX_TILE_CT) {
+        err_msg << "Map too large to build potentially visible sets (" <<
+            w << "x" << h << " tiles, limit " << PVS_MAX_TILE_CT << ")";
+        throw std::runtime_error(err_msg.str());
+    }
+    wall_faces.clear();
+    pvs_offsets.clear();
+    pvs_face_is.clear();
+    updatePotentiallyVisibleSets({}, thread_pool);
+    std::cout << "Built potentially visible sets: " << wall_faces.size() <<
+        " wall faces, " << pvs_face_is.size() << " visible from all tiles\n";
+}
+
+void Layout::writePvsFile(const std::string& pvs_filename) const {
+    std::ostringstream err_msg;
+    if (!hasPvs()) {
+        err_msg << "No potentially visible sets to write";
+        throw std::runtime_error(err_msg.str());
+    }
+    std::ofstream pvs_ofs(pvs_filename, std::ios::binary);
+    if (!pvs_ofs.is_open()) {
+        err_msg << "Could not open potentially visible sets file for writing: " <<
+            pvs_filename;
+        throw std::runtime_error(err_msg.str());
+    }
+    pvs_ofs << PVS_FILE_HEADER << "\n" <<
+        w << " " << h << " " << wall_faces.size() << " " <<
+        pvs_face_is.size() << "\n";
+    std::vector<uint8_t> walls(map.size());
+    for (size_t tile_i { 0 }; tile_i < map.size(); ++tile_i)
+        walls[tile_i] = map[tile_i] != 0;
+    pvs_ofs.write(reinterpret_cast<const char*>(walls.data()), walls.size());
+    pvs_ofs.write(reinterpret_cast<const char*>(pvs_offsets.data()),
+                  pvs_offsets.size() * sizeof(uint32_t));
+    pvs_ofs.write(reinterpret_cast<const char*>(pvs_face_is.data()),
+                  pvs_face_is.size() * sizeof(uint32_t));
+    if (!pvs_ofs) {
+        err_msg << "Could not write potentially visible sets file: " <<
+            pvs_filename;
+        throw std::runtime_error(err_msg.str());
+    }
+}
+
+bool Layout::readPvsFile(const std::string& pvs_filename) {
+    if (hasSegments() || storage == LayoutStorage::Paged)
+        return false;
+    std::ifstream pvs_ifs(pvs_filename, std::ios::binary);
+    if (!pvs_ifs.is_open())
+        return false;
+    std::ostringstream err_msg;
+    std::string line;
+    uint64_t file_w { 0 }, file_h { 0 }, face_ct { 0 }, visible_ct { 0 };
+    if (!std::getline(pvs_ifs, line) || line != PVS_FILE_HEADER ||
+        !std::getline(pvs_ifs, line) ||
+        !(std::istringstream(line) >> file_w >> file_h >> face_ct >> visible_ct)) {
+        err_msg << "Malformed potentially visible sets file header, expected \"" <<
+            PVS_FILE_HEADER << "\" then \"w h face_ct visible_ct\": " <<
+            pvs_filename;
+        throw std::runtime_error(err_msg.str());
+    }
+    // sets of other tiles (eg from before the map file was edited) are
+    //   left to be built again
+    bool same_walls { file_w == w && file_h == h };
+    std::vector<uint8_t> walls(same_walls ? map.size() : 0);
+    pvs_ifs.read(reinterpret_cast<char*>(walls.data()), walls.size());
+    if (!pvs_ifs) {
+        err_msg << "Potentially visible sets file truncated: " << pvs_filename;
+        throw std::runtime_error(err_msg.str());
+    }
+    for (size_t tile_i { 0 }; same_walls && tile_i < map.size(); ++tile_i)
+        same_walls = walls[tile_i] == (map[tile_i] != 0);
+    if (!same_walls) {
+        std::cout << "Potentially visible sets file " << pvs_filename <<
+            " is of other tiles, ignored\n";
+        return false;
+    }
+    std::vector<WallTileFace> faces { findWallFaces() };
+    // (no more faces listed than every face from every tile)
+    const bool sized { face_ct == faces.size() &&
+                       visible_ct <= map.size() * faces.size() &&
+                       visible_ct <= UINT32_MAX };
+    std::vector<uint32_t> offsets(map.size() + 1);
+    std::vector<uint32_t> face_is(sized ? visible_ct : 0);
+    pvs_ifs.read(reinterpret_cast<char*>(offsets.data()),
+                 offsets.size() * sizeof(uint32_t));
+    pvs_ifs.read(reinterpret_cast<char*>(face_is.data()),
+                 face_is.size() * sizeof(uint32_t));
+    bool valid { sized && pvs_ifs && offsets[0] == 0 &&
+                 offsets[map.size()] == visible_ct };
+    for (size_t tile_i { 0 }; valid && tile_i < map.size(); ++tile_i)
+        valid = offsets[tile_i] <= offsets[tile_i + 1];
+    for (size_t i { 0 }; valid && i < face_is.size(); ++i)
+        valid = face_is[i] < face_ct;
+    if (!valid) {
+        err_msg << "Potentially visible sets file truncated or inconsistent " <<
+            "with its tiles: " << pvs_filename;
+        throw std::runtime_error(err_msg.str());
+    }
+    wall_faces = std::move(faces);
+    pvs_offsets = std::move(offsets);
+    pvs_face_is = std::move(face_is);
+    std::cout << "Read potentially visible sets file: " << pvs_filename << "\n";
+    return true;
+}
+
+void Layout::updatePotentiallyVisibleSets(const std::vector<size_t>& changed_is,
+                                          ThreadPool& thread_pool) {
+    // lists are only kept when there are some to keep
+    const bool keep_lists { hasPvs() };
+    std::vector<WallTileFace> faces { findWallFaces() };
+    // index in faces of each face of wall_faces, or NO_FACE if it is gone;
+    //   both are in map order, with the sides of a tile in TileSide order
+    constexpr uint32_t NO_FACE { UINT32_MAX };
+    std::vector<uint32_t> kept_face_is;
+    // faces not in wall_faces
+    std::vector<bool> face_added(faces.size(), true);
+    if (keep_lists) {
+        const auto face_order { [this](const WallTileFace& face) {
+            return std::make_pair(tileIndex(face.x, face.y), face.side); } };
+        kept_face_is.assign(wall_faces.size(), NO_FACE);
+        uint32_t face_i { 0 };
+        for (uint32_t old_face_i { 0 }; old_face_i < wall_faces.size();
+             ++old_face_i) {
+            const auto old_order { face_order(wall_faces[old_face_i]) };
+            for (; face_i < faces.size() && face_order(faces[face_i]) < old_order;
+                 ++face_i) {}
+            if (face_i < faces.size() && face_order(faces[face_i]) == old_order) {
+                kept_face_is[old_face_i] = face_i;
+                face_added[face_i] = false;
+            }
+        }
+    }
+    buildWallRuns();
+
+    // Lists are built a strip of tiles at a time, each into its own face
+    //   indices, to be joined in map order after.
+    const uint32_t tile_ct ( map.size() );
+    std::vector<std::vector<uint32_t>> strip_face_is(
+        (tile_ct + PVS_STRIP_SZ - 1) / PVS_STRIP_SZ);
+    std::vector<uint32_t> offsets(size_t(tile_ct) + 1, 0);
+    thread_pool.forEachStrip(
+        tile_ct, PVS_STRIP_SZ,
+        [&](const uint32_t begin, const uint32_t end) {
+            std::vector<uint32_t>& face_is { strip_face_is[begin / PVS_STRIP_SZ] };
+            std::vector<uint8_t> reach;
+            for (uint32_t tile_i { begin }; tile_i < end; ++tile_i) {
+                const uint32_t x ( tile_i % w );
+                const uint32_t y ( tile_i / w );
+                const size_t list_begin { face_is.size() };
+                if (tileIsWall(x, y))
+                    continue;
+                // Only faces seen past a changed tile may have changed, and
+                //   a segment leaving this tile passes through one only by
+                //   first reaching one of its sides. (Changed tiles now empty
+                //   have no list to keep.)
+                bool test_all { !keep_lists };
+                bool test_faces { test_all };
+                for (size_t i { 0 }; i < changed_is.size() && !test_faces; ++i) {
+                    const uint32_t changed_x ( changed_is[i] % w );
+                    const uint32_t changed_y ( changed_is[i] / w );
+                    test_all = changed_is[i] == tile_i;
+                    test_faces = test_all;
+                    for (const TileSide side : { TileSide::N, TileSide::S,
+                                                 TileSide::E, TileSide::W }) {
+                        test_faces = test_faces ||
+                            tileMaySeeFace(x, y, { changed_x, changed_y, side });
+                    }
+                }
+                // kept faces of the old list, in order of their index in faces
+                uint32_t old_i { keep_lists ? pvs_offsets[tile_i] : 0 };
+                const uint32_t old_end { keep_lists ? pvs_offsets[tile_i + 1] : 0 };
+                if (!test_faces) {
+                    for (; old_i < old_end; ++old_i) {
+                        if (kept_face_is[pvs_face_is[old_i]] != NO_FACE)
+                            face_is.push_back(kept_face_is[pvs_face_is[old_i]]);
+                    }
+                    offsets[tile_i + 1] = face_is.size() - list_begin;
+                    continue;
+                }
+                reachTiles(x, y, reach);
+                for (uint32_t face_i { 0 }; face_i < faces.size(); ++face_i) {
+                    const WallTileFace& face { faces[face_i] };
+                    for (; old_i < old_end &&
+                             (kept_face_is[pvs_face_is[old_i]] == NO_FACE ||
+                              kept_face_is[pvs_face_is[old_i]] < face_i);
+                         ++old_i) {}
+                    bool test { test_all || face_added[face_i] };
+                    for (size_t i { 0 }; i < changed_is.size() && !test; ++i) {
+                        test = sightMayCross(x, y, face, changed_is[i] % w,
+                                             changed_is[i] / w);
+                    }
+                    if (!test) {
+                        if (old_i < old_end &&
+                            kept_face_is[pvs_face_is[old_i]] == face_i)
+                            face_is.push_back(face_i);
+                        continue;
+                    }
+                    // segments end at the face from the tile in front of it,
+                    //   or through a corner from one beside that tile
+                    Vector2d f0;
+                    Vector2d f1;
+                    int64_t front_x;
+                    int64_t front_y;
+                    faceGeometry(face, f0, f1, front_x, front_y);
+                    const bool ns { face.side == TileSide::N ||
+                                    face.side == TileSide::S };
+                    bool reached { false };
+                    for (const int64_t offset : { -1, 0, 1 }) {
+                        const int64_t near_x { ns ? front_x + offset : front_x };
+                        const int64_t near_y { ns ? front_y : front_y + offset };
+                        reached = reached ||
+                            (near_x >= 0 && near_x < w && near_y >= 0 && near_y < h &&
+                             reach[tileIndex(near_x, near_y)] != 0);
+                    }
+                    if (reached && tileMaySeeFace(x, y, face))
+                        face_is.push_back(face_i);
+                }
+                offsets[tile_i + 1] = face_is.size() - list_begin;
+            }
+        });
+
+    // list lengths to offsets
+    for (uint32_t tile_i { 0 }; tile_i < tile_ct; ++tile_i)
+        offsets[tile_i + 1] += offsets[tile_i];
+    pvs_face_is.clear();
+    pvs_face_is.reserve(offsets[tile_ct]);
+    for (const std::vector<uint32_t>& face_is : strip_face_is)
+        pvs_face_is.insert(pvs_face_is.end(), face_is.begin(), face_is.end());
+    pvs_face_is.shrink_to_fit();
+    pvs_offsets = std::move(offsets);
+    wall_faces = std::move(faces);
+
+    wall_runs = {};
+    tile_row_run_is = {};
+    tile_col_run_is = {};
 }
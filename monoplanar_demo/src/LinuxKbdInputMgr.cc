@@ -274,6 +274,10 @@ LinuxKbdInputMgr::LinuxKbdInputMgr(const std::string& exec_filename) {
         { KEY_F3,         KeyState (KEY_F3         ) },
         { KEY_F4,         KeyState (KEY_F4         ) },
         { KEY_F5,         KeyState (KEY_F5         ) },
+        { KEY_F6,         KeyState (KEY_F6         ) },
+        { KEY_F7,         KeyState (KEY_F7         ) },
+        { KEY_F8,         KeyState (KEY_F8         ) },
+        { KEY_F9,         KeyState (KEY_F9         ) },
         { KEY_F10,        KeyState (KEY_F10        ) },
         { KEY_F11,        KeyState (KEY_F11        ) },
         { KEY_F12,        KeyState (KEY_F12        ) },
@@ -15,6 +15,10 @@ SdlKbdInputMgr::SdlKbdInputMgr() {
         { SDLK_F3,     KeyState (SDLK_F3     ) },
         { SDLK_F4,     KeyState (SDLK_F4     ) },
         { SDLK_F5,     KeyState (SDLK_F5     ) },
+        { SDLK_F6,     KeyState (SDLK_F6     ) },
+        { SDLK_F7,     KeyState (SDLK_F7     ) },
+        { SDLK_F8,     KeyState (SDLK_F8     ) },
+        { SDLK_F9,     KeyState (SDLK_F9     ) },
         { SDLK_LSHIFT, KeyState (SDLK_LSHIFT ) },
         { SDLK_RSHIFT, KeyState (SDLK_RSHIFT ) },
         { SDLK_LCTRL,  KeyState (SDLK_LCTRL  ) },
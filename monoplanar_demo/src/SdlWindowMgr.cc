@@ -50,72 +50,128 @@ void SdlWindowMgr::renderHudLine(const std::string line, SDL_Rect glyph_rect) {
     }
 }
 
-// TBD: make public member? In case of building for optional multithreading,
-//   each thread would have to trace a batch of rays, then render their
-//   respective pixel columns without stopping to wait for the others,
-//   which means each thread would have to call this.
-// The core illusion of raycasting comes from rendering walls in vertical
-//   strips, one per each ray cast in the FOV, with each strip being longer
-//   as the ray is shorter/wall is closer, forcing perspective.
-void SdlWindowMgr::renderPixelColumn(const uint16_t screen_x,
-                                      const FovRay& ray) {
-
-    // calculate height of vertical strip of wall to draw on screen
-    uint16_t line_h ( window_h / ray.wall_hit.dist );
-
-    // row index of highest pixel in strip (may be negative if camera is close
-    //   to wall and wall unit does not fit in frame)
-    int16_t ceiling_screen_y ( window_h / 2 - line_h / 2 );
-
-    // TBD: add protection for out of range tex key? or in map parsing?
-    // find proportionate x coordinate in wall texture
-    SDL_Surface* texture { wall_texs.at(ray.wall_hit.tex_key).get() };
-    uint16_t tex_x ( ray.wall_hit.x * texture->w );
-    // ensure texture x of 0 is always to the left when facing the wall segment
-    if ((ray.wall_hit.algnmt == WallOrientation::NS && ray.dir.x > 0) ||
-        (ray.wall_hit.algnmt == WallOrientation::EW && ray.dir.y < 0) ) {
-        tex_x = texture->w - tex_x - 1;
-    }
+void SdlWindowMgr::endView(const Settings& /*settings*/) {
+    SDL_UpdateTexture(buffer_tex.get(), nullptr, buffer->pixels, buffer->pitch);
+    // fit entire texture to window
+    SDL_RenderCopy(renderer.get(), buffer_tex.get(), nullptr, nullptr);
+}
 
-    uint16_t screen_y { 0 };
-    uint16_t screen_line_begin_y ( std::max(0, (int)ceiling_screen_y) );
-    uint16_t screen_line_end_y ( std::min((int)window_h, ceiling_screen_y + line_h) );
+// Called from multiple threads at once (see WindowMgr::renderViews), which is
+//   safe as each call only writes to its own pixel column in buffer, and
+//   SDL_MapRGBA only reads the pixel format.
+void SdlWindowMgr::renderPixelColumn(const Viewport& viewport,
+                                     const uint16_t view_x,
+                                     const FovRayBuffer& fov_rays,
+                                     const Settings& settings) {
+
+    const uint8_t* light_lut { lightLut(
+        wallLightLevel(fov_rays.light[view_x], fov_rays.algnmt[view_x])) };
+
+    // calculate height and top row of vertical strip of wall to draw in
+    //   viewport
+    uint16_t line_h;
+    int16_t ceiling_view_y;
+    wallLine(viewport.h, fov_rays.dist[view_x], line_h, ceiling_view_y);
+
+    const WallTexColumn tex_column {
+        wallTexColumn(view_x, fov_rays, line_h, settings) };
+    const uint16_t fog_weight { fogWeight(fov_rays.dist[view_x], settings) };
+
+    // ceiling and floor are left to renderFloorCeilingRow
+    uint16_t view_y ( std::max(0, (int)ceiling_view_y) );
+    uint16_t view_line_end_y ( std::min((int)viewport.h, ceiling_view_y + line_h) );
     SDL_PixelFormat* screen_format { buffer->format };
-    uint8_t* screen_px_data { surfacePixelPtr(buffer.get(), screen_x, screen_y) };
+    uint8_t* screen_px_data { surfacePixelPtr(buffer.get(), viewport.x + view_x,
+                                              viewport.y + view_y) };
     uint16_t screen_row_sz ( buffer->pitch );
-    // draw transparent ceiling
-    for (; screen_y < screen_line_begin_y; ++screen_y, screen_px_data += screen_row_sz) {
-        // TBD: more efficient to simply set alpha to 0?
-        *((uint32_t*)screen_px_data) = 0;
-    }
-    // draw wall, shading NS walls darker to differentiate
-    double tex_h_ratio { texture->h / (double)line_h };
-    SDL_PixelFormat* tex_format { texture->format };
-    uint8_t* tex_px_data { surfacePixelPtr(texture, tex_x, 0) };
-    uint16_t tex_row_sz ( texture->pitch );
+    // draw wall, lit by the face hit (and NS walls darker to differentiate)
+    double tex_h_ratio { tex_column.h / (double)line_h };
     uint8_t r, g, b;
     for (uint16_t tex_y;
-         screen_y < screen_line_end_y; ++screen_y, screen_px_data += screen_row_sz) {
+         view_y < view_line_end_y; ++view_y, screen_px_data += screen_row_sz) {
         // screen buffer traversal can optimize away calling surfacePixelPtr
-        //   due a consistent step of screen_y += 1 each loop; using a similar
+        //   due a consistent step of view_y += 1 each loop; using a similar
         //   approach to texture traversal is difficult as we need to
         //   accommodate any possible tex_h:line_h ratio, and so possibly
-        //   inconsistent step values for tex_y as it is fit to screen_y
-        tex_y = (screen_y - ceiling_screen_y /*line_y*/) * tex_h_ratio;
-        SDL_GetRGB(*(uint32_t*)(tex_px_data + (tex_y * tex_row_sz)),
-                   tex_format, &r, &g, &b);
-        if (ray.wall_hit.algnmt == WallOrientation::NS) {
-            r /= 2;
-            g /= 2;
-            b /= 2;
+        //   inconsistent step values for tex_y as it is fit to view_y
+        tex_y = (view_y - ceiling_view_y /*line_y*/) * tex_h_ratio;
+        shadeTexel(tex_column.texels[tex_y * tex_column.w], light_lut,
+                   fog_weight, r, g, b);
+        *((uint32_t*)screen_px_data) = SDL_MapRGBA(
+            screen_format, r, g, b, SDL_ALPHA_OPAQUE);
+    }
+}
+
+// Called from multiple threads at once, for the columns of different strips.
+void SdlWindowMgr::renderFloorCeilingRow(const Viewport& viewport,
+                                         const uint16_t floor_view_y,
+                                         const uint16_t begin_x,
+                                         const uint16_t end_x,
+                                         const Settings& settings) {
+    const uint16_t ceiling_view_y ( viewport.h - 1 - floor_view_y );
+    // buffer is ARGB8888 (see fitToWindow), so 0xRRGGBB texels only need
+    //   opaque alpha, rather than a SDL_MapRGBA call per pixel
+    uint32_t* floor_px { (uint32_t*)surfacePixelPtr(
+            buffer.get(), viewport.x, viewport.y + floor_view_y) };
+    uint32_t* ceiling_px { (uint32_t*)surfacePixelPtr(
+            buffer.get(), viewport.x, viewport.y + ceiling_view_y) };
+    const uint32_t* floor_rgb { floor_row_rgb.data() + viewport.x };
+    const uint32_t* ceiling_rgb { ceiling_row_rgb.data() + viewport.x };
+    const uint16_t* wall_begin_y { column_wall_begin_y.data() + viewport.x };
+    const uint16_t* wall_end_y { column_wall_end_y.data() + viewport.x };
+    constexpr uint32_t opaque { 0xff000000 };
+    const uint16_t column_step { settings.column_scale };
+    for (uint16_t view_x { begin_x }; view_x < end_x; view_x += column_step) {
+        if (floor_view_y >= wall_end_y[view_x])
+            floor_px[view_x] = opaque | floor_rgb[view_x];
+        // middle row of odd height viewport is floor, not also ceiling
+        if (ceiling_view_y < wall_begin_y[view_x] &&
+            ceiling_view_y != floor_view_y) {
+            ceiling_px[view_x] = opaque | ceiling_rgb[view_x];
         }
+    }
+}
+
+// Called from multiple threads at once, like renderPixelColumn.
+void SdlWindowMgr::renderSpriteColumn(const Viewport& viewport,
+                                      const uint16_t view_x,
+                                      const ViewSprite& sprite,
+                                      const uint32_t* tex_column,
+                                      const Settings& /*settings*/) {
+    uint16_t view_y ( std::max(0, (int)sprite.top_y) );
+    const uint16_t view_end_y (
+        std::min((int)viewport.h, sprite.top_y + sprite.h) );
+    SDL_PixelFormat* screen_format { buffer->format };
+    uint8_t* screen_px_data { surfacePixelPtr(buffer.get(), viewport.x + view_x,
+                                              viewport.y + view_y) };
+    uint16_t screen_row_sz ( buffer->pitch );
+    const double tex_h_ratio { SPRITE_TEX_SZ / (double)sprite.h };
+    uint8_t r, g, b;
+    for (uint16_t tex_y; view_y < view_end_y;
+         ++view_y, screen_px_data += screen_row_sz) {
+        tex_y = (view_y - sprite.top_y) * tex_h_ratio;
+        const uint32_t texel { tex_column[tex_y * SPRITE_TEX_SZ] };
+        // transparent
+        if (texel >> 24 == 0)
+            continue;
+        // EW, as sprites always face the camera and so are not shaded
+        shadeTexel(texel, sprite.light_lut, sprite.fog_weight, r, g, b);
         *((uint32_t*)screen_px_data) = SDL_MapRGBA(
             screen_format, r, g, b, SDL_ALPHA_OPAQUE);
     }
-    // draw transparent floor
-    for (; screen_y < window_h; ++screen_y, screen_px_data += screen_row_sz) {
-        // TBD: more efficient to simply set alpha to 0?
-        *((uint32_t*)screen_px_data) = 0;
+}
+
+void SdlWindowMgr::copyPixelColumn(const Viewport& viewport,
+                                   const uint16_t src_view_x,
+                                   const uint16_t dst_view_x) {
+    uint8_t* src_px_data { surfacePixelPtr(buffer.get(), viewport.x + src_view_x,
+                                           viewport.y) };
+    uint8_t* dst_px_data { surfacePixelPtr(buffer.get(), viewport.x + dst_view_x,
+                                           viewport.y) };
+    uint16_t screen_row_sz ( buffer->pitch );
+    for (uint16_t view_y { 0 }; view_y < viewport.h; ++view_y,
+             src_px_data += screen_row_sz, dst_px_data += screen_row_sz) {
+        *((uint32_t*)dst_px_data) = *((uint32_t*)src_px_data);
     }
 }
 
@@ -150,7 +206,7 @@ uint16_t SdlWindowMgr::width() { return window_w; }
 uint16_t SdlWindowMgr::height() { return window_h; }
 
 void SdlWindowMgr::initialize(const Settings& settings,
-                               const uint16_t layout_h) {
+                               const uint32_t layout_h) {
     //
     // init window and window buffer
     //
@@ -181,20 +237,6 @@ void SdlWindowMgr::initialize(const Settings& settings,
     //
     SdlRetTest<SDL_Surface*> img_load_ret_test {
         [](SDL_Surface* const ret){ return (ret == nullptr); } };
-    sdl2_unq::Surface sky_surface { sdl2_smart_ptr::make_unique(
-            safeSdlCall(IMG_Load, "IMG_Load", img_load_ret_test,
-                        SKY_TEX_PATH) ) };
-    std::cout << "Loaded texture: " << SKY_TEX_PATH << '\n';
-    sky_tex = sdl2_smart_ptr::make_unique(
-        safeSdlCall(SDL_CreateTextureFromSurface, "SDL_CreateTextureFromSurface",
-                    SdlRetTest<SDL_Texture*>{
-                        [](SDL_Texture* const ret){ return (ret == nullptr); } },
-                    renderer.get(), sky_surface.get()) );
-    // set to alpha blending (for fps glyphs)
-    safeSdlCall(SDL_SetTextureBlendMode, "SDL_SetTextureBlendMode",
-                SdlRetTest<int>{
-                        [](const int ret){ return (ret < 0); } },
-                sky_tex.get(), SDL_BLENDMODE_BLEND);
     // TBD: eventually change to map of texture keys representing floor/ceiling/walls
     // dummmy texture at index 0, as map tile 0 represents non-wall tile
     wall_texs.emplace_back(/*sdl2_unq::Surface{}*/);
@@ -206,23 +248,27 @@ void SdlWindowMgr::initialize(const Settings& settings,
                             wall_tex_paths[i]) ) );
         std::cout << "Loaded texture: " << wall_tex_paths[i] << '\n';
     }
+    buildWallTexLevels();
+    buildSpriteTexs();
+    buildLightLuts();
 }
 
 void SdlWindowMgr::fitToWindow(const double map_proportion,
-                                const uint16_t layout_h) {
+                                const uint32_t layout_h) {
     assert(window.get() != nullptr);
     int w, h;
     SDL_GetWindowSize(window.get(), &w, &h);  // void return, no error checking
     window_w = w;
     window_h = h;
 
-    // using format with alpha channel for blending of fps glyphs
+    // every pixel is written opaque each frame, with alpha only so that
+    //   pixels are 32 bit aligned
     buffer = sdl2_smart_ptr::make_unique(
         safeSdlCall(SDL_CreateRGBSurfaceWithFormat, "SDL_CreateRGBSurfaceWithFormat",
                     SdlRetTest<SDL_Surface*>{
                         [](SDL_Surface* const ret){ return (ret == nullptr); } },
                     0 /*flags*/, window_w, window_h,
-                    32 /*depth (bits per pixel)*/, SDL_PIXELFORMAT_BGRA32) );
+                    32 /*depth (bits per pixel)*/, SDL_PIXELFORMAT_ARGB8888) );
     // Even if pixel setting is multithreaded, no two threads should be
     //   accessing the same pixel column at once, so we can rule out use of
     //   SDL_LockSurface/SDL_UnlockSurface to improve performance
@@ -234,11 +280,11 @@ void SdlWindowMgr::fitToWindow(const double map_proportion,
                     renderer.get(), buffer->format->format,
                     SDL_TEXTUREACCESS_STREAMING /*flags*/,
                     window_w, window_h) );
-    // set to alpha blending (for fps glyphs)
+    // buffer is opaque, so copied to the window without blending
     safeSdlCall(SDL_SetTextureBlendMode, "SDL_SetTextureBlendMode",
                 SdlRetTest<int>{
                     [](const int ret){ return (ret < 0); } },
-                buffer_tex.get(), SDL_BLENDMODE_BLEND);
+                buffer_tex.get(), SDL_BLENDMODE_NONE);
 
     minimap_scale = (window_h * map_proportion) / layout_h;
     minimap_viewport.w = minimap_scale * 25;
@@ -250,22 +296,8 @@ void SdlWindowMgr::fitToWindow(const double map_proportion,
     makeGlyphs(FONT_PATH);
 }
 
-void SdlWindowMgr::renderView(const std::vector<FovRay>& fov_rays,
-                               const Settings& /*settings*/) {
-    // TBD: currently rendering entire skyplane and then drawing walls on top
-    //   perhaps we can make viewport on skyplane so it's not stretched, and then
-    //   set buffer pixels of only sky above walls, and floor below
-    // render entire skyplane tx to window, stretch to fit
-    SDL_RenderCopy(renderer.get(), sky_tex.get(), nullptr, nullptr);
-    for (uint16_t window_x { 0 }; window_x < window_w; ++window_x) {
-        renderPixelColumn(window_x, fov_rays[window_x]);
-    }
-    SDL_UpdateTexture(buffer_tex.get(), nullptr, buffer->pixels, buffer->pitch);
-    // fit entire texture to window
-    SDL_RenderCopy(renderer.get(), buffer_tex.get(), nullptr, nullptr);
-}
-
-void SdlWindowMgr::renderMap(const DdaRaycastEngine& raycast_engine) {
+void SdlWindowMgr::renderMap(const DdaRaycastEngine& raycast_engine,
+                             const SpriteGrid& sprites) {
     SDL_Renderer* _renderer { renderer.get() };
     // render to entire window
     SDL_RenderSetViewport(_renderer, nullptr);
@@ -282,16 +314,16 @@ void SdlWindowMgr::renderMap(const DdaRaycastEngine& raycast_engine) {
     // empty map coordinates drawn in light grey; walls implied via negative space
     const Layout& layout { raycast_engine.layout };
     SDL_Rect map_tile { /*x*/0, /*y*/0, /*w*/1, /*h*/1 };
-    const uint16_t player_x ( raycast_engine.player_pos.x );
-    const uint16_t player_y ( raycast_engine.player_pos.y );
-    const uint16_t map_delta ( MINIMAP_GRID_SZ / 2 );
-    for (int16_t map_y ( player_y + map_delta );
+    const int64_t player_x ( raycast_engine.player_pos.x );
+    const int64_t player_y ( raycast_engine.player_pos.y );
+    const int64_t map_delta ( MINIMAP_GRID_SZ / 2 );
+    for (int64_t map_y ( player_y + map_delta );
          map_y >= player_y - map_delta; --map_y, map_tile.x = 0, ++map_tile.y) {
-        for (int16_t map_x ( player_x - map_delta );
+        for (int64_t map_x ( player_x - map_delta );
              map_x <= player_x + map_delta; ++map_x, ++map_tile.x) {
             if (map_x < 0 || map_y < 0 ||
-                map_x >= static_cast<int16_t>(layout.w) ||
-                map_y >= static_cast<int16_t>(layout.h) ||
+                map_x >= static_cast<int64_t>(layout.w) ||
+                map_y >= static_cast<int64_t>(layout.h) ||
                 !layout.tileIsWall(map_x, map_y)) {
                 SDL_RenderFillRect(_renderer, &map_tile);
             }
@@ -299,6 +331,24 @@ void SdlWindowMgr::renderMap(const DdaRaycastEngine& raycast_engine) {
     }
     // scale dot to .5 grid unit
     SDL_RenderSetScale(_renderer, minimap_scale / 2, minimap_scale / 2);
+    // draw sprites as dots of their color, in .5 grid units from top left of
+    //   minimap
+    const float map_left ( player_x - map_delta );
+    const float map_top ( player_y + map_delta + 1 );
+    sprites.forEachNear(
+        map_left, map_top - MINIMAP_GRID_SZ, map_left + MINIMAP_GRID_SZ, map_top,
+        [&](const Sprite& sprite) {
+            const float sprite_x { (sprite.x - map_left) * 2 };
+            const float sprite_y { (map_top - sprite.y) * 2 };
+            if (sprite_x >= 0 && sprite_y >= 0 &&
+                sprite_x < MINIMAP_GRID_SZ * 2 && sprite_y < MINIMAP_GRID_SZ * 2) {
+                const uint32_t rgb {
+                    sprite_rgbs[sprite.tex_key % sprite_rgbs.size()] };
+                SDL_SetRenderDrawColor(_renderer, rgb >> 16, rgb >> 8, rgb,
+                                       SDL_ALPHA_OPAQUE);
+                SDL_RenderDrawPoint(_renderer, sprite_x, sprite_y);
+            }
+        });
     SDL_SetRenderDrawColor(_renderer, 0xFF, 0x00, 0x00, SDL_ALPHA_OPAQUE);
     // draw player as red dot at (center x, center y)
     SDL_RenderDrawPoint(_renderer, /*(*/MINIMAP_GRID_SZ/* / 2) * 2*/,
@@ -314,6 +364,7 @@ void SdlWindowMgr::renderHud(const double pt_frame_duration_mvg_avg,
                              const double rt_frame_duration_mvg_avg,
                              const Settings& settings,
                              const DdaRaycastEngine& raycast_engine,
+                             const AgentSim& agent_sim,
                              const KbdInputMgr* kbd_input_mgr) {
     char line[50] { '\0' };
     SDL_Rect glyph_rect { 0, 0, 0, 0 };
@@ -340,6 +391,37 @@ void SdlWindowMgr::renderHud(const double pt_frame_duration_mvg_avg,
         std::sprintf(line, "debug_mode(F3): %i euclidean(F4): %i",
                      settings.debug_mode, settings.euclidean);
         renderHudLine(line, glyph_rect);
+        glyph_rect.y += glyph_rect.h;
+        std::sprintf(line, "ray_packets(F5): %i scalar: %s",
+                     settings.ray_packets, scalarTypeName(settings.scalar_type));
+        renderHudLine(line, glyph_rect);
+        glyph_rect.y += glyph_rect.h;
+        const RayCacheStats ray_cache_stats { raycast_engine.rayCacheStats() };
+        std::sprintf(line, "ray_cache(F6): %i hits: %4u misses: %4u",
+                     settings.ray_cache, ray_cache_stats.frame_hit_ct,
+                     ray_cache_stats.frame_miss_ct);
+        renderHudLine(line, glyph_rect);
+        glyph_rect.y += glyph_rect.h;
+        std::sprintf(line, "skip(F7): %s steps/ray: %6.2f",
+                     emptySpaceSkipName(settings.empty_space_skip),
+                     raycast_engine.frameStepsPerRay());
+        renderHudLine(line, glyph_rect);
+        glyph_rect.y += glyph_rect.h;
+        std::sprintf(line, "draw_dist: %6.1f texture_lod(F8): %i",
+                     settings.draw_dist, settings.texture_lod);
+        renderHudLine(line, glyph_rect);
+        glyph_rect.y += glyph_rect.h;
+        std::sprintf(line, "target_fps: %5.1f column_scale: %u",
+                     settings.target_fps, settings.column_scale);
+        renderHudLine(line, glyph_rect);
+        glyph_rect.y += glyph_rect.h;
+        std::sprintf(line, "interleave(F9): %i wall_spans: %i pvs: %i",
+                     settings.interleave, settings.wall_spans, settings.pvs);
+        renderHudLine(line, glyph_rect);
+        glyph_rect.y += glyph_rect.h;
+        std::sprintf(line, "agents: %u update: %6.2fms", agent_sim.size(),
+                     agent_sim.update_duration * 1000);
+        renderHudLine(line, glyph_rect);
 
         // -ddd.ddd format
         glyph_rect.y += glyph_rect.h;
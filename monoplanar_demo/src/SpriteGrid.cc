@@ -0,0 +1,48 @@
+#include "SpriteGrid.hh"
+
+#include <cstdint>
+
+#include <algorithm>   // min max
+
+
+void SpriteGrid::resize(const uint32_t map_w, const uint32_t map_h) {
+    cells_w = (map_w + CELL_SZ - 1) / CELL_SZ;
+    cells_h = (map_h + CELL_SZ - 1) / CELL_SZ;
+    clear();
+    build();
+}
+
+size_t SpriteGrid::cellIndex(const float x, const float y) const {
+    // clamp before narrowing, as out of range float to int is undefined
+    //   (in double, as float cannot hold every cell count exactly)
+    const uint32_t cell_x ( std::min(std::max(double(x) / CELL_SZ, 0.0),
+                                     double(cells_w - 1)) );
+    const uint32_t cell_y ( std::min(std::max(double(y) / CELL_SZ, 0.0),
+                                     double(cells_h - 1)) );
+    return (size_t(cell_y) * cells_w) + cell_x;
+}
+
+void SpriteGrid::clear() {
+    added.clear();
+}
+
+void SpriteGrid::build() {
+    const size_t cell_ct { size_t(cells_w) * cells_h };
+    // counting sort: count sprites per cell, offset each cell by the counts
+    //   before it, then place sprites at their cell's next free slot
+    cell_offsets.assign(cell_ct + 1, 0);
+    cell_sprites.resize(added.size());
+    if (cell_ct == 0)
+        return;
+    for (const Sprite& sprite : added)
+        ++cell_offsets[cellIndex(sprite.x, sprite.y) + 1];
+    for (size_t c { 0 }; c < cell_ct; ++c)
+        cell_offsets[c + 1] += cell_offsets[c];
+    // cell_offsets[c] is advanced as cell c fills, ending at the start of
+    //   cell c + 1, then shifted back
+    for (const Sprite& sprite : added)
+        cell_sprites[cell_offsets[cellIndex(sprite.x, sprite.y)]++] = sprite;
+    for (size_t c { cell_ct }; c > 0; --c)
+        cell_offsets[c] = cell_offsets[c - 1];
+    cell_offsets[0] = 0;
+}
@@ -0,0 +1,89 @@
+#include "ThreadPool.hh"
+
+#include <cstdint>
+
+#include <thread>
+#include <mutex>
+#include <algorithm>     // min
+
+
+ThreadPool::ThreadPool(const uint16_t thread_ct) {
+    uint16_t total_ct ( thread_ct ? thread_ct : std::thread::hardware_concurrency() );
+    // hardware_concurrency may return 0 if unknown; calling thread always works
+    for (uint16_t i { 1 }; i < total_ct; ++i)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    job_cv.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::workStrips() {
+    for (uint32_t begin { next_strip_begin.fetch_add(strip_sz) };
+         begin < job_sz; begin = next_strip_begin.fetch_add(strip_sz)) {
+        try {
+            (*strip_func)(begin, std::min(begin + strip_sz, job_sz));
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!job_exception)
+                job_exception = std::current_exception();
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t last_job_id { 0 };
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            job_cv.wait(lock, [&]{ return stopping || job_id != last_job_id; });
+            if (stopping)
+                return;
+            last_job_id = job_id;
+        }
+        workStrips();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            --busy_ct;
+        }
+        done_cv.notify_one();
+    }
+}
+
+void ThreadPool::forEachStrip(const uint32_t _job_sz, const uint32_t _strip_sz,
+                              const StripFunc& func) {
+    if (_job_sz == 0)
+        return;
+    // no need to wake workers for a single strip
+    if (workers.empty() || _job_sz <= _strip_sz) {
+        func(0, _job_sz);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        strip_func = &func;
+        job_sz = _job_sz;
+        strip_sz = std::max(_strip_sz, uint32_t(1));
+        next_strip_begin = 0;
+        job_exception = nullptr;
+        busy_ct = workers.size();
+        ++job_id;
+    }
+    job_cv.notify_all();
+    workStrips();
+    std::exception_ptr e;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        done_cv.wait(lock, [&]{ return busy_ct == 0; });
+        strip_func = nullptr;
+        e = job_exception;
+    }
+    if (e)
+        std::rethrow_exception(e);
+}
@@ -0,0 +1,310 @@
+#include "TileChunkCache.hh"
+#include "Vector2d.hh"
+
+#include <cstdint>
+#include <cmath>       // floor sqrt
+#include <climits>     // INT32_MAX
+
+#include <algorithm>   // sort min max
+#include <fstream>     // ifstream ofstream
+#include <sstream>     // ostringstream istringstream
+#include <iostream>
+#include <limits>      // numeric_limits
+#include <stdexcept>   // runtime_error
+#include <string>
+#include <utility>     // move
+
+
+TileChunkCache::~TileChunkCache() {
+    {
+        std::lock_guard<std::mutex> lock(load_mtx);
+        stopping = true;
+    }
+    load_cv.notify_one();
+    if (loader.joinable())
+        loader.join();
+}
+
+void TileChunkCache::queueMissing(const size_t chunk_i) const {
+    // first lookup of a missing chunk queues it; the rest of the frame's
+    //   lookups of it stop here without taking the lock
+    uint8_t expected { ABSENT };
+    if (!chunk_states[chunk_i].compare_exchange_strong(expected, QUEUED))
+        return;
+    {
+        std::lock_guard<std::mutex> lock(load_mtx);
+        load_queue.push_back(chunk_i);
+    }
+    load_cv.notify_one();
+}
+
+std::unique_ptr<TileChunkCache::Chunk> TileChunkCache::readChunk(
+    std::ifstream& map_ifs, const size_t chunk_i) const {
+    std::unique_ptr<Chunk> chunk { new Chunk() };
+    chunk->chunk_i = chunk_i;
+    map_ifs.clear();
+    map_ifs.seekg(data_offset + std::streamoff(chunk_i * CHUNK_TILE_CT));
+    map_ifs.read(reinterpret_cast<char*>(chunk->tiles), CHUNK_TILE_CT);
+    if (!map_ifs)
+        return nullptr;
+    return chunk;
+}
+
+void TileChunkCache::loaderLoop() {
+    std::ifstream map_ifs(map_filename, std::ios::binary);
+    while (true) {
+        size_t chunk_i;
+        {
+            std::unique_lock<std::mutex> lock(load_mtx);
+            load_cv.wait(lock, [&]{ return stopping || !load_queue.empty(); });
+            if (stopping)
+                return;
+            chunk_i = load_queue.front();
+            load_queue.pop_front();
+            ++loading_ct;
+        }
+        std::unique_ptr<Chunk> chunk { readChunk(map_ifs, chunk_i) };
+        std::lock_guard<std::mutex> lock(load_mtx);
+        --loading_ct;
+        if (chunk) {
+            loaded.push_back(std::move(chunk));
+        } else if (load_error.empty()) {
+            std::ostringstream err_msg;
+            err_msg << "Could not read chunk " << chunk_i <<
+                " from map file: " << map_filename;
+            load_error = err_msg.str();
+        }
+    }
+}
+
+template <typename FuncT>
+void TileChunkCache::forEachChunkNear(const Vector2d& pos, FuncT&& func) const {
+    // chunk containing pos, clamped to the map
+    const int64_t chunk_x ( std::floor(
+        std::min(std::max(pos.x, 0.0), double(w - 1)) / CHUNK_SZ) );
+    const int64_t chunk_y ( std::floor(
+        std::min(std::max(pos.y, 0.0), double(h - 1)) / CHUNK_SZ) );
+    const int64_t x0 { std::max(chunk_x - PREFETCH_RADIUS, int64_t(0)) };
+    const int64_t y0 { std::max(chunk_y - PREFETCH_RADIUS, int64_t(0)) };
+    const int64_t x1 { std::min(chunk_x + PREFETCH_RADIUS, int64_t(chunks_w - 1)) };
+    const int64_t y1 { std::min(chunk_y + PREFETCH_RADIUS, int64_t(chunks_h - 1)) };
+    for (int64_t y { y0 }; y <= y1; ++y) {
+        for (int64_t x { x0 }; x <= x1; ++x)
+            func((size_t(y) * chunks_w) + size_t(x));
+    }
+}
+
+void TileChunkCache::open(const std::string& _map_filename,
+                          const uint32_t budget_mb, Vector2d& player_pos) {
+    map_filename = _map_filename;
+    std::ifstream map_ifs(map_filename, std::ios::binary);
+    std::ostringstream err_msg;
+    if (!map_ifs.is_open()) {
+        err_msg << "Could not open map file: " << map_filename;
+        throw std::runtime_error(err_msg.str());
+    }
+
+    std::string line;
+    std::string keyword;
+    uint64_t map_w { 0 }, map_h { 0 };
+    uint32_t chunk_log2 { 0 };
+    if (!std::getline(map_ifs, line) || line != CHUNK_MAP_HEADER) {
+        err_msg << "Missing \"" << CHUNK_MAP_HEADER << "\" header in chunk map file";
+        throw std::runtime_error(err_msg.str());
+    }
+    if (!std::getline(map_ifs, line) ||
+        !(std::istringstream(line) >> map_w >> map_h >> chunk_log2) ||
+        chunk_log2 != CHUNK_LOG2) {
+        err_msg << "Malformed chunk map size line, expected \"w h " <<
+            uint16_t(CHUNK_LOG2) << "\". Check map file for errors.";
+        throw std::runtime_error(err_msg.str());
+    }
+    // (see Layout::MAX_DIM)
+    if (map_w < 3 || map_h < 3 || map_w > INT32_MAX || map_h > INT32_MAX) {
+        err_msg << "Chunk map size " << map_w << "x" << map_h <<
+            " outside of 3 to " << INT32_MAX << " tiles in either dimension.";
+        throw std::runtime_error(err_msg.str());
+    }
+    if (!std::getline(map_ifs, line) ||
+        !(std::istringstream(line) >> keyword >> player_pos.x >> player_pos.y) ||
+        keyword != "player") {
+        err_msg << "Malformed chunk map player line, expected \"player x y\". "
+            "Check map file for errors.";
+        throw std::runtime_error(err_msg.str());
+    }
+    data_offset = map_ifs.tellg();
+    w = map_w;
+    h = map_h;
+    chunks_w = (w + CHUNK_MASK) >> CHUNK_LOG2;
+    chunks_h = (h + CHUNK_MASK) >> CHUNK_LOG2;
+    const size_t chunk_ct { size_t(chunks_w) * chunks_h };
+    map_ifs.seekg(0, std::ios::end);
+    if (map_ifs.tellg() <
+        data_offset + std::streamoff(chunk_ct * CHUNK_TILE_CT)) {
+        err_msg << "Chunk map file shorter than its " << chunk_ct <<
+            " chunks. Check map file for errors.";
+        throw std::runtime_error(err_msg.str());
+    }
+
+    budget_chunk_ct = std::max(
+        uint32_t((uint64_t(budget_mb) << 20) / sizeof(Chunk)),
+        MIN_BUDGET_CHUNK_CT);
+    chunk_table.assign(chunk_ct, nullptr);
+    chunk_states.reset(new std::atomic<uint8_t>[chunk_ct]);
+    for (size_t i { 0 }; i < chunk_ct; ++i)
+        chunk_states[i].store(ABSENT, std::memory_order_relaxed);
+    resident.clear();
+    frame = 0;
+    prev_pos = player_pos;
+
+    // first frame is cast around the start with no chunks missing
+    forEachChunkNear(player_pos, [&](const size_t chunk_i) {
+        std::unique_ptr<Chunk> chunk { readChunk(map_ifs, chunk_i) };
+        if (!chunk) {
+            err_msg << "Could not read chunk " << chunk_i <<
+                " from map file: " << map_filename;
+            throw std::runtime_error(err_msg.str());
+        }
+        chunk_table[chunk_i] = chunk.get();
+        chunk_states[chunk_i].store(RESIDENT, std::memory_order_relaxed);
+        resident.push_back(std::move(chunk));
+    });
+    map_ifs.close();
+    if (!(player_pos.x >= 0 && player_pos.x < w &&
+          player_pos.y >= 0 && player_pos.y < h) ||
+        tile(player_pos.x, player_pos.y) != 0) {
+        err_msg <<
+            "Player start outside of map or inside a wall. Check map file for errors.";
+        throw std::runtime_error(err_msg.str());
+    }
+
+    loader = std::thread(&TileChunkCache::loaderLoop, this);
+    std::cout << "Opened chunk map: " << chunk_ct << " chunks of " <<
+        CHUNK_SZ << "x" << CHUNK_SZ << " tiles, up to " << budget_chunk_ct <<
+        " resident\n";
+}
+
+bool TileChunkCache::update(const Vector2d& pos, const Vector2d& dir) {
+    bool changed { false };
+    ++frame;
+    // chunks looked up in the last frame were marked with frame - 1
+    const uint32_t prev_frame { frame - 1 };
+
+    std::vector<std::unique_ptr<Chunk>> installed;
+    {
+        std::lock_guard<std::mutex> lock(load_mtx);
+        if (!load_error.empty())
+            throw std::runtime_error(load_error);
+        installed.swap(loaded);
+    }
+    for (auto& chunk : installed) {
+        chunk->use_frame.store(frame, std::memory_order_relaxed);
+        chunk_table[chunk->chunk_i] = chunk.get();
+        chunk_states[chunk->chunk_i].store(RESIDENT, std::memory_order_relaxed);
+        resident.push_back(std::move(chunk));
+        changed = true;
+    }
+
+    // Prefetch around the player and ahead of it, in its direction of travel
+    //   (or facing, if it has not moved), so chunks are usually loaded before
+    //   any ray reaches them.
+    Vector2d travel { pos.x - prev_pos.x, pos.y - prev_pos.y };
+    double travel_len { std::sqrt((travel.x * travel.x) + (travel.y * travel.y)) };
+    if (travel_len == 0) {
+        travel = dir;
+        travel_len = std::sqrt((dir.x * dir.x) + (dir.y * dir.y));
+    }
+    prev_pos = pos;
+    const auto want { [&](const size_t chunk_i) {
+        if (Chunk* chunk { chunk_table[chunk_i] })
+            chunk->use_frame.store(frame, std::memory_order_relaxed);
+        else
+            queueMissing(chunk_i);
+    } };
+    forEachChunkNear(pos, want);
+    if (travel_len > 0)
+        forEachChunkNear(pos + (travel * (PREFETCH_AHEAD_DIST / travel_len)), want);
+
+    std::lock_guard<std::mutex> lock(load_mtx);
+    // Evict least recently used chunks until those resident and on their way
+    //   fit the budget, keeping those wanted now or used in the last frame (so
+    //   a budget too small for one frame's chunks thins the queue instead of
+    //   evicting chunks still in view).
+    const size_t inflight_ct { load_queue.size() + loading_ct };
+    if (resident.size() + inflight_ct > budget_chunk_ct) {
+        std::sort(resident.begin(), resident.end(),
+                  [](const std::unique_ptr<Chunk>& a, const std::unique_ptr<Chunk>& b) {
+                      return a->use_frame.load(std::memory_order_relaxed) <
+                          b->use_frame.load(std::memory_order_relaxed); });
+        size_t evict_ct { 0 };
+        while (evict_ct < resident.size() &&
+               resident.size() - evict_ct + inflight_ct > budget_chunk_ct &&
+               resident[evict_ct]->use_frame.load(std::memory_order_relaxed) <
+               prev_frame) {
+            const size_t chunk_i { resident[evict_ct]->chunk_i };
+            chunk_table[chunk_i] = nullptr;
+            chunk_states[chunk_i].store(ABSENT, std::memory_order_relaxed);
+            ++evict_ct;
+        }
+        if (evict_ct > 0) {
+            resident.erase(resident.begin(), resident.begin() + evict_ct);
+            changed = true;
+        }
+    }
+
+    // load nearest chunks first, and only as many as fit the budget; the rest
+    //   are queued again if still looked up
+    const auto chunkDist2 { [&](const size_t chunk_i) {
+        const double dx { ((double(chunk_i % chunks_w) + 0.5) * CHUNK_SZ) - pos.x };
+        const double dy { ((double(chunk_i / chunks_w) + 0.5) * CHUNK_SZ) - pos.y };
+        return (dx * dx) + (dy * dy);
+    } };
+    std::sort(load_queue.begin(), load_queue.end(),
+              [&](const size_t a, const size_t b) {
+                  return chunkDist2(a) < chunkDist2(b); });
+    const size_t taken_ct { resident.size() + loading_ct };
+    const size_t free_ct { taken_ct < budget_chunk_ct ?
+                           budget_chunk_ct - taken_ct : 0 };
+    while (load_queue.size() > free_ct) {
+        chunk_states[load_queue.back()].store(ABSENT, std::memory_order_relaxed);
+        load_queue.pop_back();
+    }
+    return changed;
+}
+
+void TileChunkCache::writeFile(const std::string& map_filename,
+                               const uint8_t* tiles,
+                               const uint32_t _w, const uint32_t _h,
+                               const Vector2d& player_pos) {
+    std::ofstream map_ofs(map_filename, std::ios::binary);
+    std::ostringstream err_msg;
+    if (!map_ofs.is_open()) {
+        err_msg << "Could not open chunk map file for writing: " << map_filename;
+        throw std::runtime_error(err_msg.str());
+    }
+    map_ofs.precision(std::numeric_limits<double>::max_digits10);
+    map_ofs << CHUNK_MAP_HEADER << "\n" <<
+        _w << " " << _h << " " << uint16_t(CHUNK_LOG2) << "\n" <<
+        "player " << player_pos.x << " " << player_pos.y << "\n";
+    const uint32_t _chunks_w { (_w + CHUNK_MASK) >> CHUNK_LOG2 };
+    const uint32_t _chunks_h { (_h + CHUNK_MASK) >> CHUNK_LOG2 };
+    uint8_t chunk_row[CHUNK_SZ];
+    for (uint32_t chunk_y { 0 }; chunk_y < _chunks_h; ++chunk_y) {
+        for (uint32_t chunk_x { 0 }; chunk_x < _chunks_w; ++chunk_x) {
+            for (uint32_t row { 0 }; row < CHUNK_SZ; ++row) {
+                const uint64_t y { (uint64_t(chunk_y) << CHUNK_LOG2) + row };
+                for (uint32_t col { 0 }; col < CHUNK_SZ; ++col) {
+                    const uint64_t x { (uint64_t(chunk_x) << CHUNK_LOG2) + col };
+                    // padding past the map edge is wall
+                    chunk_row[col] = (x < _w && y < _h) ?
+                        tiles[(y * _w) + x] : 1;
+                }
+                map_ofs.write(reinterpret_cast<const char*>(chunk_row), CHUNK_SZ);
+            }
+        }
+    }
+    if (!map_ofs) {
+        err_msg << "Could not write chunk map file: " << map_filename;
+        throw std::runtime_error(err_msg.str());
+    }
+}
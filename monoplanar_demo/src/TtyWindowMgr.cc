@@ -21,161 +21,227 @@
 #include <algorithm>                  // max min
 
 
-void TtyWindowMgr::renderAsciiPixelColumn(const uint16_t screen_x,
-                                          const int16_t ceiling_screen_y,
+void TtyWindowMgr::renderAsciiPixelColumn(const Viewport& viewport,
+                                          const uint16_t view_x,
+                                          const int16_t ceiling_view_y,
                                           const uint16_t line_h,
-                                          const WallOrientation wall_hit_algnmt) {
-    uint16_t screen_y { 0 };
-    uint16_t screen_line_begin_y ( std::max(0, (int)ceiling_screen_y) );
-    uint16_t screen_line_end_y ( std::min((int)buffer.h, ceiling_screen_y + line_h) );
+                                          const char wall_c) {
+    uint16_t view_y { 0 };
+    uint16_t view_line_begin_y ( std::max(0, (int)ceiling_view_y) );
+    uint16_t view_line_end_y ( std::min((int)viewport.h, ceiling_view_y + line_h) );
     uint16_t screen_w { buffer.w };
-    TtyPixel* screen_px { buffer.pixel(screen_x, screen_y) };
+    TtyPixel* screen_px { buffer.pixel(viewport.x + view_x, viewport.y) };
     // draw ceiling
-    for (; screen_y < screen_line_begin_y; ++screen_y, screen_px += screen_w)
+    for (; view_y < view_line_begin_y; ++view_y, screen_px += screen_w)
         screen_px->c = ' ';
-    // draw wall, shading NS walls darker to differentiate
-    for (; screen_y < screen_line_end_y; ++screen_y, screen_px += screen_w) {
-        screen_px->c =
-            (wall_hit_algnmt == WallOrientation::NS) ? '|' : '@';
-    }
+    // draw wall
+    for (; view_y < view_line_end_y; ++view_y, screen_px += screen_w)
+        screen_px->c = wall_c;
     // draw floor
-    for (; screen_y < buffer.h; ++screen_y, screen_px += screen_w)
+    for (; view_y < viewport.h; ++view_y, screen_px += screen_w)
         screen_px->c = ' ';
 }
 
-void TtyWindowMgr::render256ColorPixelColumn(const uint16_t screen_x,
-                                             const int16_t ceiling_screen_y,
+void TtyWindowMgr::render256ColorPixelColumn(const Viewport& viewport,
+                                             const uint16_t view_x,
+                                             const int16_t ceiling_view_y,
                                              const uint16_t line_h,
-                                             const WallOrientation wall_hit_algnmt,
-                                             const SDL_Surface* texture,
-                                             const uint16_t tex_x) {
-    uint16_t screen_y { 0 };
-    uint16_t screen_line_begin_y ( std::max(0, (int)ceiling_screen_y) );
-    uint16_t screen_line_end_y ( std::min((int)buffer.h, ceiling_screen_y + line_h) );
+                                             const uint8_t* light_lut,
+                                             const WallTexColumn& tex_column,
+                                             const uint16_t fog_weight) {
+    // ceiling and floor are left to renderFloorCeilingRow
+    uint16_t view_y ( std::max(0, (int)ceiling_view_y) );
+    uint16_t view_line_end_y ( std::min((int)viewport.h, ceiling_view_y + line_h) );
     uint16_t screen_w { buffer.w };
-    TtyPixel* column_px { buffer.pixel(screen_x, screen_y) };
-    // draw ceiling
-    for (; screen_y < screen_line_begin_y; ++screen_y, column_px += screen_w) {
-        column_px->code = (uint8_t)Xterm::Color::Codes::System::Black;
-    }
-    // draw wall, shading NS walls darker to differentiate
-    double tex_h_ratio { texture->h / (double)line_h };
-    SDL_PixelFormat* tex_format { texture->format };
-    uint8_t* tex_px_data { (uint8_t*)(texture->pixels) + (tex_x * tex_format->BytesPerPixel) };
-    uint16_t tex_row_sz ( texture->pitch );
+    TtyPixel* column_px { buffer.pixel(viewport.x + view_x, viewport.y + view_y) };
+    // draw wall, lit by the face hit (and NS walls darker to differentiate)
+    double tex_h_ratio { tex_column.h / (double)line_h };
     uint8_t r, g, b;
-    for (uint16_t tex_y; screen_y < screen_line_end_y; ++screen_y, column_px += screen_w) {
+    for (uint16_t tex_y; view_y < view_line_end_y; ++view_y, column_px += screen_w) {
         // buffer traversal can optimize away calling `buffer.pixel(
-        //   screen_x, screen_y)` due a consistent step of screen_y += 1 each
+        //   screen_x, screen_y)` due a consistent step of view_y += 1 each
         //   loop; using a similar approach to texture traversal is difficult
         //   as we need to accommodate any possible tex_h:line_h ratio, and
-        //   so possibly inconsistent step values for tex_y as it is fit to screen_y
-        tex_y = (screen_y - ceiling_screen_y /*line_y*/) * tex_h_ratio;
-        SDL_GetRGB(*(uint32_t*)(tex_px_data + (tex_y * tex_row_sz)),
-                   tex_format, &r, &g, &b);
-        if (wall_hit_algnmt == WallOrientation::NS) {
-            r /= 2;
-            g /= 2;
-            b /= 2;
-        }
+        //   so possibly inconsistent step values for tex_y as it is fit to view_y
+        tex_y = (view_y - ceiling_view_y /*line_y*/) * tex_h_ratio;
+        shadeTexel(tex_column.texels[tex_y * tex_column.w], light_lut,
+                   fog_weight, r, g, b);
         column_px->code = Xterm::Color::Codes::fromRGB(r, g, b);
     }
-    // draw floor
-    for (; screen_y < buffer.h; ++screen_y, column_px += screen_w) {
-        column_px->code = (uint8_t)Xterm::Color::Codes::System::Black;
-    }
 }
 
-void TtyWindowMgr::renderTrueColorPixelColumn(const uint16_t screen_x,
-                                              const int16_t ceiling_screen_y,
+void TtyWindowMgr::renderTrueColorPixelColumn(const Viewport& viewport,
+                                              const uint16_t view_x,
+                                              const int16_t ceiling_view_y,
                                               const uint16_t line_h,
-                                              const WallOrientation wall_hit_algnmt,
-                                              const SDL_Surface* texture,
-                                              const uint16_t tex_x) {
-    uint16_t screen_y { 0 };
-    uint16_t screen_line_begin_y ( std::max(0, (int)ceiling_screen_y) );
-    uint16_t screen_line_end_y ( std::min((int)buffer.h, ceiling_screen_y + line_h) );
+                                              const uint8_t* light_lut,
+                                              const WallTexColumn& tex_column,
+                                              const uint16_t fog_weight) {
+    // ceiling and floor are left to renderFloorCeilingRow
+    uint16_t view_y ( std::max(0, (int)ceiling_view_y) );
+    uint16_t view_line_end_y ( std::min((int)viewport.h, ceiling_view_y + line_h) );
     uint16_t screen_w { buffer.w };
-    TtyPixel* screen_px { buffer.pixel(screen_x, screen_y) };
-    // draw ceiling
-    for (; screen_y < screen_line_begin_y; ++screen_y, screen_px += screen_w) {
-        screen_px->r = 0;
-        screen_px->g = 0;
-        screen_px->b = 0;
-    }
-    // draw wall, shading NS walls darker to differentiate
-    double tex_h_ratio { texture->h / (double)line_h };
-    SDL_PixelFormat* tex_format { texture->format };
-    uint8_t* tex_px_data { (uint8_t*)(texture->pixels) + (tex_x * tex_format->BytesPerPixel) };
-    uint16_t tex_row_sz ( texture->pitch );
+    TtyPixel* screen_px { buffer.pixel(viewport.x + view_x, viewport.y + view_y) };
+    // draw wall, lit by the face hit (and NS walls darker to differentiate)
+    double tex_h_ratio { tex_column.h / (double)line_h };
     uint8_t r, g, b;
-    for (uint16_t tex_y; screen_y < screen_line_end_y; ++screen_y, screen_px += screen_w) {
+    for (uint16_t tex_y; view_y < view_line_end_y; ++view_y, screen_px += screen_w) {
         // buffer traversal can optimize away calling `buffer.pixel(
-        //   screen_x, screen_y)` due a consistent step of screen_y += 1 each
+        //   screen_x, screen_y)` due a consistent step of view_y += 1 each
         //   loop; using a similar approach to texture traversal is difficult
         //   as we need to accommodate any possible tex_h:line_h ratio, and
-        //   so possibly inconsistent step values for tex_y as it is fit to screen_y
-        tex_y = (screen_y - ceiling_screen_y /*line_y*/) * tex_h_ratio;
-        SDL_GetRGB(*(uint32_t*)(tex_px_data + (tex_y * tex_row_sz)),
-                   tex_format, &r, &g, &b);
-        if (wall_hit_algnmt == WallOrientation::NS) {
-            r /= 2;
-            g /= 2;
-            b /= 2;
-        }
+        //   so possibly inconsistent step values for tex_y as it is fit to view_y
+        tex_y = (view_y - ceiling_view_y /*line_y*/) * tex_h_ratio;
+        shadeTexel(tex_column.texels[tex_y * tex_column.w], light_lut,
+                   fog_weight, r, g, b);
         screen_px->r = r;
         screen_px->g = g;
         screen_px->b = b;
     }
-    // draw floor
-    for (; screen_y < buffer.h; ++screen_y, screen_px += screen_w) {
-        screen_px->r = 0;
-        screen_px->g = 0;
-        screen_px->b = 0;
-    }
 }
 
-// TBD: make public member? In case of building for optional multithreading,
-//   each thread would have to trace a batch of rays, then render their
-//   respective pixel columns without stopping to wait for the others,
-//   which means each thread would have to call this.
-// The core illusion of raycasting comes from rendering walls in vertical
-//   strips, one per each ray cast in the FOV, with each strip being longer
-//   as the ray is shorter/wall is closer, forcing perspective.
-void TtyWindowMgr::renderPixelColumn(const uint16_t screen_x,
-                                     const FovRay& ray,
-                                     const TtyDisplayMode tty_display_mode) {
+// Called from multiple threads at once (see WindowMgr::renderViews), which is
+//   safe as each call only writes to its own pixel column in buffer.
+void TtyWindowMgr::renderPixelColumn(const Viewport& viewport,
+                                     const uint16_t view_x,
+                                     const FovRayBuffer& fov_rays,
+                                     const Settings& settings) {
+    const TtyDisplayMode tty_display_mode { settings.tty_display_mode };
 
-    // calculate height of vertical strip of wall to draw on screen
-    uint16_t line_h ( buffer.h / ray.wall_hit.dist );
+    const WallOrientation algnmt { fov_rays.algnmt[view_x] };
 
-    // row index of highest pixel in strip (may be negative if camera is close
-    //   to wall and wall unit does not fit in frame)
-    int16_t ceiling_screen_y ( buffer.h / 2 - line_h / 2 );
+    // calculate height and top row of vertical strip of wall to draw in
+    //   viewport
+    uint16_t line_h;
+    int16_t ceiling_view_y;
+    wallLine(viewport.h, fov_rays.dist[view_x], line_h, ceiling_view_y);
 
     if (tty_display_mode == TtyDisplayMode::Ascii) {
-        return renderAsciiPixelColumn(screen_x, ceiling_screen_y, line_h,
-                                      ray.wall_hit.algnmt);
+        // shading NS walls darker to differentiate, and draw distance as a
+        //   fog line
+        const char wall_c {
+            (fov_rays.tex_key[view_x] == FovRayBuffer::NO_HIT_TEX_KEY) ? '.' :
+            ((algnmt == WallOrientation::NS) ? '|' : '@') };
+        return renderAsciiPixelColumn(viewport, view_x, ceiling_view_y, line_h,
+                                      wall_c);
     }
 
-    // TBD: add protection for out of range tex key? or in map parsing?
-    // find proportionate x coordinate in wall texture
-    SDL_Surface* texture { wall_texs.at(ray.wall_hit.tex_key).get() };
-    uint16_t tex_x ( ray.wall_hit.x * texture->w );
-    // ensure texture x of 0 is always to the left when facing the wall segment
-    if ((ray.wall_hit.algnmt == WallOrientation::NS && ray.dir.x > 0) ||
-        (ray.wall_hit.algnmt == WallOrientation::EW && ray.dir.y < 0) ) {
-        tex_x = texture->w - tex_x - 1;
-    }
+    const WallTexColumn tex_column {
+        wallTexColumn(view_x, fov_rays, line_h, settings) };
+    const uint16_t fog_weight { fogWeight(fov_rays.dist[view_x], settings) };
+    const uint8_t* light_lut { lightLut(wallLightLevel(fov_rays.light[view_x],
+                                                       algnmt)) };
 
     if (tty_display_mode == TtyDisplayMode::ColorCode) {
-        return render256ColorPixelColumn(screen_x, ceiling_screen_y, line_h,
-                                         ray.wall_hit.algnmt, texture, tex_x);
+        return render256ColorPixelColumn(viewport, view_x, ceiling_view_y,
+                                         line_h, light_lut, tex_column, fog_weight);
     }
 
     if (tty_display_mode == TtyDisplayMode::TrueColor) {
-        return renderTrueColorPixelColumn(screen_x, ceiling_screen_y, line_h,
-                                          ray.wall_hit.algnmt, texture, tex_x);
+        return renderTrueColorPixelColumn(viewport, view_x, ceiling_view_y,
+                                          line_h, light_lut, tex_column, fog_weight);
+    }
+}
+
+bool TtyWindowMgr::castsFloorCeiling(const Settings& settings) const {
+    // ascii mode has no textures, and draws floor and ceiling as blank
+    return settings.tty_display_mode != TtyDisplayMode::Ascii;
+}
+
+// Called from multiple threads at once, for the columns of different strips.
+void TtyWindowMgr::renderFloorCeilingRow(const Viewport& viewport,
+                                         const uint16_t floor_view_y,
+                                         const uint16_t begin_x,
+                                         const uint16_t end_x,
+                                         const Settings& settings) {
+    const uint16_t ceiling_view_y ( viewport.h - 1 - floor_view_y );
+    TtyPixel* floor_px { buffer.pixel(viewport.x, viewport.y + floor_view_y) };
+    TtyPixel* ceiling_px { buffer.pixel(viewport.x, viewport.y + ceiling_view_y) };
+    const uint32_t* floor_rgb { floor_row_rgb.data() + viewport.x };
+    const uint32_t* ceiling_rgb { ceiling_row_rgb.data() + viewport.x };
+    const uint16_t* wall_begin_y { column_wall_begin_y.data() + viewport.x };
+    const uint16_t* wall_end_y { column_wall_end_y.data() + viewport.x };
+    const uint16_t column_step { settings.column_scale };
+    // mode tested once per row rather than per pixel
+    if (settings.tty_display_mode == TtyDisplayMode::ColorCode) {
+        for (uint16_t view_x { begin_x }; view_x < end_x; view_x += column_step) {
+            if (floor_view_y >= wall_end_y[view_x]) {
+                const uint32_t rgb { floor_rgb[view_x] };
+                floor_px[view_x].code =
+                    Xterm::Color::Codes::fromRGB(rgb >> 16, rgb >> 8, rgb);
+            }
+            // middle row of odd height viewport is floor, not also ceiling
+            if (ceiling_view_y < wall_begin_y[view_x] &&
+                ceiling_view_y != floor_view_y) {
+                const uint32_t rgb { ceiling_rgb[view_x] };
+                ceiling_px[view_x].code =
+                    Xterm::Color::Codes::fromRGB(rgb >> 16, rgb >> 8, rgb);
+            }
+        }
+        return;
+    }
+    for (uint16_t view_x { begin_x }; view_x < end_x; view_x += column_step) {
+        if (floor_view_y >= wall_end_y[view_x]) {
+            const uint32_t rgb { floor_rgb[view_x] };
+            floor_px[view_x].r = rgb >> 16;
+            floor_px[view_x].g = rgb >> 8;
+            floor_px[view_x].b = rgb;
+        }
+        if (ceiling_view_y < wall_begin_y[view_x] &&
+            ceiling_view_y != floor_view_y) {
+            const uint32_t rgb { ceiling_rgb[view_x] };
+            ceiling_px[view_x].r = rgb >> 16;
+            ceiling_px[view_x].g = rgb >> 8;
+            ceiling_px[view_x].b = rgb;
+        }
+    }
+}
+
+// Called from multiple threads at once, like renderPixelColumn.
+void TtyWindowMgr::renderSpriteColumn(const Viewport& viewport,
+                                      const uint16_t view_x,
+                                      const ViewSprite& sprite,
+                                      const uint32_t* tex_column,
+                                      const Settings& settings) {
+    const TtyDisplayMode tty_display_mode { settings.tty_display_mode };
+    uint16_t view_y ( std::max(0, (int)sprite.top_y) );
+    const uint16_t view_end_y (
+        std::min((int)viewport.h, sprite.top_y + sprite.h) );
+    uint16_t screen_w { buffer.w };
+    TtyPixel* screen_px { buffer.pixel(viewport.x + view_x, viewport.y + view_y) };
+    const double tex_h_ratio { SPRITE_TEX_SZ / (double)sprite.h };
+    uint8_t r, g, b;
+    for (uint16_t tex_y; view_y < view_end_y; ++view_y, screen_px += screen_w) {
+        tex_y = (view_y - sprite.top_y) * tex_h_ratio;
+        const uint32_t texel { tex_column[tex_y * SPRITE_TEX_SZ] };
+        // transparent
+        if (texel >> 24 == 0)
+            continue;
+        if (tty_display_mode == TtyDisplayMode::Ascii) {
+            screen_px->c = '%';
+            continue;
+        }
+        // EW, as sprites always face the camera and so are not shaded
+        shadeTexel(texel, sprite.light_lut, sprite.fog_weight, r, g, b);
+        if (tty_display_mode == TtyDisplayMode::ColorCode) {
+            screen_px->code = Xterm::Color::Codes::fromRGB(r, g, b);
+        } else {
+            screen_px->r = r;
+            screen_px->g = g;
+            screen_px->b = b;
+        }
+    }
+}
+
+void TtyWindowMgr::copyPixelColumn(const Viewport& viewport,
+                                   const uint16_t src_view_x,
+                                   const uint16_t dst_view_x) {
+    uint16_t screen_w { buffer.w };
+    const TtyPixel* src_px { buffer.pixel(viewport.x + src_view_x, viewport.y) };
+    TtyPixel* dst_px { buffer.pixel(viewport.x + dst_view_x, viewport.y) };
+    for (uint16_t view_y { 0 }; view_y < viewport.h;
+         ++view_y, src_px += screen_w, dst_px += screen_w) {
+        *dst_px = *src_px;
     }
 }
 
@@ -206,7 +272,7 @@ void TtyWindowMgr::drawEmptyFrame() {
 }
 
 void TtyWindowMgr::initialize(const Settings& settings,
-                              const uint16_t layout_h) {
+                              const uint32_t layout_h) {
     // Use of ttyname taken from coreutils tty, see:
     //  - https://github.com/coreutils/coreutils/blob/master/src/tty.c
     tty_name = safeLibcCall(ttyname, "ttyname",
@@ -229,6 +295,9 @@ void TtyWindowMgr::initialize(const Settings& settings,
                             wall_tex_paths[i]) ) );
         std::cout << "Loaded texture: " << wall_tex_paths[i] << '\n';
     }
+    buildWallTexLevels();
+    buildSpriteTexs();
+    buildLightLuts();
 
     // force scrollback of all terminal text by drawing an empty frame
     //   (buffer default init is to all black ' ' chars)
@@ -239,7 +308,7 @@ void TtyWindowMgr::initialize(const Settings& settings,
 }
 
 void TtyWindowMgr::fitToWindow(const double map_proportion,
-                               const uint16_t /*layout_h*/) {
+                               const uint32_t /*layout_h*/) {
     // get terminal window size in chars
     // use of TIOCGWINSZ taken from coreutils stty, see:
     //   - https://github.com/wertarbyte/coreutils/blob/master/src/stty.c#L1311
@@ -260,15 +329,8 @@ void TtyWindowMgr::fitToWindow(const double map_proportion,
     minimap_w = (minimap_h * 2) + 1;
 }
 
-void TtyWindowMgr::renderView(const std::vector<FovRay>& fov_rays,
-                               const Settings& settings) {
-    TtyDisplayMode tty_display_mode { settings.tty_display_mode };
-    for (uint16_t screen_x { 0 }; screen_x < buffer.w; ++screen_x) {
-        renderPixelColumn(screen_x, fov_rays[screen_x], tty_display_mode);
-    }
-}
-
-void TtyWindowMgr::renderMap(const DdaRaycastEngine& raycast_engine) {
+void TtyWindowMgr::renderMap(const DdaRaycastEngine& raycast_engine,
+                             const SpriteGrid& sprites) {
     // assert(state->map_dims % 2);
     if (minimap_h < 5 || minimap_w >= buffer.w)
         return;
@@ -281,19 +343,19 @@ void TtyWindowMgr::renderMap(const DdaRaycastEngine& raycast_engine) {
     buffer.pixelCharReplace(window_col_i, window_row_i,
                             line.c_str(), bordered_map_w);
     ++window_row_i;
-    const uint16_t player_x ( raycast_engine.player_pos.x );
-    const uint16_t player_y ( raycast_engine.player_pos.y );
-    const uint16_t map_delta_y ( minimap_h / 2 );
-    const uint16_t map_delta_x ( minimap_w / 2 );
-    for (int16_t map_y ( player_y + map_delta_y );
+    const int64_t player_x ( raycast_engine.player_pos.x );
+    const int64_t player_y ( raycast_engine.player_pos.y );
+    const int64_t map_delta_y ( minimap_h / 2 );
+    const int64_t map_delta_x ( minimap_w / 2 );
+    for (int64_t map_y ( player_y + map_delta_y );
          map_y >= player_y - map_delta_y; --map_y, ++window_row_i) {
         line.clear();
         line.push_back(' ');  // left border
-        for (int16_t map_x ( player_x - map_delta_x );
+        for (int64_t map_x ( player_x - map_delta_x );
              map_x <= player_x + map_delta_x; ++map_x) {
             if (map_x < 0 || map_y < 0 ||
-                map_x >= static_cast<int16_t>(raycast_engine.layout.w) ||
-                map_y >= static_cast<int16_t>(raycast_engine.layout.h) ||
+                map_x >= static_cast<int64_t>(raycast_engine.layout.w) ||
+                map_y >= static_cast<int64_t>(raycast_engine.layout.h) ||
                 !raycast_engine.layout.tileIsWall(map_x, map_y)) {
                 line.push_back(' ');
             } else {
@@ -327,6 +389,22 @@ void TtyWindowMgr::renderMap(const DdaRaycastEngine& raycast_engine) {
         buffer.pixelCharReplace(window_col_i, window_row_i,
                                 line.c_str(), bordered_map_w);
     }
+    // sprites drawn over their tiles, other than the player's
+    sprites.forEachNear(
+        player_x - map_delta_x, player_y - map_delta_y,
+        player_x + map_delta_x + 1, player_y + map_delta_y + 1,
+        [&](const Sprite& sprite) {
+            const int64_t map_x ( sprite.x );
+            const int64_t map_y ( sprite.y );
+            if ((map_x == player_x && map_y == player_y) ||
+                map_x < player_x - map_delta_x || map_x > player_x + map_delta_x ||
+                map_y < player_y - map_delta_y || map_y > player_y + map_delta_y) {
+                return;
+            }
+            buffer.pixelCharReplace(
+                window_col_i + 1 + (map_x - (player_x - map_delta_x)),
+                1 + ((player_y + map_delta_y) - map_y), "o", 1);
+        });
     // bottom border
     line.clear();
     line.resize(bordered_map_w, ' ');
@@ -338,6 +416,7 @@ void TtyWindowMgr::renderHud(const double pt_frame_duration_mvg_avg,
                              const double rt_frame_duration_mvg_avg,
                              const Settings& settings,
                              const DdaRaycastEngine& raycast_engine,
+                             const AgentSim& agent_sim,
                              const KbdInputMgr* kbd_input_mgr) {
     // Using sprintf over idiomatic C++ to get exact precision on floating
     //   point values (not using C++20, so std::format is not an option.)
@@ -350,46 +429,74 @@ void TtyWindowMgr::renderHud(const double pt_frame_duration_mvg_avg,
         buffer.pixelCharReplace(0, 0, line, line_sz);
     }
 
-    if (settings.debug_mode && buffer.h >= 10) {
+    if (settings.debug_mode && buffer.h >= HUD_DEBUG_LINE_CT) {
+        uint16_t row_i { 1 };
         line_sz = std::sprintf(line, "show_fps(F1): %i show_map(F2): %i ",
                                settings.show_fps, settings.show_map);
-        buffer.pixelCharReplace(0, 1, line, line_sz);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
         line_sz = std::sprintf(line, "debug_mode(F3): %i euclidean(F4): %i ",
                                settings.debug_mode, settings.euclidean);
-        buffer.pixelCharReplace(0, 2, line, line_sz);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
+        line_sz = std::sprintf(line, "ray_packets(F5): %i scalar: %s ",
+                               settings.ray_packets,
+                               scalarTypeName(settings.scalar_type));
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
+        const RayCacheStats ray_cache_stats { raycast_engine.rayCacheStats() };
+        line_sz = std::sprintf(line, "ray_cache(F6): %i hits: %4u misses: %4u ",
+                               settings.ray_cache, ray_cache_stats.frame_hit_ct,
+                               ray_cache_stats.frame_miss_ct);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
+        line_sz = std::sprintf(line, "skip(F7): %s steps/ray: %6.2f ",
+                               emptySpaceSkipName(settings.empty_space_skip),
+                               raycast_engine.frameStepsPerRay());
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
+        line_sz = std::sprintf(line, "draw_dist: %6.1f texture_lod(F8): %i ",
+                               settings.draw_dist, settings.texture_lod);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
+        line_sz = std::sprintf(line, "target_fps: %5.1f column_scale: %u ",
+                               settings.target_fps, settings.column_scale);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
+        line_sz = std::sprintf(line, "interleave(F9): %i wall_spans: %i pvs: %i ",
+                               settings.interleave, settings.wall_spans,
+                               settings.pvs);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
+        line_sz = std::sprintf(line, "agents: %u update: %6.2fms ",
+                               agent_sim.size(),
+                               agent_sim.update_duration * 1000);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
 
         // -ddd.ddd format
         line_sz = std::sprintf(line, "player_pos: {%8.3f, %8.3f} ",
                                raycast_engine.player_pos.x,
                                raycast_engine.player_pos.y);
-        buffer.pixelCharReplace(0, 3, line, line_sz);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
         line_sz = std::sprintf(line, "player_dir: {%8.3f, %8.3f} ",
                                raycast_engine.player_dir.x,
                                raycast_engine.player_dir.y);
-        buffer.pixelCharReplace(0, 4, line, line_sz);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
         line_sz = std::sprintf(line, "view_plane: {%8.3f, %8.3f} ",
                                raycast_engine.view_plane.x,
                                raycast_engine.view_plane.y);
-        buffer.pixelCharReplace(0, 5, line, line_sz);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
 
         line_sz = std::sprintf(line, "window: %4uw : %4uh (%8.6f) ",
                                buffer.w, buffer.h, (double(buffer.w) / buffer.h));
-        buffer.pixelCharReplace(0, 6, line, line_sz);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
 
         line_sz = std::sprintf(line, "user input keys: ");
-        buffer.pixelCharReplace(0, 7, line, line_sz);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
         line_sz = std::sprintf(line, "down: %i right: %i up: %i left: %i ",
                                kbd_input_mgr->isPressed(KEY_DOWN),
                                kbd_input_mgr->isPressed(KEY_RIGHT),
                                kbd_input_mgr->isPressed(KEY_UP),
                                kbd_input_mgr->isPressed(KEY_LEFT));
-        buffer.pixelCharReplace(0, 8, line, line_sz);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
         line_sz = std::sprintf(line, "Lshft:%i Rshft:%i Lalt:%i Ralt:%i ",
                                kbd_input_mgr->isPressed(KEY_LEFTSHIFT),
                                kbd_input_mgr->isPressed(KEY_RIGHTSHIFT),
                                kbd_input_mgr->isPressed(KEY_LEFTALT),
                                kbd_input_mgr->isPressed(KEY_RIGHTALT));
-        buffer.pixelCharReplace(0, 9, line, line_sz);
+        buffer.pixelCharReplace(0, row_i++, line, line_sz);
     }
 }
 
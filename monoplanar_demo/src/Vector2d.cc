@@ -3,13 +3,10 @@
 #include <cmath>  // atan cos sin
 
 
-Vector2d Vector2d::operator+(const Vector2d other) {
-    return Vector2d { this->x + other.x, this->y + other.y };
-}
-
 // https://stackoverflow.com/questions/6247153/angle-from-2d-unit-vector
-double Vector2d::angle() const {
-    double angle { radiansToDegrees(std::atan(this->y / this->x)) };
+template <typename ScalarType>
+double Vector2<ScalarType>::angle() const {
+    double angle { radiansToDegrees(std::atan(double(this->y) / this->x)) };
     if (this->x < 0)  // quadrant II or III
         angle = 180 + angle;  // subtracts
     else if (this->y < 0)  // quadrant IV
@@ -19,9 +16,14 @@ double Vector2d::angle() const {
 
 // counterclockwise (QI to QIV) for positive `radians`
 // using 2d vector rotation matrix, see: https://www.cuemath.com/algebra/rotation-matrix/
-void Vector2d::rotate(const double radians) {
-    Vector2d rotation {
+template <typename ScalarType>
+void Vector2<ScalarType>::rotate(const double radians) {
+    Vector2 rotation (
         std::cos(radians) * this->x - std::sin(radians) * this->y,
-        std::sin(radians) * this->x + std::cos(radians) * this->y };
+        std::sin(radians) * this->x + std::cos(radians) * this->y );
     *this = rotation;
 }
+
+// angle() and rotate() are only meaningful for floating point vectors
+template class Vector2<double>;
+template class Vector2<float>;
@@ -0,0 +1,678 @@
+#include "WindowMgr.hh"
+#include "DdaRaycastEngine.hh"
+#include "ThreadPool.hh"
+
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_pixels.h>  // SDL_GetRGB
+
+#include <cstdint>
+#include <cmath>       // sqrt hypot
+
+#include <algorithm>   // max min sort clamp
+#include <utility>     // move
+#include <type_traits> // true_type false_type
+
+
+/**
+ * @brief floor of a float, as an integer
+ *
+ * @param t - value within INT32_MAX of 0
+ */
+static int32_t floorToInt(const float t) {
+    // conversion truncates toward 0, then negative fractions step down; unlike
+    //   std::floor, which is a libm call without SSE4.1
+    const int32_t i ( t );
+    return i - (t < i);
+}
+
+void WindowMgr::renderView(DdaRaycastEngine& raycast_engine,
+                           const SpriteGrid& sprites,
+                           const Settings& settings, ThreadPool& thread_pool) {
+    renderViews({ CameraView { &raycast_engine,
+                               Viewport { 0, 0, width(), height() } } },
+                sprites, settings, thread_pool);
+}
+
+void WindowMgr::renderViews(const std::vector<CameraView>& views,
+                            const SpriteGrid& sprites,
+                            const Settings& settings, ThreadPool& thread_pool) {
+    // Views sharing any window column go in separate passes, even if they
+    //   do not overlap (eg stacked vertically), as the per column scratch
+    //   buffers (column_wall_begin_y...) are indexed by window column.
+    const auto shareColumns { [](const Viewport& a, const Viewport& b) {
+        return a.x < b.x + b.w && b.x < a.x + a.w; } };
+    if (pass_view_sprites.size() < views.size())
+        pass_view_sprites.resize(views.size());
+    column_wall_begin_y.resize(width());
+    column_wall_end_y.resize(width());
+    floor_row_rgb.resize(width());
+    ceiling_row_rgb.resize(width());
+    for (uint16_t pass_begin { 0 }, pass_end; pass_begin < views.size();
+         pass_begin = pass_end) {
+        // views in a pass write disjoint window columns
+        for (pass_end = pass_begin + 1; pass_end < views.size(); ++pass_end) {
+            bool shares_pass_columns { false };
+            for (uint16_t view_i { pass_begin }; view_i < pass_end; ++view_i) {
+                shares_pass_columns = shares_pass_columns ||
+                    shareColumns(views[view_i].viewport, views[pass_end].viewport);
+            }
+            if (shares_pass_columns)
+                break;
+        }
+        uint32_t pass_w { 0 };
+        for (uint16_t view_i { pass_begin }; view_i < pass_end; ++view_i) {
+            beginView(views[view_i].viewport, settings);
+            views[view_i].camera->beginFrame(settings);
+            projectSprites(views[view_i], sprites, settings,
+                           pass_view_sprites[view_i - pass_begin]);
+            pass_w += views[view_i].viewport.w;
+        }
+        uint16_t strip_w ( std::max(
+            pass_w / (thread_pool.size() * STRIPS_PER_THREAD),
+            uint32_t(MIN_STRIP_W)) );
+        // round up to whole ray packets so that only the last strip of each
+        //   view needs a scalar remainder
+        constexpr uint16_t packet_sz { DdaRaycastEngine::RAY_PACKET_SZ };
+        strip_w = ((strip_w + packet_sz - 1) / packet_sz) * packet_sz;
+        view_strips.clear();
+        strip_sprite_is.clear();
+        for (uint16_t view_i { pass_begin }; view_i < pass_end; ++view_i) {
+            const uint16_t view_w { views[view_i].viewport.w };
+            const std::vector<ViewSprite>& view_sprites {
+                pass_view_sprites[view_i - pass_begin] };
+            for (uint32_t begin_x { 0 }; begin_x < view_w; begin_x += strip_w) {
+                const uint16_t end_x (
+                    std::min(begin_x + strip_w, uint32_t(view_w)) );
+                // cull sprites to strips here, so that columns only test
+                //   sprites near them
+                const uint32_t sprite_is_begin ( strip_sprite_is.size() );
+                for (uint32_t sprite_i { 0 }; sprite_i < view_sprites.size();
+                     ++sprite_i) {
+                    if (view_sprites[sprite_i].begin_x < end_x &&
+                        view_sprites[sprite_i].end_x > begin_x) {
+                        strip_sprite_is.push_back(sprite_i);
+                    }
+                }
+                view_strips.push_back(ViewStrip {
+                        &views[view_i], uint16_t(begin_x), end_x, &view_sprites,
+                        sprite_is_begin, uint32_t(strip_sprite_is.size()) });
+            }
+        }
+        thread_pool.forEachStrip(
+            view_strips.size(), 1,
+            [&](const uint32_t begin, const uint32_t end) {
+                for (uint32_t strip_i { begin }; strip_i < end; ++strip_i) {
+                    const ViewStrip& strip { view_strips[strip_i] };
+                    const Viewport& viewport { strip.view->viewport };
+                    DdaRaycastEngine& camera { *strip.view->camera };
+                    // strip is narrow enough that its rays are still in cache
+                    //   when rendered
+                    camera.castRays(strip.begin_x, strip.end_x, settings);
+                    // strip_w is a multiple of column_scale (a power of 2 no
+                    //   larger than the packet size), so each strip starts on
+                    //   a cast column
+                    const uint16_t column_step { settings.column_scale };
+                    for (uint16_t view_x ( strip.begin_x ); view_x < strip.end_x;
+                         view_x += column_step) {
+                        renderPixelColumn(viewport, view_x, camera.fov_rays,
+                                          settings);
+                        uint16_t line_h;
+                        int16_t ceiling_view_y;
+                        wallLine(viewport.h, camera.fov_rays.dist[view_x],
+                                 line_h, ceiling_view_y);
+                        column_wall_begin_y[viewport.x + view_x] =
+                            std::max(0, int(ceiling_view_y));
+                        column_wall_end_y[viewport.x + view_x] =
+                            std::min(int(viewport.h), ceiling_view_y + line_h);
+                    }
+                    if (castsFloorCeiling(settings)) {
+                        for (uint16_t floor_view_y ( viewport.h / 2 );
+                             floor_view_y < viewport.h; ++floor_view_y) {
+                            castFloorCeilingRow(*strip.view, floor_view_y,
+                                                strip.begin_x, strip.end_x,
+                                                settings);
+                            renderFloorCeilingRow(viewport, floor_view_y,
+                                                  strip.begin_x, strip.end_x,
+                                                  settings);
+                        }
+                    }
+                    for (uint16_t view_x ( strip.begin_x ); view_x < strip.end_x;
+                         view_x += column_step) {
+                        // sprites narrower than column_step may fall between
+                        //   cast columns, so draw any covering the copied
+                        //   columns too, from their nearest column
+                        const uint16_t step_end_x ( std::min(
+                            view_x + column_step, int(strip.end_x)) );
+                        const float wall_dist { camera.fov_rays.dist[view_x] };
+                        for (uint32_t k { strip.sprite_is_begin };
+                             k < strip.sprite_is_end; ++k) {
+                            const ViewSprite& sprite {
+                                (*strip.sprites)[strip_sprite_is[k]] };
+                            const uint16_t sprite_x {
+                                std::max(view_x, sprite.begin_x) };
+                            if (sprite_x < std::min(step_end_x, sprite.end_x) &&
+                                sprite.dist < wall_dist) {
+                                renderSpriteColumn(
+                                    viewport, view_x, sprite,
+                                    spriteTexColumn(sprite, sprite_x), settings);
+                            }
+                        }
+                        for (uint16_t copy_x ( view_x + 1 ); copy_x < step_end_x;
+                             ++copy_x) {
+                            copyPixelColumn(viewport, view_x, copy_x);
+                        }
+                    }
+                }
+            });
+    }
+    endView(settings);
+}
+
+void WindowMgr::buildWallTexLevels() {
+    wall_tex_levels.clear();
+    wall_tex_levels.resize(wall_texs.size());
+    wall_tex_levels[FovRayBuffer::NO_HIT_TEX_KEY].push_back(
+        WallTexLevel { 1, 1, { FOG_RGB } });
+    for (uint8_t tex_key { 1 }; tex_key < wall_texs.size(); ++tex_key) {
+        const SDL_Surface* texture { wall_texs[tex_key].get() };
+        std::vector<WallTexLevel>& levels { wall_tex_levels[tex_key] };
+        WallTexLevel full { uint16_t(texture->w), uint16_t(texture->h), {} };
+        full.texels.resize(full.w * full.h);
+        const uint8_t* tex_px_data { (const uint8_t*)texture->pixels };
+        uint8_t r, g, b;
+        for (uint16_t y { 0 }; y < full.h; ++y) {
+            const uint8_t* px { tex_px_data + (y * texture->pitch) };
+            for (uint16_t x { 0 }; x < full.w;
+                 ++x, px += texture->format->BytesPerPixel) {
+                SDL_GetRGB(*(const uint32_t*)px, texture->format, &r, &g, &b);
+                full.texels[(y * full.w) + x] = (r << 16) | (g << 8) | b;
+            }
+        }
+        levels.push_back(std::move(full));
+        while (levels.back().w > 1 && levels.back().h > 1) {
+            const WallTexLevel& prev { levels.back() };
+            WallTexLevel half { uint16_t(prev.w / 2), uint16_t(prev.h / 2), {} };
+            half.texels.resize(half.w * half.h);
+            for (uint16_t y { 0 }; y < half.h; ++y) {
+                for (uint16_t x { 0 }; x < half.w; ++x) {
+                    const uint32_t* quad {
+                        prev.texels.data() + (2 * y * prev.w) + (2 * x) };
+                    uint32_t texel { 0 };
+                    // average each channel of the 2x2 texels
+                    for (const uint8_t shift : { 16, 8, 0 }) {
+                        const uint32_t sum {
+                            ((quad[0] >> shift) & 0xff) +
+                            ((quad[1] >> shift) & 0xff) +
+                            ((quad[prev.w] >> shift) & 0xff) +
+                            ((quad[prev.w + 1] >> shift) & 0xff) };
+                        texel |= ((sum + 2) / 4) << shift;
+                    }
+                    half.texels[(y * half.w) + x] = texel;
+                }
+            }
+            levels.push_back(std::move(half));
+        }
+    }
+}
+
+const WindowMgr::WallTexLevel& WindowMgr::floorCeilingTexLevel(
+    const uint8_t tex_key, const float px_per_unit,
+    const Settings& settings) const {
+    const std::vector<WallTexLevel>& levels { wall_tex_levels.at(tex_key) };
+    uint8_t level_i { 0 };
+    if (settings.texture_lod) {
+        while (level_i + 1u < levels.size() &&
+               levels[level_i + 1].w >= px_per_unit) {
+            ++level_i;
+        }
+    }
+    return levels[level_i];
+}
+
+void WindowMgr::castFloorCeilingRow(const CameraView& view,
+                                    const uint16_t floor_view_y,
+                                    const uint16_t begin_x, const uint16_t end_x,
+                                    const Settings& settings) {
+    const DdaRaycastEngine& camera { *view.camera };
+    const Viewport& viewport { view.viewport };
+    const Vector2d& pos { camera.player_pos };
+    const Vector2d& dir { camera.player_dir };
+    const Vector2d& plane { camera.view_plane };
+    // distance of a wall whose strip (see wallLine) ends at the center of
+    //   the row; the middle row of an odd height viewport straddles the
+    //   horizon, so is clamped to half a row below it
+    const float row_dist ( viewport.h /
+        (2 * std::max(floor_view_y + 0.5f - (viewport.h / 2.0f), 0.5f)) );
+    const double plane_mag_sq { (plane.x * plane.x) + (plane.y * plane.y) };
+    const float px_per_unit ( viewport.w /
+                              (2 * std::sqrt(plane_mag_sq) * row_dist) );
+    const WallTexLevel& floor_level {
+        floorCeilingTexLevel(FLOOR_TEX_KEY, px_per_unit, settings) };
+    const WallTexLevel& ceiling_level {
+        floorCeilingTexLevel(CEILING_TEX_KEY, px_per_unit, settings) };
+    const uint16_t fog_weight { fogWeight(row_dist, settings) };
+
+    // Map point under column x is pos + row_dist * (dir + plane * camera_x),
+    //   as DdaRaycastEngine column rays are dir + plane * camera_x, with
+    //   camera_x = (2 * x / w) - 1. Points are kept relative to the corner of
+    //   the player's tile, so that floats keep their precision far from the
+    //   map origin without changing the fractional (texture) part.
+    const float pos_x ( pos.x - std::floor(pos.x) );
+    const float pos_y ( pos.y - std::floor(pos.y) );
+    const float left_x ( row_dist * (dir.x - plane.x) );
+    const float left_y ( row_dist * (dir.y - plane.y) );
+    const float step_x ( row_dist * 2 * plane.x / viewport.w );
+    const float step_y ( row_dist * 2 * plane.y / viewport.w );
+    const float camera_x_step ( 2.0 / viewport.w );
+    const float plane_mag_sq_f ( plane_mag_sq );
+    const bool euclidean { settings.euclidean };
+
+    // fog blended into packed 0xRRGGBB texels, red and blue at once, as with
+    //   shadeTexel (without NS shading)
+    const uint32_t texel_weight ( FOG_WEIGHT_MAX - fog_weight );
+    const uint32_t fog_rb ( (FOG_RGB & 0xff00ff) * fog_weight );
+    const uint32_t fog_g ( (FOG_RGB & 0x00ff00) * fog_weight );
+    const auto fogTexel { [&](const uint32_t texel) {
+        return (((((texel & 0xff00ff) * texel_weight) + fog_rb) /
+                 FOG_WEIGHT_MAX) & 0xff00ff) |
+            (((((texel & 0x00ff00) * texel_weight) + fog_g) /
+              FOG_WEIGHT_MAX) & 0x00ff00); } };
+
+    // floor texels scaled by the light of their tile (see Layout::tileLight)
+    //   on maps with lights, and the ceiling by half that, as the ceiling is
+    //   halved on maps without; tile indices are clamped to the map, as rows
+    //   extend past its edge behind the perimeter walls
+    const Layout& layout { camera.layout };
+    const int64_t tile_x ( std::floor(pos.x) );
+    const int64_t tile_y ( std::floor(pos.y) );
+    const int64_t max_tile_x ( layout.w - 1 );
+    const int64_t max_tile_y ( layout.h - 1 );
+    const auto lightTexel { [](const uint32_t texel, const uint8_t* light_lut) {
+        return (uint32_t(light_lut[(texel >> 16) & 0xff]) << 16) |
+            (uint32_t(light_lut[(texel >> 8) & 0xff]) << 8) |
+            light_lut[texel & 0xff]; } };
+
+    uint32_t* floor_rgb { floor_row_rgb.data() + viewport.x };
+    uint32_t* ceiling_rgb { ceiling_row_rgb.data() + viewport.x };
+    const uint16_t column_step { settings.column_scale };
+    const auto isPow2 { [](const uint16_t size) {
+        return (size & (size - 1)) == 0; } };
+    // texture levels are halved from the loaded size, so all are powers of 2
+    //   for power of 2 textures
+    const bool pow2_texs { isPow2(floor_level.w) && isPow2(floor_level.h) &&
+                           isPow2(ceiling_level.w) && isPow2(ceiling_level.h) };
+
+    // Rows of perpendicular distances with power of 2 textures (the usual
+    //   case) step across the row in fixed point, with no per pixel float
+    //   math: map coordinates relative to the corner of the player's tile are
+    //   held in Q32.32, offset by ROW_BIAS_TILES tiles to stay positive, and
+    //   texel coordinates are the top bits of their fractional part. Tile
+    //   light only changes between runs of columns over the same tile, so is
+    //   looked up once per run, leaving the run loops plain texel loads and
+    //   stores.
+    if (!euclidean && pow2_texs) {
+        constexpr uint8_t  FRAC_BITS { 32 };
+        constexpr uint64_t FRAC_ONE { uint64_t(1) << FRAC_BITS };
+        constexpr int64_t  ROW_BIAS_TILES { int64_t(1) << 20 };
+        const double fp_scale ( FRAC_ONE );
+        const double step_fp_x { double(row_dist) * 2 * plane.x / viewport.w *
+                                 column_step * fp_scale };
+        const double step_fp_y { double(row_dist) * 2 * plane.y / viewport.w *
+                                 column_step * fp_scale };
+        const int64_t map_step_x ( std::llround(step_fp_x) );
+        const int64_t map_step_y ( std::llround(step_fp_y) );
+        // (unsigned, so that negative steps wrap)
+        uint64_t map_x ( uint64_t(std::llround(
+            ((pos.x - std::floor(pos.x)) +
+             (double(row_dist) * (dir.x - plane.x)) + ROW_BIAS_TILES) *
+            fp_scale)) + (uint64_t(begin_x / column_step) * uint64_t(map_step_x)) );
+        uint64_t map_y ( uint64_t(std::llround(
+            ((pos.y - std::floor(pos.y)) +
+             (double(row_dist) * (dir.y - plane.y)) + ROW_BIAS_TILES) *
+            fp_scale)) + (uint64_t(begin_x / column_step) * uint64_t(map_step_y)) );
+        const auto log2 { [](uint16_t size) {
+            uint8_t size_log2 { 0 };
+            for (; size > 1; size >>= 1)
+                ++size_log2;
+            return size_log2; } };
+        const uint8_t  floor_w_log2 { log2(floor_level.w) };
+        const uint8_t  floor_u_shift ( FRAC_BITS - floor_w_log2 );
+        const uint8_t  floor_v_shift ( FRAC_BITS - log2(floor_level.h) );
+        const uint32_t floor_u_mask ( floor_level.w - 1 );
+        const uint32_t floor_v_mask ( floor_level.h - 1 );
+        const uint8_t  ceiling_w_log2 { log2(ceiling_level.w) };
+        const uint8_t  ceiling_u_shift ( FRAC_BITS - ceiling_w_log2 );
+        const uint8_t  ceiling_v_shift ( FRAC_BITS - log2(ceiling_level.h) );
+        const uint32_t ceiling_u_mask ( ceiling_level.w - 1 );
+        const uint32_t ceiling_v_mask ( ceiling_level.h - 1 );
+        const uint32_t* floor_texels { floor_level.texels.data() };
+        const uint32_t* ceiling_texels { ceiling_level.texels.data() };
+        // cast columns from view_x to run_end_x, advancing map_x and map_y;
+        //   lit and fogged are std::true_type or std::false_type
+        const auto castRun { [&](const auto lit, const auto fogged,
+                                 const uint16_t view_x, const uint16_t run_end_x,
+                                 const uint8_t* floor_lut,
+                                 const uint8_t* ceiling_lut) {
+            uint64_t x { map_x };
+            uint64_t y { map_y };
+            for (uint16_t run_x { view_x }; run_x < run_end_x;
+                 run_x += column_step, x += map_step_x, y += map_step_y) {
+                uint32_t floor_texel { floor_texels[
+                    ((uint32_t(y >> floor_v_shift) & floor_v_mask) << floor_w_log2) |
+                    (uint32_t(x >> floor_u_shift) & floor_u_mask)] };
+                uint32_t ceiling_texel { ceiling_texels[
+                    ((uint32_t(y >> ceiling_v_shift) & ceiling_v_mask) << ceiling_w_log2) |
+                    (uint32_t(x >> ceiling_u_shift) & ceiling_u_mask)] };
+                if constexpr (decltype(lit)::value) {
+                    floor_texel = lightTexel(floor_texel, floor_lut);
+                    ceiling_texel = lightTexel(ceiling_texel, ceiling_lut);
+                } else {
+                    // ceiling halved like NS walls, to set it apart from the
+                    //   floor
+                    ceiling_texel = (ceiling_texel >> 1) & 0x7f7f7f;
+                }
+                if constexpr (decltype(fogged)::value) {
+                    floor_texel = fogTexel(floor_texel);
+                    ceiling_texel = fogTexel(ceiling_texel);
+                }
+                floor_rgb[run_x] = floor_texel;
+                ceiling_rgb[run_x] = ceiling_texel;
+            }
+            map_x = x;
+            map_y = y;
+        } };
+        // columns from a map coordinate to the last before it leaves its tile
+        const auto stepsInTile { [](const uint64_t coord, const int64_t step) {
+            const uint64_t frac { coord & (FRAC_ONE - 1) };
+            if (step > 0)
+                return (FRAC_ONE - 1 - frac) / uint64_t(step);
+            if (step < 0)
+                return frac / uint64_t(-step);
+            return uint64_t(UINT16_MAX);
+        } };
+        const auto castRuns { [&](const auto fogged) {
+            if (layout.lights.empty()) {
+                castRun(std::false_type {}, fogged, begin_x, end_x,
+                        nullptr, nullptr);
+                return;
+            }
+            for (uint16_t view_x { begin_x }; view_x < end_x; ) {
+                const uint64_t run_ct { 1 + std::min(
+                    stepsInTile(map_x, map_step_x), stepsInTile(map_y, map_step_y)) };
+                const uint16_t run_end_x ( std::min(
+                    uint64_t(end_x), view_x + (run_ct * column_step)) );
+                const uint8_t light { layout.tileLight(
+                    uint32_t(std::clamp<int64_t>(
+                        tile_x + int64_t(map_x >> FRAC_BITS) - ROW_BIAS_TILES,
+                        0, max_tile_x)),
+                    uint32_t(std::clamp<int64_t>(
+                        tile_y + int64_t(map_y >> FRAC_BITS) - ROW_BIAS_TILES,
+                        0, max_tile_y))) };
+                castRun(std::true_type {}, fogged, view_x, run_end_x,
+                        lightLut(light), lightLut(light / 2));
+                view_x = run_end_x;
+            }
+        } };
+        if (fog_weight > 0)
+            castRuns(std::true_type {});
+        else
+            castRuns(std::false_type {});
+        return;
+    }
+
+    // Otherwise each column's map point is found on its own (with euclidean
+    //   distances, points are not evenly spaced across the row).
+    //
+    // wrap(t, size) gives the texel index of texture coordinate t (in
+    //   texels) on a texture tiled every size texels; lit is std::true_type
+    //   to light texels by tile, otherwise std::false_type
+    const auto castRow { [&](const auto wrap, const auto lit) {
+        // no loop-carried state, so that columns can be computed in parallel
+        //   SIMD lanes up to the texel gathers
+        for (uint16_t view_x { begin_x }; view_x < end_x; view_x += column_step) {
+            // offset of map point from pos
+            float off_x { left_x + (view_x * step_x) };
+            float off_y { left_y + (view_x * step_y) };
+            if (euclidean) {
+                // walls are as tall as their euclidean distance, so rows are
+                //   too: scale by 1 / |dir + plane * camera_x| (dir is a unit
+                //   vector orthogonal to plane)
+                const float camera_x { (view_x * camera_x_step) - 1 };
+                const float dist_scale { 1 / std::sqrt(
+                    1 + (camera_x * camera_x * plane_mag_sq_f)) };
+                off_x *= dist_scale;
+                off_y *= dist_scale;
+            }
+            const float rel_x { pos_x + off_x };
+            const float rel_y { pos_y + off_y };
+            const uint32_t floor_texel { floor_level.texels[
+                (wrap(rel_y * floor_level.h, floor_level.h) * floor_level.w) +
+                wrap(rel_x * floor_level.w, floor_level.w)] };
+            const uint32_t ceiling_texel { ceiling_level.texels[
+                (wrap(rel_y * ceiling_level.h, ceiling_level.h) *
+                 ceiling_level.w) +
+                wrap(rel_x * ceiling_level.w, ceiling_level.w)] };
+            if constexpr (decltype(lit)::value) {
+                const uint8_t light { layout.tileLight(
+                    uint32_t(std::clamp<int64_t>(tile_x + floorToInt(rel_x),
+                                                 0, max_tile_x)),
+                    uint32_t(std::clamp<int64_t>(tile_y + floorToInt(rel_y),
+                                                 0, max_tile_y))) };
+                floor_rgb[view_x] = fogTexel(
+                    lightTexel(floor_texel, lightLut(light)));
+                ceiling_rgb[view_x] = fogTexel(
+                    lightTexel(ceiling_texel, lightLut(light / 2)));
+            } else {
+                floor_rgb[view_x] = fogTexel(floor_texel);
+                // ceiling halved like NS walls, to set it apart from the floor
+                ceiling_rgb[view_x] = fogTexel((ceiling_texel >> 1) & 0x7f7f7f);
+            }
+        }
+    } };
+    // lit rows only on maps with lights, so that others pay nothing for
+    //   lighting
+    const auto castRowLit { [&](const auto wrap) {
+        if (layout.lights.empty())
+            castRow(wrap, std::false_type {});
+        else
+            castRow(wrap, std::true_type {});
+    } };
+    // power of 2 textures wrap by mask rather than modulo
+    if (pow2_texs) {
+        castRowLit([](const float t, const uint16_t size) {
+            return floorToInt(t) & (size - 1); });
+    } else {
+        castRowLit([](const float t, const uint16_t size) {
+            return ((floorToInt(t) % size) + size) % size; });
+    }
+}
+
+void WindowMgr::buildLightLuts() {
+    for (uint16_t level { 0 }; level < Layout::LIGHT_LEVEL_CT; ++level) {
+        for (uint16_t channel { 0 }; channel < 256; ++channel) {
+            light_luts[level][channel] = uint8_t(std::min(
+                (channel * level) / Layout::LIGHT_LEVEL_ONE, 255));
+        }
+    }
+}
+
+void WindowMgr::buildSpriteTexs() {
+    sprite_texs.clear();
+    // figure of a round head over an elliptical body, lit from the upper left
+    constexpr float head_x { SPRITE_TEX_SZ * 0.5f };
+    constexpr float head_y { SPRITE_TEX_SZ * 0.2f };
+    constexpr float head_r { SPRITE_TEX_SZ * 0.16f };
+    constexpr float body_x { SPRITE_TEX_SZ * 0.5f };
+    constexpr float body_y { SPRITE_TEX_SZ * 0.66f };
+    constexpr float body_rx { SPRITE_TEX_SZ * 0.28f };
+    constexpr float body_ry { SPRITE_TEX_SZ * 0.34f };
+    for (const uint32_t rgb : sprite_rgbs) {
+        WallTexLevel tex { SPRITE_TEX_SZ, SPRITE_TEX_SZ, {} };
+        tex.texels.resize(SPRITE_TEX_SZ * SPRITE_TEX_SZ, 0);
+        for (uint16_t y { 0 }; y < SPRITE_TEX_SZ; ++y) {
+            for (uint16_t x { 0 }; x < SPRITE_TEX_SZ; ++x) {
+                // texel centers
+                const float u { x + 0.5f };
+                const float v { y + 0.5f };
+                const float head_dist_sq {
+                    ((u - head_x) * (u - head_x)) + ((v - head_y) * (v - head_y)) };
+                const float body_dist_sq {
+                    (((u - body_x) / body_rx) * ((u - body_x) / body_rx)) +
+                    (((v - body_y) / body_ry) * ((v - body_y) / body_ry)) };
+                if (!(head_dist_sq < head_r * head_r) && !(body_dist_sq < 1))
+                    continue;
+                // from 1 at top left to 0.5 at bottom right
+                const float light { 1 - ((u + v) / (4 * SPRITE_TEX_SZ)) };
+                uint32_t texel { 0xff000000 };
+                for (const uint8_t shift : { 16, 8, 0 }) {
+                    texel |= uint32_t(((rgb >> shift) & 0xff) * light) << shift;
+                }
+                tex.texels[(y * SPRITE_TEX_SZ) + x] = texel;
+            }
+        }
+        sprite_texs.push_back(std::move(tex));
+    }
+}
+
+void WindowMgr::projectSprites(const CameraView& view,
+                               const SpriteGrid& sprites,
+                               const Settings& settings,
+                               std::vector<ViewSprite>& view_sprites) const {
+    view_sprites.clear();
+    if (sprites.size() == 0)
+        return;
+    const DdaRaycastEngine& camera { *view.camera };
+    const Viewport& viewport { view.viewport };
+    const Vector2d& pos { camera.player_pos };
+    const Vector2d& dir { camera.player_dir };
+    const Vector2d& plane { camera.view_plane };
+    const double plane_mag_sq { (plane.x * plane.x) + (plane.y * plane.y) };
+    const double plane_mag { std::sqrt(plane_mag_sq) };
+    // FOV ends at the draw distance, or otherwise the far side of the grid
+    const double max_dist { (settings.draw_dist > 0) ? settings.draw_dist :
+        std::hypot(sprites.cellsWidth(), sprites.cellsHeight()) *
+        SpriteGrid::CELL_SZ };
+    // a point is in the FOV when its depth along dir is from
+    //   SPRITE_NEAR_DIST to max_dist, and its lateral offset along plane (in
+    //   view plane lengths) is within its depth either side
+    const auto depth { [&](const double x, const double y) {
+        return ((x - pos.x) * dir.x) + ((y - pos.y) * dir.y); } };
+    const auto lateral { [&](const double x, const double y) {
+        return (((x - pos.x) * plane.x) + ((y - pos.y) * plane.y)) /
+            plane_mag_sq; } };
+
+    // FOV is the triangle of pos and the ends of the view plane at max_dist,
+    //   so only cells overlapping its bounding box are visited, and only cells
+    //   with a corner in the FOV are searched (padded by the largest sprite
+    //   half width, as sprites can overlap the FOV from outside)
+    constexpr double pad { SpriteGrid::MAX_SPRITE_SCALE / 2 };
+    const double far_left_x { pos.x + ((dir.x - plane.x) * max_dist) };
+    const double far_left_y { pos.y + ((dir.y - plane.y) * max_dist) };
+    const double far_right_x { pos.x + ((dir.x + plane.x) * max_dist) };
+    const double far_right_y { pos.y + ((dir.y + plane.y) * max_dist) };
+    const double min_x { std::min({ pos.x, far_left_x, far_right_x }) - pad };
+    const double min_y { std::min({ pos.y, far_left_y, far_right_y }) - pad };
+    const double max_x { std::max({ pos.x, far_left_x, far_right_x }) + pad };
+    const double max_y { std::max({ pos.y, far_left_y, far_right_y }) + pad };
+    constexpr uint16_t cell_sz { SpriteGrid::CELL_SZ };
+    const uint32_t begin_cell_x ( std::max(min_x / cell_sz, 0.0) );
+    const uint32_t begin_cell_y ( std::max(min_y / cell_sz, 0.0) );
+    const uint32_t end_cell_x ( std::min(std::max(max_x / cell_sz + 1, 0.0),
+                                         double(sprites.cellsWidth())) );
+    const uint32_t end_cell_y ( std::min(std::max(max_y / cell_sz + 1, 0.0),
+                                         double(sprites.cellsHeight())) );
+
+    const auto project { [&](const Sprite& sprite) {
+        const double sprite_depth { depth(sprite.x, sprite.y) };
+        if (!(sprite_depth >= SPRITE_NEAR_DIST && sprite_depth <= max_dist))
+            return;
+        // same projection as DdaRaycastEngine::pointColumn, and same scale as
+        //   walls in renderPixelColumn (a wall unit is viewport.h / dist tall)
+        const double center_x { (lateral(sprite.x, sprite.y) / sprite_depth + 1) *
+                                viewport.w / 2 };
+        const double w { sprite.scale * viewport.w /
+                         (2 * plane_mag * sprite_depth) };
+        const double left_x { center_x - (w / 2) };
+        const double begin_x { std::max(std::ceil(left_x - 0.5), 0.0) };
+        const double end_x { std::min(std::ceil(left_x + w - 0.5),
+                                      double(viewport.w)) };
+        if (!(begin_x < end_x))
+            return;
+        const double floor_y { (viewport.h / 2) + (viewport.h / sprite_depth / 2) };
+        const double h { sprite.scale * viewport.h / sprite_depth };
+        // walls are compared by euclidean distance in euclidean mode
+        const double dist { settings.euclidean ?
+            std::hypot(sprite.x - pos.x, sprite.y - pos.y) : sprite_depth };
+        view_sprites.push_back(ViewSprite {
+                float(dist), float(left_x), float(SPRITE_TEX_SZ / w),
+                int16_t(floor_y - h), uint16_t(h),
+                uint16_t(begin_x), uint16_t(end_x),
+                fogWeight(dist, settings),
+                lightLut(camera.layout.tileLight(uint32_t(sprite.x),
+                                                uint32_t(sprite.y))),
+                sprite_texs.at(sprite.tex_key).texels.data() });
+    } };
+    for (uint32_t cell_y { begin_cell_y }; cell_y < end_cell_y; ++cell_y) {
+        for (uint32_t cell_x { begin_cell_x }; cell_x < end_cell_x; ++cell_x) {
+            // cell is outside FOV if all of its corners are outside the same
+            //   edge
+            uint8_t behind_ct { 0 }, beyond_ct { 0 }, left_ct { 0 }, right_ct { 0 };
+            for (const double corner_y : { cell_y * cell_sz - pad,
+                                           (cell_y + 1) * cell_sz + pad }) {
+                for (const double corner_x : { cell_x * cell_sz - pad,
+                                               (cell_x + 1) * cell_sz + pad }) {
+                    const double corner_depth { depth(corner_x, corner_y) };
+                    const double corner_lateral { lateral(corner_x, corner_y) };
+                    behind_ct += (corner_depth < SPRITE_NEAR_DIST);
+                    beyond_ct += (corner_depth > max_dist);
+                    left_ct += (corner_lateral < -corner_depth);
+                    right_ct += (corner_lateral > corner_depth);
+                }
+            }
+            if (behind_ct == 4 || beyond_ct == 4 || left_ct == 4 || right_ct == 4)
+                continue;
+            sprites.forEachInCells(cell_x, cell_y, cell_x + 1, cell_y + 1,
+                                   project);
+        }
+    }
+    // drawn far to near, so that nearer sprites are drawn over farther
+    std::sort(view_sprites.begin(), view_sprites.end(),
+              [](const ViewSprite& a, const ViewSprite& b) {
+                  return a.dist > b.dist; });
+}
+
+WindowMgr::WallTexColumn WindowMgr::wallTexColumn(
+    const uint16_t screen_x, const FovRayBuffer& fov_rays,
+    const uint16_t line_h, const Settings& settings) const {
+    // TBD: add protection for out of range tex key? or in map parsing?
+    const std::vector<WallTexLevel>& levels {
+        wall_tex_levels.at(fov_rays.tex_key[screen_x]) };
+    uint8_t level_i { 0 };
+    if (settings.texture_lod) {
+        while (level_i + 1u < levels.size() &&
+               levels[level_i + 1].h >= line_h) {
+            ++level_i;
+        }
+    }
+    const WallTexLevel& level { levels[level_i] };
+    // find proportionate x coordinate in wall texture
+    uint16_t tex_x ( fov_rays.hit_x[screen_x] * level.w );
+    // ensure texture x of 0 is always to the left when facing the wall segment
+    const WallOrientation algnmt { fov_rays.algnmt[screen_x] };
+    if ((algnmt == WallOrientation::NS && fov_rays.dir_x[screen_x] > 0) ||
+        (algnmt == WallOrientation::EW && fov_rays.dir_y[screen_x] < 0) ) {
+        tex_x = level.w - tex_x - 1;
+    }
+    return WallTexColumn { level.texels.data() + tex_x, level.w, level.h };
+}
+
+uint16_t WindowMgr::fogWeight(const float dist, const Settings& settings) {
+    if (settings.draw_dist <= 0)
+        return 0;
+    const float fog_start_dist ( settings.draw_dist * FOG_START_RATIO );
+    if (dist <= fog_start_dist)
+        return 0;
+    const float fog_ratio ( (dist - fog_start_dist) /
+                            (settings.draw_dist - fog_start_dist) );
+    return uint16_t(std::min(fog_ratio, 1.0f) * FOG_WEIGHT_MAX);
+}
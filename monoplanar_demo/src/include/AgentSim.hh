@@ -0,0 +1,166 @@
+#ifndef AGENTSIM_HH
+#define AGENTSIM_HH
+
+#include "Layout.hh"
+#include "ThreadPool.hh"
+
+#include <cstdint>
+
+#include <vector>
+#include <memory>    // shared_ptr
+
+
+// Crowd of agents wandering the map, each a circle colliding with wall tiles
+//   and steering away from other agents. State is stored as a structure of
+//   arrays indexed by agent, so that updates stream through only the fields
+//   they use.
+//
+// Each update first buckets agents by map tile into a spatial hash, then moves
+//   every agent in parallel strips: new state is written to separate arrays
+//   and swapped in once all strips are done, so that every agent steers from
+//   the same snapshot of its neighbors, whatever order strips run in.
+class AgentSim {
+private:
+    // agent collision radius in map units; at most half a tile, so that an
+    //   agent overlaps at most 2x2 tiles
+    static constexpr float  RADIUS { 0.2f };
+    // agents closer than this (center to center) steer apart; at most one
+    //   tile, so that all such neighbors are in the 3x3 tiles around an agent
+    static constexpr float  AVOID_DIST { 2.5f * RADIUS };
+    // weight of steering away from neighbors against following heading
+    static constexpr float  AVOID_WEIGHT { 2.0f };
+    // map units per second
+    static constexpr float  SPEED { 1.5f };
+    // largest random heading change, radians per second
+    static constexpr float  WANDER_RATE { 2.0f };
+    // longest update step in seconds
+    static constexpr double MAX_DT { 0.1 };
+    // agents per ThreadPool strip
+    static constexpr uint32_t STRIP_SZ { 256 };
+
+    std::shared_ptr<Layout> shared_layout;
+    const Layout&           layout;
+
+    // next state, written by strips during update (positions rotate through
+    //   next_pos_*, pos_* and prev_pos_*, so none are copied)
+    std::vector<float>      next_pos_x;
+    std::vector<float>      next_pos_y;
+    std::vector<float>      next_heading;
+    // per agent xorshift state, so wandering is independent of strip order
+    std::vector<uint32_t>   rng_state;
+
+    // Spatial hash: map tiles hashed into hash_bucket_ct buckets (a power of
+    //   2, at least twice the agent count), with the agents in bucket b listed
+    //   in bucket_agent_is from bucket_offsets[b] to bucket_offsets[b + 1].
+    //   Rebuilt by counting sort every update, so costs O(agents) whatever
+    //   the map size. Each agent's position and tile (tiles sharing a bucket
+    //   are told apart by tile) are copied alongside its index, so that
+    //   neighbor searches read each bucket contiguously rather than gathering
+    //   from pos_* by index. Tiles hash by row major index, so that tiles
+    //   neighboring in a row have neighboring buckets, and agents are updated
+    //   in bucket order, so that nearby agents search the same buckets while
+    //   they are still cached.
+    uint32_t                hash_bucket_ct { 0 };
+    std::vector<uint32_t>   bucket_offsets;
+    std::vector<uint32_t>   bucket_agent_is;
+    std::vector<float>      bucket_pos_x;
+    std::vector<float>      bucket_pos_y;
+    std::vector<uint64_t>   bucket_tile_keys;
+    // per agent: bucket and tile key (x << 32 | y) of current tile
+    std::vector<uint32_t>   agent_bucket;
+    std::vector<uint64_t>   agent_tile_keys;
+
+    static uint64_t tileKey(const uint32_t tile_x, const uint32_t tile_y) {
+        return (uint64_t(tile_x) << 32) | tile_y;
+    }
+
+    /**
+     * @brief spatial hash bucket of a map tile
+     *
+     * @param tile_x - map tile x
+     * @param tile_y - map tile y
+     */
+    uint32_t tileBucket(const uint32_t tile_x, const uint32_t tile_y) const {
+        return layout.tileIndex(tile_x, tile_y) & (hash_bucket_ct - 1);
+    }
+    /**
+     * @brief bucket all agents by their current map tile
+     */
+    void buildSpatialHash();
+    /**
+     * @brief sum of pushes away from agents within AVOID_DIST, each scaled by
+     *   how far inside AVOID_DIST the neighbor is
+     *
+     * @param i      - agent index
+     * @param push_x - set to x of push
+     * @param push_y - set to y of push
+     */
+    void avoidNeighbors(const uint32_t i, float& push_x, float& push_y) const;
+    /**
+     * @brief move circle out of any wall tiles it overlaps
+     *
+     * @param x        - circle center x, updated
+     * @param y        - circle center y, updated
+     * @param normal_x - set to x of summed push directions (0 if not pushed)
+     * @param normal_y - set to y of summed push directions (0 if not pushed)
+     *
+     * @return false if the center is inside a wall tile, so cannot be pushed
+     */
+    bool resolveWallOverlap(float& x, float& y,
+                            float& normal_x, float& normal_y) const;
+    /**
+     * @brief steer, move and collide one agent, writing its next state
+     *
+     * @param i  - agent index
+     * @param dt - seconds since last update
+     */
+    void updateAgent(const uint32_t i, const float dt);
+
+public:
+    // current state (read only outside of update)
+    //
+    // agent center in map coordinates
+    std::vector<float>      pos_x;
+    std::vector<float>      pos_y;
+    // direction of travel, radians ccw from +x
+    std::vector<float>      heading;
+    // agent center before the last update (same as pos_* after spawn), to
+    //   draw agents between updates
+    std::vector<float>      prev_pos_x;
+    std::vector<float>      prev_pos_y;
+
+    // real time taken by last update, in seconds
+    double                  update_duration { 0 };
+
+    /**
+     * @param _shared_layout - layout to wander, eg from
+     *                           DdaRaycastEngine::sharedLayout()
+     */
+    explicit AgentSim(std::shared_ptr<Layout> _shared_layout);
+
+    AgentSim(const AgentSim&) = delete;
+    AgentSim& operator=(const AgentSim&) = delete;
+
+    uint32_t size() const { return pos_x.size(); }
+
+    static constexpr float radius() { return RADIUS; }
+
+    /**
+     * @brief replace all agents with new ones at random points in empty tiles,
+     *   facing random directions (layout must be loaded)
+     *
+     * @param agent_ct - agents to place
+     * @param seed     - random seed, so that runs can be repeated
+     */
+    void spawn(const uint32_t agent_ct, const uint32_t seed = 1);
+    /**
+     * @brief advance all agents
+     *
+     * @param dt          - seconds since last update
+     * @param thread_pool - workers to update strips of agents on
+     */
+    void update(const double dt, ThreadPool& thread_pool);
+};
+
+
+#endif  // AGENTSIM_HH
@@ -5,15 +5,20 @@
 #include "Settings.hh"           // TtyDisplayMode
 #include "KbdInputMgr.hh"
 #include "DdaRaycastEngine.hh"
+#include "Vector2d.hh"
+#include "AgentSim.hh"
+#include "SpriteGrid.hh"
 #include "WindowMgr.hh"
 #include "TtyWindowMgr.hh"
 #include "SdlWindowMgr.hh"
+#include "ThreadPool.hh"
 
 #include <csignal>               // sig_atomic_t
 #include <cstdint>               // uint16_t
 
 #include <string>
 #include <memory>                // unique_ptr
+#include <vector>
 
 
 // global to be visible to sigaction
@@ -24,7 +29,7 @@ class App {
 public:
     App() = delete;
     App(const char* efn, const std::string& mfn, const bool _tty_io,
-        TtyDisplayMode tty_display_mode);
+        const Settings& _settings);
     ~App();
 
     /**
@@ -50,6 +55,41 @@ private:
     //
     Settings                     settings;
 
+    // dynamic column scaling
+    //
+    // largest Settings::column_scale
+    static constexpr uint8_t     MAX_COLUMN_SCALE { 4 };
+    // frames to wait after changing column_scale before changing it again,
+    //   so that rt_fps_calc's moving average has caught up with the change
+    static constexpr uint16_t    COLUMN_SCALE_SETTLE_FRAME_CT { 40 };
+    // halving column_scale can up to double per column work, so it is only
+    //   lowered once frames take less than this fraction of the target
+    static constexpr double      COLUMN_SCALE_HEADROOM_RATIO { 0.45 };
+    uint16_t                     column_scale_settle_ct { 0 };
+
+    // fixed timestep simulation
+    //
+    // frames longer than this many ticks drop the rest of their time, so
+    //   that stalls slow the game down rather than being caught up in bursts
+    static constexpr uint8_t     MAX_SIM_TICKS_PER_FRAME { 10 };
+    // real time not yet simulated, in seconds (less than one tick after
+    //   stepSimulation)
+    double                       sim_time_accum { 0 };
+    // player state simulated by each tick, apart from raycast_engine's
+    //   camera, which is placed between the last two ticks for rendering
+    struct PlayerState {
+        Vector2d pos;
+        Vector2d dir;
+    };
+    PlayerState                  prev_tick_player;
+    PlayerState                  tick_player;
+
+    // multithreading
+    //
+    // persistent workers for casting and rendering column strips (after
+    //   settings, as sized by settings.thread_ct)
+    ThreadPool                   thread_pool;
+
     // user input
     //
     // polymorphic pointer to LinuxKbdInputMgr and SdlKbdInputMgr
@@ -58,6 +98,31 @@ private:
     // raycasting
     //
     DdaRaycastEngine             raycast_engine;
+    // faces opposite the player, sharing raycast_engine's layout; only
+    //   rendered when settings.camera_layout is not Single
+    DdaRaycastEngine             rear_camera { raycast_engine.sharedLayout() };
+    // window width and height : rear inset width and height
+    static constexpr uint16_t    REAR_INSET_DIVISOR { 3 };
+    // cameras and their window areas, in drawing order
+    std::vector<CameraView>      camera_views;
+
+    // simulation
+    //
+    // agents wandering raycast_engine's layout, spawned once it is loaded
+    AgentSim                     agent_sim { raycast_engine.sharedLayout() };
+    // sprite width and height of agents, in map units
+    static constexpr float       AGENT_SPRITE_SCALE { 0.6f };
+    // sprites drawn in views and on the minimap, rebuilt every frame from
+    //   agent_sim (see updateSprites)
+    SpriteGrid                   sprite_grid;
+    // walls opened by toggleWallAhead, with their texture keys, so that
+    //   they can be closed again as they were
+    struct OpenedWall {
+        uint32_t x;
+        uint32_t y;
+        uint8_t  tex_key;
+    };
+    std::vector<OpenedWall>      opened_walls;
 
     // video output
     //
@@ -68,11 +133,48 @@ private:
      * @brief Setup of main game loop
      */
     void initialize();
+    /**
+     * @brief Lay out camera_views in the window for settings.camera_layout,
+     *   and fit each camera to its viewport
+     */
+    void fitCamerasToWindow();
     /**
      * @brief Collect user input and other changing conditions relevant to game
      *   operation
      */
     void getEvents();
+    /**
+     * @brief Run as many fixed length simulation ticks of player input and
+     *   movement, and of agents, as fit in the real time elapsed, then place
+     *   raycast_engine's camera and agent sprites between the last two ticks,
+     *   by the fraction of a tick left over
+     */
+    void stepSimulation();
+    /**
+     * @brief Place raycast_engine's camera at a player state, unless it is
+     *   there already
+     *
+     * @param player - player position and direction
+     */
+    void placeCamera(const PlayerState& player);
+    /**
+     * @brief Raise or lower settings.column_scale to keep real time frame
+     *   duration within settings.target_fps
+     */
+    void updateColumnScale();
+    /**
+     * @brief Refill sprite_grid with a sprite per agent of agent_sim, placed
+     *   between its positions at the last two ticks
+     *
+     * @param t - fraction of a tick since the last tick
+     */
+    void updateSprites(const double t);
+    /**
+     * @brief Queue opening the wall tile one unit in front of the player
+     *   (a door or destructible wall), or closing it again if opened before
+     *   and no one stands in it; applied at the start of the next frame
+     */
+    void toggleWallAhead();
     /**
      * @brief Select update function based on display mode
      *
@@ -88,15 +190,34 @@ private:
      */
     void updateFromInput();
     /**
-     * @brief Update player position, direction, and game settings from Linux
-     *   input devices
+     * @brief Update game settings from Linux input devices, once per frame
      */
     void updateFromLinuxInput();
     /**
-     * @brief Update player position, direction, and game settings from SDL
-     *   device input
+     * @brief Update game settings from SDL device input, once per frame
      */
     void updateFromSdlInput();
+    /**
+     * @brief Select player update function based on display mode (see
+     *   updateFromInput)
+     *
+     * @param tick_duration - simulation tick length in seconds
+     */
+    void updatePlayerFromInput(const double tick_duration);
+    /**
+     * @brief Move and turn raycast_engine's player by one simulation tick of
+     *   Linux input device state
+     *
+     * @param tick_duration - simulation tick length in seconds
+     */
+    void updatePlayerFromLinuxInput(const double tick_duration);
+    /**
+     * @brief Move and turn raycast_engine's player by one simulation tick of
+     *   SDL device input state
+     *
+     * @param tick_duration - simulation tick length in seconds
+     */
+    void updatePlayerFromSdlInput(const double tick_duration);
 };
 
 
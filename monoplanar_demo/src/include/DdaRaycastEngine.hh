@@ -4,14 +4,23 @@
 #include "Vector2d.hh"
 #include "Layout.hh"
 #include "Settings.hh"
+#include "FixedPoint.hh"
+#include "ThreadPool.hh"
 
 #include <cstdint>
+#include <cmath>     // floor
 
 #include <vector>
+#include <limits>
+#include <atomic>
+#include <memory>    // shared_ptr make_shared
+#include <utility>   // move
 
 
-enum class WallOrientation { NS, EW };
+// single byte underlying type for compact storage in FovRayBuffer
+enum class WallOrientation : uint8_t { NS, EW };
 
+// result of casting a single ray
 struct FovRay {
     // ray direction
     Vector2d dir;
@@ -26,9 +35,183 @@ struct FovRay {
         //   perspective, x in the wall unit face where ray hit (expressed as
         //   fraction of wall unit, with 0.0 to player's left when facing wall)
         double          x;
+        // layout.tileLight of the last empty tile the ray crossed before the
+        //   wall, which lights the face it hit
+        uint8_t         light;
     }        wall_hit;
 };
 
+// Results of casting all rays in the FOV, stored as a structure of arrays
+//   indexed by window column, rather than as a std::vector<FovRay>: renderers
+//   only read a few fields of each ray, so keeping each field contiguous (and
+//   narrowed to the smallest type that keeps enough precision to place a
+//   pixel) cuts memory traffic between casting and rendering, and allows
+//   vectorized reads and writes of whole runs of columns.
+struct FovRayBuffer {
+    // FovRay::WallHit::dist
+    std::vector<float>           dist;
+    // FovRay::WallHit::tex_key, or NO_HIT_TEX_KEY
+    std::vector<uint8_t>         tex_key;
+    // FovRay::WallHit::x, texture u coordinate of hit
+    std::vector<float>           hit_x;
+    // FovRay::WallHit::algnmt
+    std::vector<WallOrientation> algnmt;
+    // FovRay::WallHit::light
+    std::vector<uint8_t>         light;
+    // FovRay::dir
+    std::vector<float>           dir_x;
+    std::vector<float>           dir_y;
+
+    // largest float below 1.0
+    static constexpr float MAX_HIT_X { 0x1.fffffep-1f };
+    // key of empty map tiles, so never hit; marks rays that reached
+    //   Settings::draw_dist first, with dist set to draw_dist
+    static constexpr uint8_t NO_HIT_TEX_KEY { 0 };
+
+    // narrowing may round hit x values just under 1.0 up to 1.0f, which would
+    //   then index one past the edge of the wall texture
+    static float narrowHitX(const double x) {
+        return (x < MAX_HIT_X) ? float(x) : MAX_HIT_X;
+    }
+
+    uint16_t size() const { return dist.size(); }
+
+    void resize(const uint16_t sz) {
+        dist.resize(sz);
+        tex_key.resize(sz);
+        hit_x.resize(sz);
+        algnmt.resize(sz);
+        light.resize(sz);
+        dir_x.resize(sz);
+        dir_y.resize(sz);
+    }
+
+    // scatter single ray result into arrays
+    void store(const uint16_t i, const FovRay& ray) {
+        dist[i]    = ray.wall_hit.dist;
+        tex_key[i] = ray.wall_hit.tex_key;
+        hit_x[i]   = narrowHitX(ray.wall_hit.x);
+        algnmt[i]  = ray.wall_hit.algnmt;
+        light[i]   = ray.wall_hit.light;
+        dir_x[i]   = ray.dir.x;
+        dir_y[i]   = ray.dir.y;
+    }
+};
+
+// Rays cast by DdaRaycastEngine::castRayQueries from any origins in any
+//   directions, independent of the camera and window (eg for simulated range
+//   sensors, or line of sight between pairs of points). Stored as a structure
+//   of arrays like FovRayBuffer, so that packets of queries are read and
+//   written contiguously.
+struct RayQueryBuffer {
+    // query origin in map coordinates (must be inside the map)
+    std::vector<double>   origin_x;
+    std::vector<double>   origin_y;
+    // query direction (unit vector)
+    std::vector<double>   dir_x;
+    std::vector<double>   dir_y;
+    // distance along the ray beyond which walls are not hit (may be infinite)
+    std::vector<double>   max_dist;
+
+    // distance along the ray to the first wall tile entered, max_dist for
+    //   rays entering none within it, or 0 for origins inside a wall
+    std::vector<float>    dist;
+    // wall tile hit (or last tile reached by rays with no hit)
+    std::vector<uint32_t> map_x;
+    std::vector<uint32_t> map_y;
+    // layout.tile(map_x, map_y), or NO_HIT_TEX_KEY for rays with no hit
+    std::vector<uint8_t>  tex_key;
+    // side of the wall tile the ray entered through (N or S for origins
+    //   inside a wall)
+    std::vector<TileSide> side;
+
+    // key of empty map tiles, so never hit
+    static constexpr uint8_t NO_HIT_TEX_KEY { FovRayBuffer::NO_HIT_TEX_KEY };
+
+    uint32_t size() const { return origin_x.size(); }
+
+    void resize(const uint32_t sz) {
+        origin_x.resize(sz);
+        origin_y.resize(sz);
+        dir_x.resize(sz);
+        dir_y.resize(sz);
+        max_dist.resize(sz);
+        dist.resize(sz);
+        map_x.resize(sz);
+        map_y.resize(sz);
+        tex_key.resize(sz);
+        side.resize(sz);
+    }
+
+    /**
+     * @brief set query to a ray
+     *
+     * @param i         - query index
+     * @param origin    - ray origin in map coordinates
+     * @param dir       - ray direction (any nonzero length)
+     * @param _max_dist - distance along ray beyond which walls are not hit
+     */
+    void setRay(const uint32_t i, const Vector2d& origin, const Vector2d& dir,
+                const double _max_dist = std::numeric_limits<double>::infinity());
+    /**
+     * @brief set query to the segment between two points, so that once cast,
+     *   hit(i) is false only if each can be seen from the other (points in or
+     *   on the edge of a wall tile cannot be)
+     *
+     * @param i - query index
+     * @param a - first point in map coordinates
+     * @param b - second point in map coordinates
+     */
+    void setSightLine(const uint32_t i, const Vector2d& a, const Vector2d& b);
+
+    // whether query i entered a wall tile within its max_dist
+    bool hit(const uint32_t i) const { return tex_key[i] != NO_HIT_TEX_KEY; }
+};
+
+// Per scalar type constants for casting rays in that type
+template <typename ScalarT>
+struct ScalarTraits {
+    // dist_per_unit_* is 1 / |ray.dir component|, and so is infinite for axis
+    //   aligned rays
+    static constexpr ScalarT MAX_DIST_PER_UNIT {
+        std::numeric_limits<ScalarT>::infinity() };
+};
+
+template <>
+struct ScalarTraits<Fixed16_16> {
+    // Fixed16_16 has no infinity, and saturated division leaves no headroom for
+    //   adding to dist_next_unit_*; any two of 16384 added together stay below
+    //   the fixed point maximum of 32768, so rays cast in Fixed16_16 are exact
+    //   only within 16384 map units of their origin
+    static constexpr Fixed16_16 MAX_DIST_PER_UNIT { int32_t(16384) };
+};
+
+// Error of casting rays in a given scalar type, relative to double, as measured
+//   by DdaRaycastEngine::scalarAccuracyReport; or of wall span casting,
+//   relative to casting every column, by wallSpanAccuracyReport
+struct ScalarAccuracyReport {
+    uint32_t ray_ct           { 0 };
+    // rays that hit a different wall (or wall face) than the reference
+    uint32_t wall_mismatch_ct { 0 };
+    // remaining fields only count rays that hit the same wall face
+    double   max_dist_err     { 0 };
+    double   mean_dist_err    { 0 };
+    double   max_rel_dist_err { 0 };
+    // texture u coordinate error
+    double   max_hit_x_err    { 0 };
+};
+
+// Columns whose rays were reused from the previous frame by the ray cache
+//   (hits), or cast (misses)
+struct RayCacheStats {
+    // since startup
+    uint64_t hit_ct        { 0 };
+    uint64_t miss_ct       { 0 };
+    // last frame only
+    uint32_t frame_hit_ct  { 0 };
+    uint32_t frame_miss_ct { 0 };
+};
+
 class DdaRaycastEngine {
 private:
     // used to set FOV from window aspect ratio to maintain square wall units
@@ -40,7 +223,478 @@ private:
     static constexpr double CHAR_PX_ASPECT_RATIO_TO_VIEW_PLANE_MAG_RATIO {
         ASPECT_RATIO_TO_VIEW_PLANE_MAG_RATIO * 2 };
 
+    // Rays cast together in packet mode: enough lanes to fill one 256-bit AVX2
+    //   register, or a pair of 128-bit SSE2/NEON registers, so 4 doubles or 8
+    //   floats or Fixed16_16s. Adjacent columns have nearly identical ray
+    //   directions, so lanes tend to cross the same map tiles and finish
+    //   within a few steps of each other.
+    template <typename ScalarT>
+    static constexpr uint16_t rayPacketSize() {
+        return 32 / sizeof(ScalarT);
+    }
+
+    /**
+     * @brief origin that ray math in ScalarT is made relative to: the corner
+     *   of the map tile containing the ray origin when rebasing, so that the
+     *   scalar positions stay within one tile of 0 on maps of any size
+     *
+     * @param pos      - ray origin in map coordinates
+     * @param settings - current game settings (rebase_origin used)
+     */
+    static Vector2d castOrigin(const Vector2d& pos, const Settings& settings) {
+        return settings.rebase_origin ?
+            Vector2d { std::floor(pos.x), std::floor(pos.y) } : Vector2d { 0, 0 };
+    }
+
+    /**
+     * @brief apply DDA algorithm to cast ray from player position to first wall
+     *   hit, with all ray math in ScalarT
+     *
+     * @param window_x - horizontal window pixel coordinate
+     * @param settings - current game settings
+     *
+     * @return DDA loop iterations
+     */
+    template <typename ScalarT>
+    uint32_t castRayAs(const uint16_t window_x, const Settings& settings);
+    /**
+     * @brief apply DDA algorithm to rayPacketSize<ScalarT>() rays at once,
+     *   every column_step columns, from player position to their first wall
+     *   hits
+     *
+     * @param first_window_x - horizontal window pixel coordinate of leftmost ray
+     * @param column_step    - columns between rays
+     * @param settings       - current game settings
+     *
+     * @return DDA loop iterations, summed across lanes still casting
+     */
+    template <typename ScalarT>
+    uint32_t castRayPacketAs(const uint16_t first_window_x,
+                             const uint16_t column_step,
+                             const Settings& settings);
+    /**
+     * @brief cast rays for every settings.column_scale columns of a range of
+     *   window columns in ScalarT
+     *
+     * @param begin_x  - first horizontal window pixel coordinate
+     * @param end_x    - one past last horizontal window pixel coordinate
+     * @param settings - current game settings
+     */
+    template <typename ScalarT>
+    void castRaysAs(const uint16_t begin_x, const uint16_t end_x,
+                    const Settings& settings);
+
+    /**
+     * @brief light of the wall face a ray hit on stepping into a wall tile:
+     *   that of the tile it stepped from
+     *
+     * @param map_x      - wall tile x
+     * @param map_y      - wall tile y
+     * @param ns         - whether the last step was in x (NS wall)
+     * @param map_step_x - -1 or +1
+     * @param map_step_y - -1 or +1
+     * @param stepped    - false if the ray started inside the wall tile
+     */
+    uint8_t hitLight(const int32_t map_x, const int32_t map_y, const bool ns,
+                     const int32_t map_step_x, const int32_t map_step_y,
+                     const bool stepped) const {
+        if (!stepped)
+            return layout.tileLight(map_x, map_y);
+        return ns ? layout.tileLight(map_x - map_step_x, map_y) :
+            layout.tileLight(map_x, map_y - map_step_y);
+    }
+
+    // light of tiles no light reaches, on maps with lights (1 is full texture
+    //   brightness)
+    static constexpr double AMBIENT_LIGHT { 0.35 };
+    /**
+     * @brief bakeLighting of only the tiles in region, from every light
+     *   reaching them
+     *
+     * @param region      - tiles to bake
+     * @param settings    - current game settings (as castRayQueries)
+     * @param thread_pool - workers to cast sight lines on
+     */
+    void bakeLighting(const TileRect& region, const Settings& settings,
+                      ThreadPool& thread_pool);
+
+    // queries per ThreadPool strip in castRayQueries
+    static constexpr uint32_t RAY_QUERY_STRIP_SZ { 1024 };
+
+    /**
+     * @brief apply DDA algorithm to cast a ray query from its origin to its
+     *   first wall hit, with all ray math in ScalarT
+     *
+     * @param rays     - ray queries, with hit fields of query i set
+     * @param i        - query index
+     * @param settings - current game settings (empty_space_skip used)
+     */
+    template <typename ScalarT>
+    void castRayQueryAs(RayQueryBuffer& rays, const uint32_t i,
+                        const Settings& settings) const;
+    /**
+     * @brief apply DDA algorithm to a range of ray queries
+     *   rayPacketSize<ScalarT>() at a time, each lane taking the next query
+     *   in the range as soon as its own is done
+     *
+     * @param rays     - ray queries, with hit fields of range set
+     * @param begin_i  - index of first query
+     * @param end_i    - one past index of last query
+     * @param settings - current game settings (empty_space_skip used)
+     */
+    template <typename ScalarT>
+    void castRayQueryPacketsAs(RayQueryBuffer& rays, const uint32_t begin_i,
+                               const uint32_t end_i,
+                               const Settings& settings) const;
+    /**
+     * @brief cast a range of ray queries in ScalarT, in packets if
+     *   settings.ray_packets is set
+     *
+     * @param rays     - ray queries
+     * @param begin_i  - index of first query
+     * @param end_i    - one past index of last query
+     * @param settings - current game settings
+     */
+    template <typename ScalarT>
+    void castRayQueriesAs(RayQueryBuffer& rays, const uint32_t begin_i,
+                          const uint32_t end_i, const Settings& settings) const;
+
+    // Per column camera tables: camera_x depends only on the window width,
+    //   and ray directions and their reciprocals only on player_dir and
+    //   view_plane, so frames where the player only moves (or stands still)
+    //   do no per column division.
+    std::vector<double>        column_camera_x;
+    std::vector<double>        column_dir_x;
+    std::vector<double>        column_dir_y;
+    // |1 / column_dir_*|, infinite for axis aligned rays
+    std::vector<double>        column_dist_per_unit_x;
+    std::vector<double>        column_dist_per_unit_y;
+    // camera state column tables were last updated from
+    Vector2d                   tables_player_dir;
+    Vector2d                   tables_view_plane;
+    bool                       tables_valid { false };
+
+    /**
+     * @brief recalculate per column ray directions and distances per grid
+     *   unit from current player_dir and view_plane
+     */
+    void updateColumnTables();
+
+    // Wall face of one map tile, in coordinates across and along the grid
+    //   line it lies on, so that any ray hitting the face can be found
+    //   analytically from the ray direction alone
+    //
+    // largest distance of a ray's hit from a face line to count as on it
+    static constexpr float FACE_LINE_MAX_ERR { 0.01f };
+    struct WallFace {
+        WallOrientation algnmt;
+        uint8_t         tex_key;
+        // grid line of face: x for NS walls, y for EW walls
+        double          line;
+        // coordinates of tile the face belongs to
+        double          tile_across;
+        double          tile_along;
+    };
+
+    /**
+     * @brief wall face hit by a ray already cast
+     *
+     * @param rays     - rays cast from pos
+     * @param window_x - horizontal window pixel coordinate of ray (must have
+     *                     hit a wall)
+     * @param pos      - player position rays were cast from
+     */
+    static WallFace rayWallFace(const FovRayBuffer& rays,
+                                const uint16_t window_x, const Vector2d& pos);
+    /**
+     * @brief whether a ray of the current frame hit the line of a wall face
+     *   (any tile on it with the same texture and orientation)
+     *
+     * @param window_x - horizontal window pixel coordinate of ray
+     * @param face     - wall face
+     */
+    bool rayOnFaceLine(const uint16_t window_x, const WallFace& face) const;
+    /**
+     * @brief intersect column's ray with a wall face (no occlusion test)
+     *
+     * @param window_x  - horizontal window pixel coordinate
+     * @param face      - wall face
+     * @param dist      - set to perpendicular distance of hit
+     * @param hit_along - set to coordinate of hit along face line
+     *
+     * @return true if the ray meets the face within its tile
+     */
+    bool faceHit(const uint16_t window_x, const WallFace& face,
+                 double& dist, double& hit_along) const;
+    /**
+     * @brief store a hit found by faceHit in fov_rays
+     *
+     * @param window_x  - horizontal window pixel coordinate
+     * @param face      - wall face
+     * @param dist      - perpendicular distance of hit
+     * @param hit_along - coordinate of hit along face line
+     */
+    void storeFaceHit(const uint16_t window_x, const WallFace& face,
+                      const double dist, const double hit_along);
+    /**
+     * @brief intersect column's ray with a wall face, and store the hit in
+     *   fov_rays if the ray meets the face within its tile (no occlusion test)
+     *
+     * @param window_x - horizontal window pixel coordinate
+     * @param face     - wall face
+     * @param settings - current game settings
+     *
+     * @return true if stored
+     */
+    bool storeFaceHit(const uint16_t window_x, const WallFace& face,
+                      const Settings& settings);
+
+    // Wall span casting (Settings::wall_spans): runs of adjacent columns
+    //   usually hit the same tile face, so after casting one column, the
+    //   columns the face projects to are found from its endpoints, and the
+    //   last of them cast. If that ray hits the same face, the face is
+    //   visible across the whole run, as any tile in front of it would
+    //   project wider than the face, and so cover an end; the columns
+    //   between are filled by intersecting their rays with the face. If not,
+    //   the visible end of the face is found by bisection.
+    //
+    /**
+     * @brief cast rays for a range of window columns by wall spans, in ScalarT
+     *
+     * @param begin_x  - first horizontal window pixel coordinate
+     * @param end_x    - one past last horizontal window pixel coordinate
+     * @param settings - current game settings
+     *
+     * @return DDA loop iterations
+     */
+    template <typename ScalarT>
+    uint64_t castWallSpansAs(const uint16_t begin_x, const uint16_t end_x,
+                             const Settings& settings);
+    /**
+     * @brief column (fractional) whose ray passes through a point on the map,
+     *   or NaN if the point is not in front of the camera
+     *
+     * @param point - map coordinates
+     */
+    double pointColumn(const Vector2d& point) const;
+    /**
+     * @brief over a full turn of the player in place, cast all rays with two
+     *   sets of settings and add the errors of the second to a report (see
+     *   scalarAccuracyReport)
+     *
+     * @param reference_settings - settings giving the reference rays
+     * @param test_settings      - settings whose rays are measured
+     * @param turn_ct            - evenly spaced player directions to cast from
+     * @param report             - ray_ct and errors updated (mean_dist_err
+     *                               left to the caller)
+     * @param dist_err_sum       - distance errors of matching rays added
+     */
+    void addRayErrors(const Settings& reference_settings,
+                      const Settings& test_settings, const uint16_t turn_ct,
+                      ScalarAccuracyReport& report, double& dist_err_sum);
+
+    // Potentially visible set casting (Settings::pvs): at the start of each
+    //   frame, the faces Layout found visible from the player's tile are
+    //   culled to those facing the player and projecting into the window,
+    //   and ordered by their nearest distance. Each column then intersects
+    //   its ray with the faces spanning it, stopping at the first face that
+    //   could be no nearer than a hit already found. Columns meeting no face
+    //   (or only beyond draw_dist) are cast.
+    struct PvsFace {
+        WallFace face;
+        // smallest perpendicular distance of any point on the face
+        double   near_dist;
+        // window columns face may project to
+        uint16_t begin_x;
+        uint16_t end_x;
+    };
+    // faces visible from the player's tile this frame, nearest first
+    std::vector<PvsFace>       pvs_faces;
+    // set by beginFrame when this frame's rays are found from pvs_faces
+    bool                       pvs_frame { false };
+    // per window column, scratch of castPvsFacesAs: nearest face hit so far,
+    //   its distance, and where along it the ray hits (each thread only
+    //   touches the columns of its own range)
+    std::vector<const WallFace*> pvs_nearest_face;
+    std::vector<double>        pvs_nearest_dist;
+    std::vector<double>        pvs_nearest_hit_along;
+
+    /**
+     * @brief fill pvs_faces from the player's tile's potentially visible set
+     *
+     * @param settings - current game settings
+     */
+    void cullPvsFaces(const Settings& settings);
+    /**
+     * @brief find rays for a range of window columns from pvs_faces, casting
+     *   in ScalarT those meeting none
+     *
+     * @param begin_x  - first horizontal window pixel coordinate
+     * @param end_x    - one past last horizontal window pixel coordinate
+     * @param settings - current game settings
+     *
+     * @return DDA loop iterations
+     */
+    template <typename ScalarT>
+    uint64_t castPvsFacesAs(const uint16_t begin_x, const uint16_t end_x,
+                            const Settings& settings);
+
+    // Segment maps (Layout::hasSegments): rays step through map tiles as in
+    //   castRayAs, intersecting the wall segments listed in each tile, and
+    //   stop once the nearest hit found lies within the tile being left.
+    //   Segments only need to be tested in the few tiles a ray crosses, so
+    //   per ray cost follows the distance to the wall hit rather than the
+    //   segment count. Cast in double one column at a time; the ray cache
+    //   only reuses whole frames with an unchanged camera, and wall spans and
+    //   potentially visible sets (both of tile faces) are not used.
+    //
+    // fraction of a segment's length its ends are extended by, so that rays
+    //   through a corner where two segments meet hit one of them
+    static constexpr double SEGMENT_END_MARGIN { 1e-9 };
+
+    /**
+     * @brief cast ray from player position to first wall segment hit
+     *
+     * @param window_x - horizontal window pixel coordinate
+     * @param settings - current game settings
+     *
+     * @return map tiles visited
+     */
+    uint32_t castSegmentRay(const uint16_t window_x, const Settings& settings);
+    /**
+     * @brief cast rays for every settings.column_scale columns of a range of
+     *   window columns against wall segments
+     *
+     * @param begin_x  - first horizontal window pixel coordinate
+     * @param end_x    - one past last horizontal window pixel coordinate
+     * @param settings - current game settings
+     */
+    void castSegmentRays(const uint16_t begin_x, const uint16_t end_x,
+                         const Settings& settings);
+
+    // frame coherent ray cache
+    //
+    // Camera state that fov_rays were cast from. If it is unchanged at the
+    //   start of a frame, no rays need to be cast. If only the direction has
+    //   changed, each ray of the new frame can reuse the previous frame's ray
+    //   that was cast in (nearly) the same direction from the same position,
+    //   as it hit the same point on the same wall.
+    struct RayCacheKey {
+        Vector2d   player_pos;
+        Vector2d   player_dir;
+        Vector2d   view_plane;
+        uint16_t   window_w    { 0 };
+        bool       euclidean   { false };
+        double     draw_dist   { 0 };
+        uint8_t    column_scale { 1 };
+        ScalarType scalar_type { ScalarType::Double };
+        // Layout::editCount, as rays hit walls that may since have changed
+        uint32_t   layout_edit_ct { 0 };
+    };
+    enum class RayCacheMode { Disabled, AllValid, Reproject, Interleave };
+
+    // Reused rays are off from the exact ray direction of their new column
+    //   by at most this fraction of a column, summed across every frame they
+    //   have been reused in, so the error stays well under a pixel.
+    static constexpr float RAY_CACHE_MAX_COLUMN_ERR { 0.125f };
+    // A ray is only reused if both its neighbors hit the same wall face at a
+    //   similar distance: a slightly offset ray could otherwise pass by a
+    //   wall corner and hit a different wall entirely.
+    static constexpr float RAY_CACHE_MAX_NEIGHBOR_DIST_RATIO { 0.05f };
+
+    // Temporal interleaving (Settings::interleave): after any camera change,
+    //   only columns of one parity are cast, alternating each frame, and
+    //   each column of the other parity was cast in the previous frame. Its
+    //   previous hit is moved into the current camera by intersecting the
+    //   column's new ray with the WallFace hit, which is kept if the ray
+    //   still hits the same tile face, and both newly cast neighbors hit the
+    //   same face line (so that nothing wider than a column can be in front).
+    //   Filled columns are exact, apart from such narrow occluders, and are
+    //   recast the next frame, so no error accumulates.
+    //
+    // parity of columns cast in current interleaved frame
+    uint8_t                    interleave_parity { 0 };
+    // position previous frame's rays were cast from
+    Vector2d                   prev_player_pos;
+
+    RayCacheKey                key;
+    // cleared by fitToWindow or invalidateRayCache
+    bool                       key_valid { false };
+    RayCacheMode               ray_cache_mode { RayCacheMode::Disabled };
+    // previous frame's rays, swapped with fov_rays when reprojecting
+    FovRayBuffer               prev_fov_rays;
+    // per column of current frame: column of prev_fov_rays to reuse or -1
+    //   to cast, factor converting previous perpendicular distance to
+    //   current, and accumulated direction error in columns
+    std::vector<int32_t>       reuse_src;
+    std::vector<float>         reuse_dist_scale;
+    std::vector<float>         reuse_err;
+    std::vector<float>         prev_reuse_err;
+    // updated concurrently by strips
+    std::atomic<uint32_t>      frame_hit_ct  { 0 };
+    std::atomic<uint32_t>      frame_miss_ct { 0 };
+    // DDA loop iterations of rays cast this frame
+    std::atomic<uint64_t>      frame_step_ct { 0 };
+    // totals for all frames before current
+    uint64_t                   prev_frames_hit_ct  { 0 };
+    uint64_t                   prev_frames_miss_ct { 0 };
+
+    /**
+     * @brief current camera state, for comparison with ray cache key
+     *
+     * @param settings - current game settings
+     */
+    RayCacheKey currentRayCacheKey(const Settings& settings) const;
+    /**
+     * @brief map each column to a column of the previous frame with the same
+     *   ray direction, to reuse after a pure rotation
+     *
+     * @return true if any columns can be reused
+     */
+    bool planReprojection();
+    /**
+     * @brief whether previous frame's ray is surrounded by rays hitting the
+     *   same wall face, so that a ray slightly offset from it would too
+     *
+     * @param prev_x - horizontal window pixel coordinate in previous frame
+     */
+    bool prevRayInsideWallFace(const uint16_t prev_x) const;
+    /**
+     * @brief copy ray from previous frame into column, if it can be reused
+     *
+     * @param window_x - horizontal window pixel coordinate
+     *
+     * @return true if ray reused, false if it still needs to be cast
+     */
+    bool reuseRay(const uint16_t window_x);
+    /**
+     * @brief whether all columns in a range can be reused
+     *
+     * @param begin_x - first horizontal window pixel coordinate
+     * @param end_x   - one past last horizontal window pixel coordinate
+     */
+    bool raysReusable(const uint16_t begin_x, const uint16_t end_x) const;
+    /**
+     * @brief fill column by moving previous frame's hit in the same column
+     *   into the current camera, if its wall face is still hit (see
+     *   Settings::interleave)
+     *
+     * @param window_x - horizontal window pixel coordinate, with both
+     *                     neighbors already cast this frame
+     * @param settings - current game settings
+     *
+     * @return true if filled, false if it still needs to be cast
+     */
+    bool reprojectPrevHit(const uint16_t window_x, const Settings& settings);
+
+    // owner of layout, shared with engines of other cameras on the same map
+    std::shared_ptr<Layout>    shared_layout;
+
 public:
+    // largest packet of any scalar type, so that ranges aligned to it divide
+    //   evenly into packets of every type
+    static constexpr uint16_t RAY_PACKET_SZ { 32 / sizeof(float) };
+
     // position vector (player x and y coordinates on map grid)
     Vector2d player_pos;
     // direction vector (represented as line segment on map grid from player
@@ -59,12 +713,34 @@ public:
     // When the player rotates, player_dir and view_plane should always remain
     //   perpendicular and of constant magnitude.
     Vector2d view_plane { 1, 0 };
+    // magnitude of view_plane, as set by fitToWindow, kept apart so that
+    //   placeCamera does not measure it again from view_plane and let it
+    //   drift with rounding (which would defeat exact camera comparisons)
+    double   view_plane_mag { 1 };
     // window horizontal pixel count
     uint16_t window_w;
 
-    std::vector<FovRay> fov_rays;
+    FovRayBuffer fov_rays;
 
-    Layout layout;
+    // (shared_layout)
+    Layout& layout;
+
+    DdaRaycastEngine() :
+        shared_layout(std::make_shared<Layout>()), layout(*shared_layout) {}
+    /**
+     * @brief engine for another camera on an existing map, so that each
+     *   camera keeps its own rays and ray cache, but all cast against one
+     *   Layout (loaded through any of them)
+     *
+     * @param _shared_layout - layout of another engine, from sharedLayout()
+     */
+    explicit DdaRaycastEngine(std::shared_ptr<Layout> _shared_layout) :
+        shared_layout(std::move(_shared_layout)), layout(*shared_layout) {}
+
+    DdaRaycastEngine(const DdaRaycastEngine&) = delete;
+    DdaRaycastEngine& operator=(const DdaRaycastEngine&) = delete;
+
+    std::shared_ptr<Layout> sharedLayout() const { return shared_layout; }
 
     /**
      * @brief scale engine to window size
@@ -80,26 +756,151 @@ public:
      * @brief parse map file into stage layout
      *
      * @param map_filename - map file
+     * @param storage      - memory layout of map wall lookups
+     * @param chunk_budget_mb - memory for resident chunks of chunk maps, for
+     *                            Settings::chunk_budget_mb
      */
-    inline void loadMapFile(const std::string& map_filename) {
+    inline void loadMapFile(const std::string& map_filename,
+                            const LayoutStorage storage = LayoutStorage::RowMajor,
+                            const uint32_t chunk_budget_mb = 256) {
+        layout.storage = storage;
+        layout.chunk_budget_mb = chunk_budget_mb;
         layout.loadMapFile(map_filename, player_pos);
     }
 
     /**
      * @brief apply DDA algorithm to cast ray from player position to first wall
-     *   hit
+     *   hit, in settings.scalar_type (or against wall segments, for segment
+     *   maps)
      *
      * @param window_x - horizontal window pixel coordinate
      * @param settings - current game settings
      */
     void castRay(const uint16_t window_x, const Settings& settings);
+    /**
+     * @brief update per column camera tables if the player has turned, and
+     *   compare camera against the state the current rays were cast from,
+     *   to decide which rays of the frame can be reused; must be called once
+     *   per frame before castRay or castRays
+     *
+     * @param settings - current game settings
+     */
+    void beginFrame(const Settings& settings);
+    /**
+     * @brief cast rays for a range of window columns, in packets if
+     *   settings.ray_packets is set (or against wall segments, for segment
+     *   maps), reusing rays of the previous frame where
+     *   beginFrame allowed (safe to call concurrently for disjoint ranges);
+     *   with settings.column_scale above 1, only columns that are multiples
+     *   of it are cast, and the rest left as they were
+     *
+     * @param begin_x  - first horizontal window pixel coordinate
+     * @param end_x    - one past last horizontal window pixel coordinate
+     * @param settings - current game settings
+     */
+    void castRays(const uint16_t begin_x, const uint16_t end_x,
+                  const Settings& settings);
     /**
      * @brief cast all rays in FOV
      *
      * @param settings - current game settings
      */
-    void castRays(const Settings& settings);
+    inline void castRays(const Settings& settings) {
+        beginFrame(settings);
+        castRays(0, window_w, settings);
+    }
+    /**
+     * @brief force all rays to be cast next frame (eg after the layout changes)
+     */
+    inline void invalidateRayCache() { key_valid = false; }
+    /**
+     * @brief cast a batch of ray queries against the layout, split into
+     *   strips across the thread pool; uses nothing of the camera, fov_rays
+     *   or window, so may be called for any engine sharing the layout
+     *
+     * @param rays        - ray queries, with hit fields set for every query
+     * @param settings    - current game settings (scalar_type, ray_packets
+     *                        and empty_space_skip used)
+     * @param thread_pool - workers to cast strips of queries on
+     */
+    void castRayQueries(RayQueryBuffer& rays, const Settings& settings,
+                        ThreadPool& thread_pool) const;
+    /**
+     * @brief bake layout.lights into layout's tile light levels: each empty
+     *   tile gets AMBIENT_LIGHT, plus the light of every light within reach
+     *   that a sight line from the tile's center reaches, with sight lines
+     *   cast as one batch of ray queries; maps without lights keep
+     *   Layout::LIGHT_LEVEL_ONE everywhere (call after loadMapFile)
+     *
+     * @param settings    - current game settings (as castRayQueries)
+     * @param thread_pool - workers to cast sight lines on
+     */
+    void bakeLighting(const Settings& settings, ThreadPool& thread_pool);
+    /**
+     * @brief apply tile edits queued with Layout::queueTileEdit, and bake
+     *   lighting again for the tiles in reach of any light reaching them;
+     *   called between frames, so that casting and rendering threads see the
+     *   layout as of the start of the frame
+     *
+     * @param settings    - current game settings (as castRayQueries)
+     * @param thread_pool - workers to cast sight lines and update
+     *                        potentially visible sets on
+     *
+     * @return whether any tile changed
+     */
+    bool applyTileEdits(const Settings& settings, ThreadPool& thread_pool);
+    /**
+     * @brief for chunk maps, install chunks loaded in the background, prefetch
+     *   those around and ahead of the player, and evict those over the budget
+     *   (see Layout::pageChunks); called between frames, as applyTileEdits
+     *
+     * @return whether any tile changed
+     */
+    bool pageChunks();
+    /**
+     * @brief ray cache hit and miss counts, including the current frame
+     */
+    RayCacheStats rayCacheStats() const;
+    /**
+     * @brief mean DDA loop iterations per ray cast in the current frame (reused
+     *   rays not counted)
+     */
+    double frameStepsPerRay() const;
 
+    /**
+     * @brief compare all rays cast in a scalar type against the same rays cast
+     *   in double, over a full turn of the player in place (player direction
+     *   restored afterwards)
+     *
+     * @param scalar_type - scalar type to measure
+     * @param settings    - current game settings (scalar_type ignored)
+     * @param turn_ct     - evenly spaced player directions to cast from
+     */
+    ScalarAccuracyReport scalarAccuracyReport(const ScalarType scalar_type,
+                                              const Settings& settings,
+                                              const uint16_t turn_ct = 360);
+    /**
+     * @brief compare all rays cast by wall spans (see castWallSpansAs) against
+     *   the same rays cast column by column, over a full turn of the player
+     *   in place at the player position and at empty tiles spread over the
+     *   map, to find columns filled across a face that is hidden (player
+     *   position and direction restored afterwards)
+     *
+     * @param settings - current game settings (wall_spans ignored)
+     * @param turn_ct  - evenly spaced player directions to cast from
+     * @param pos_ct   - positions to cast from, including the player's
+     */
+    ScalarAccuracyReport wallSpanAccuracyReport(const Settings& settings,
+                                                const uint16_t turn_ct = 360,
+                                                const uint16_t pos_ct = 16);
+
+    /**
+     * @brief move camera, keeping its FOV
+     *
+     * @param pos - new player_pos
+     * @param dir - new player_dir (unit vector)
+     */
+    void placeCamera(const Vector2d& pos, const Vector2d& dir);
     /**
      * @brief rotate player counterclockwise
      *
@@ -0,0 +1,111 @@
+#ifndef FIXEDPOINT_HH
+#define FIXEDPOINT_HH
+
+#include <cstdint>
+
+#include <limits>
+
+
+// Signed Q16.16 fixed point number: 16 integer bits (range -32768 to just under
+//   32768) and 16 fraction bits (resolution 1/65536) in an int32_t. Addition,
+//   subtraction and comparison are integer operations, so code limited to
+//   them (such as the DDA loop in DdaRaycastEngine) is integer-only and gives
+//   identical results on any machine. Multiplication and division use a
+//   64-bit intermediate. All arithmetic saturates rather than overflowing.
+class Fixed16_16 {
+private:
+    static constexpr int32_t FRACTION_BITS { 16 };
+
+    int32_t raw { 0 };
+
+    static constexpr Fixed16_16 fromRaw(const int64_t r) {
+        Fixed16_16 f;
+        f.raw = static_cast<int32_t>(r);
+        return f;
+    }
+
+    static constexpr Fixed16_16 saturate(const int64_t r) {
+        return fromRaw(r > std::numeric_limits<int32_t>::max() ?
+                       std::numeric_limits<int32_t>::max() :
+                       (r < std::numeric_limits<int32_t>::min() ?
+                        std::numeric_limits<int32_t>::min() : r));
+    }
+
+public:
+    static constexpr int32_t ONE { 1 << FRACTION_BITS };
+
+    constexpr Fixed16_16() {}
+    // rounds to nearest
+    explicit constexpr Fixed16_16(const double d) :
+        raw(static_cast<int32_t>(d * ONE + (d < 0 ? -0.5 : 0.5))) {}
+    explicit constexpr Fixed16_16(const int32_t i) : raw(i * ONE) {}
+
+    static constexpr Fixed16_16 max() {
+        return fromRaw(std::numeric_limits<int32_t>::max());
+    }
+
+    explicit constexpr operator double() const { return double(raw) / ONE; }
+    explicit constexpr operator float() const { return float(raw) / ONE; }
+    // truncates toward zero, as with floating point to integer conversion
+    explicit constexpr operator int32_t() const { return raw / ONE; }
+
+    constexpr Fixed16_16 operator-() const { return saturate(-int64_t(raw)); }
+
+    constexpr Fixed16_16& operator+=(const Fixed16_16 other) {
+        return *this = *this + other;
+    }
+    constexpr Fixed16_16& operator-=(const Fixed16_16 other) {
+        return *this = *this - other;
+    }
+
+    friend constexpr Fixed16_16 operator+(const Fixed16_16 a, const Fixed16_16 b) {
+        return saturate(int64_t(a.raw) + b.raw);
+    }
+    friend constexpr Fixed16_16 operator-(const Fixed16_16 a, const Fixed16_16 b) {
+        return saturate(int64_t(a.raw) - b.raw);
+    }
+    friend constexpr Fixed16_16 operator*(const Fixed16_16 a, const Fixed16_16 b) {
+        // arithmetic right shift rounds toward -inf, like floor
+        return saturate((int64_t(a.raw) * b.raw) >> FRACTION_BITS);
+    }
+    // division by 0 saturates to max (or min) value, like an IEEE 754 infinity
+    friend constexpr Fixed16_16 operator/(const Fixed16_16 a, const Fixed16_16 b) {
+        if (b.raw == 0)
+            return (a.raw < 0) ? saturate(std::numeric_limits<int64_t>::min()) : max();
+        return saturate((int64_t(a.raw) * ONE) / b.raw);
+    }
+
+    friend constexpr bool operator<(const Fixed16_16 a, const Fixed16_16 b) {
+        return a.raw < b.raw;
+    }
+    friend constexpr bool operator>(const Fixed16_16 a, const Fixed16_16 b) {
+        return a.raw > b.raw;
+    }
+    friend constexpr bool operator<=(const Fixed16_16 a, const Fixed16_16 b) {
+        return a.raw <= b.raw;
+    }
+    friend constexpr bool operator>=(const Fixed16_16 a, const Fixed16_16 b) {
+        return a.raw >= b.raw;
+    }
+    friend constexpr bool operator==(const Fixed16_16 a, const Fixed16_16 b) {
+        return a.raw == b.raw;
+    }
+    friend constexpr bool operator!=(const Fixed16_16 a, const Fixed16_16 b) {
+        return a.raw != b.raw;
+    }
+
+    // found by ADL alongside std::abs and std::floor in generic code
+    friend constexpr Fixed16_16 abs(const Fixed16_16 f) {
+        return (f.raw < 0) ? -f : f;
+    }
+    friend constexpr Fixed16_16 floor(const Fixed16_16 f) {
+        // two's complement, so clearing fraction bits rounds toward -inf
+        return fromRaw(f.raw & ~(ONE - 1));
+    }
+    friend constexpr Fixed16_16 ceil(const Fixed16_16 f) {
+        return saturate((int64_t(f.raw) + ONE - 1) & ~int64_t(ONE - 1));
+    }
+};
+
+
+#endif  // FIXEDPOINT_HH
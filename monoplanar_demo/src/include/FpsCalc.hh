@@ -34,6 +34,8 @@ private:
 public:
     // arbitrary start value of 100 RT FPS
     std::chrono::duration<double> frame_duration_mvg_avg { 0.01 };
+    // duration of last frame alone, unsmoothed
+    std::chrono::duration<double> frame_duration { 0.01 };
     void initialize();
     void calculate();
 };
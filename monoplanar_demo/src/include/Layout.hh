@@ -2,14 +2,61 @@
 #define LAYOUT_HH
 
 #include "Vector2d.hh"
+#include "Settings.hh"  // LayoutStorage
+#include "TileChunkCache.hh"
+#include "ThreadPool.hh"
 
-#include <cstdint>    // uint16_t
+#include <cstdint>    // uint32_t
+#include <cstddef>    // size_t
 // #include <cassert>
 
 #include <vector>
 #include <string>
+#include <memory>     // unique_ptr
+#include <iosfwd>     // ifstream
 
 
+// side of a wall tile, by the direction it faces
+enum class TileSide : uint8_t { N, S, E, W };
+
+// side of a wall tile that borders an empty tile, so can be seen
+struct WallTileFace {
+    uint32_t x;
+    uint32_t y;
+    TileSide side;
+};
+
+// rectangle of map tiles [x0, x1) x [y0, y1)
+struct TileRect {
+    uint32_t x0;
+    uint32_t y0;
+    uint32_t x1;
+    uint32_t y1;
+};
+
+// wall of a segment map: a line segment from (x0, y0) to (x1, y1) in map
+//   coordinates, with its texture starting at (x0, y0) and repeating every
+//   map unit along it
+struct WallSegment {
+    double  x0;
+    double  y0;
+    double  x1;
+    double  y1;
+    uint8_t tex_key;
+};
+
+// point light placed by a map file, baked into Layout tile light levels by
+//   DdaRaycastEngine::bakeLighting
+struct PointLight {
+    // position in map coordinates
+    double x;
+    double y;
+    // distance at which the light has faded to nothing, in map units
+    double radius;
+    // light added at the light's own position (1 is full texture brightness)
+    double brightness;
+};
+
 struct Layout {
 private:
     // Originally a 2D vector to aid in map file parsing, converted to 1D vector
@@ -22,33 +69,522 @@ private:
     //   represents a Quadrant I coordinate grid in the raycasting engine, so
     //   rows are stored in reversed order so +y always goes "north" in the map.
     std::vector<uint8_t> map;
+    // With LayoutStorage::Paged (chunk map files), tiles are held only in
+    //   chunks, in part, and map and the other per tile vectors stay empty.
+    std::unique_ptr<TileChunkCache> chunks;
+    // With LayoutStorage::TiledBitmap, wall flags (map != 0) are also kept
+    //   apart from the texture keys in map, 1 bit per tile, with each 8x8
+    //   block of tiles packed into one uint64_t (bit ((y % 8) * 8) + (x % 8)),
+    //   and blocks stored in rows. Neighboring tiles in both x and y then
+    //   usually share a word, and a 4096x4096 map needs 2MB of wall flags
+    //   rather than 16MB, so DDA steps in any direction rarely leave the
+    //   cache. Built from map by loadMapFile.
+    std::vector<uint64_t> wall_bits;
+    static constexpr uint8_t WALL_BLOCK_LOG2 { 3 };
+    static constexpr uint8_t WALL_BLOCK_MASK { (1 << WALL_BLOCK_LOG2) - 1 };
+    uint32_t wall_blocks_w { 0 };
+    // Chebyshev distance from each tile to its nearest wall tile (0 for walls,
+    //   capped at 255), so that every tile in the square of tiles centered on
+    //   (x, y) and reaching wall_dist - 1 tiles in each direction is empty.
+    //   Built from map by loadMapFile, same coordinates as map.
+    std::vector<uint8_t> wall_dist;
+
+    // Occupancy pyramid: level i flags each aligned block of tiles
+    //   (2^((i + 1) * OCCUPANCY_LEVEL_LOG2) tiles square) containing any wall,
+    //   with levels added until one block covers the whole map. Built from map
+    //   by loadMapFile.
+    struct OccupancyLevel {
+        uint32_t             w;  // blocks
+        uint32_t             h;  // blocks
+        std::vector<uint8_t> occupied;
+    };
+    // each level's blocks are 4x4 blocks of the level below
+    static constexpr uint8_t OCCUPANCY_LEVEL_LOG2 { 2 };
+    std::vector<OccupancyLevel> occupancy_levels;
+
+    // Potentially visible sets: for each empty tile, the faces in wall_faces
+    //   seen from some point in the tile, as a list of wall_faces indices in
+    //   pvs_face_is from pvs_offsets[(y * w) + x] to pvs_offsets[(y * w) + x
+    //   + 1] (wall tiles have empty lists). Lists may hold faces that are
+    //   hidden, but never miss a visible one. Built from map by
+    //   buildPotentiallyVisibleSets, and kept by applyTileEdits.
+    std::vector<WallTileFace> wall_faces;
+    std::vector<uint32_t>     pvs_offsets;
+    std::vector<uint32_t>     pvs_face_is;
+    // every empty tile floods the tiles it may see past (see reachTiles) and
+    //   is tested against every face that flood reaches, so building takes
+    //   time in proportion to the square of the tile count, and larger maps
+    //   (in tiles) are refused
+    static constexpr uint32_t PVS_MAX_TILE_CT { 256 * 256 };
+    // tiles per ThreadPool strip when building potentially visible sets
+    static constexpr uint32_t PVS_STRIP_SZ { 64 };
+    // first line of a potentially visible sets file
+    static constexpr char     PVS_FILE_HEADER[] { "pvs" };
+    // tile edge and face segment pairs still undecided after this many
+    //   halvings count as visible
+    static constexpr uint8_t PVS_MAX_SPLIT_DEPTH { 6 };
+    // Wall runs (maximal rows or columns of wall tiles), as tile rectangles
+    //   [x0, x1) x [y0, y1), and the row and column run of each wall tile,
+    //   kept only while building potentially visible sets
+    struct WallRun {
+        uint32_t x0;
+        uint32_t y0;
+        uint32_t x1;
+        uint32_t y1;
+    };
+    std::vector<WallRun>  wall_runs;
+    std::vector<uint32_t> tile_row_run_is;
+    std::vector<uint32_t> tile_col_run_is;
+
+    // Segment maps: walls are the line segments in segments (including four
+    //   closing the map along the inside of its perimeter tiles) rather than
+    //   whole tiles. As a uniform grid with map tiles as cells, each tile
+    //   lists copies of the segments within SEGMENT_TILE_MARGIN of it
+    //   (including along its edges) in tile_segments, from
+    //   tile_segment_offsets[(y * w) + x] to tile_segment_offsets[(y * w) + x
+    //   + 1], so that rays only test the segments of the tiles they cross.
+    //   Tiles whose interior a segment passes through are also set in map to
+    //   its texture key, so that movement, agents and the minimap treat them
+    //   as walls. Built by loadMapFile.
+    std::vector<WallSegment> segments;
+    std::vector<uint32_t>    tile_segment_offsets;
+    std::vector<WallSegment> tile_segments;
+    // first line of a segment map file
+    static constexpr char     SEGMENT_MAP_HEADER[] { "segments" };
+    // segments this close to a tile (in map units) are listed in it, so that
+    //   rays hitting a segment on a tile edge find it from either side
+    static constexpr double   SEGMENT_TILE_MARGIN { 1e-6 };
+
+    /**
+     * @brief parse rows of tile digits into map
+     *
+     * @param map_ifs    - map file, at its first line
+     * @param player_pos - set to start position
+     */
+    void parseTileMap(std::ifstream& map_ifs, Vector2d& player_pos);
+    /**
+     * @brief parse lines of wall segments into segments, and rasterize them
+     *   into map
+     *
+     * @param map_ifs    - map file, after its SEGMENT_MAP_HEADER line
+     * @param player_pos - set to start position
+     */
+    void parseSegmentMap(std::ifstream& map_ifs, Vector2d& player_pos);
+    /**
+     * @brief open a chunk map file into chunks, with no tiles kept in map
+     *
+     * @param map_filename - chunk map file
+     * @param player_pos   - set to start position
+     */
+    void loadChunkMapFile(const std::string& map_filename, Vector2d& player_pos);
+    // bucketing of segments into tile_segment_offsets and tile_segments
+    void buildSegmentGrid();
+
+    // writable tile (x, y) of map, for parsing and edits
+    uint8_t& mapTile(const uint32_t x, const uint32_t y) {
+        // assert(x < w && y < h);
+        return map[tileIndex(x, y)];
+    }
+
+    // light level per tile, same coordinates as map (see tileLight)
+    std::vector<uint8_t> tile_light;
+
+    // Tile edits (see queueTileEdit), held until applyTileEdits so that the
+    //   layout only changes between frames
+    struct TileEdit {
+        uint32_t x;
+        uint32_t y;
+        uint8_t  tex_key;
+    };
+    std::vector<TileEdit> pending_tile_edits;
+    // loads and applied edit batches so far (see editCount)
+    uint32_t              edit_ct { 0 };
+
+    // packing of map into wall_bits
+    void buildWallBitmap();
+    // two pass chamfer transform of map into wall_dist
+    void buildWallDistanceField();
+    // reduction of map into occupancy_levels
+    void buildOccupancyPyramid();
+    // faces of wall tiles bordering empty tiles, in map order
+    std::vector<WallTileFace> findWallFaces() const;
+    // wall runs of map into wall_runs, tile_row_run_is and tile_col_run_is
+    void buildWallRuns();
+    /**
+     * @brief (re)build wall_faces, pvs_offsets and pvs_face_is on a thread
+     *   pool, testing each empty tile against the faces next to the tiles
+     *   reachTiles finds from it; with sets already built, only the lists of
+     *   tiles that may see a changed tile are tested again, as any segment
+     *   whose clearance changed passes through one, and the rest are kept
+     *   with their face indices renumbered
+     *
+     * @param changed_is  - map indices of tiles turned from empty to wall or
+     *                        back since the sets were built
+     * @param thread_pool - workers to test tiles on
+     */
+    void updatePotentiallyVisibleSets(const std::vector<size_t>& changed_is,
+                                      ThreadPool& thread_pool);
+    /**
+     * @brief update wall_dist after edits, touching only tiles whose distance
+     *   may have changed: tiles that may have measured their distance from a
+     *   removed wall are reset and then, with the rest, lowered outward from
+     *   the tiles around them and from added walls, in order of distance
+     *
+     * @param removed_is - map indices of walls made empty
+     * @param added_is   - map indices of empty tiles made walls
+     */
+    void updateWallDistanceField(const std::vector<size_t>& removed_is,
+                                 const std::vector<size_t>& added_is);
+    /**
+     * @brief update the occupancy_levels blocks containing a tile, from the
+     *   first level up, stopping at the first block left unchanged
+     *
+     * @param x, y - edited tile
+     */
+    void updateOccupancy(const uint32_t x, const uint32_t y);
+
+    /**
+     * @brief mark the tiles some segment from a point in an empty tile may
+     *   reach while passing through no wall tile interior: as such a segment
+     *   steps monotonically in x and y, a tile is marked in a quadrant if it
+     *   is empty and steps on from a tile marked before it in x, y or both
+     *
+     * @param x, y  - empty tile
+     * @param reach - set to a bit per quadrant of directions (bit 0 for -x,
+     *                  bit 1 for -y) for every map tile, 0 for those not
+     *                  reached in any
+     */
+    void reachTiles(const uint32_t x, const uint32_t y,
+                    std::vector<uint8_t>& reach) const;
+    /**
+     * @brief whether a segment passes through the interior of no wall tile
+     *
+     * @param a       - segment start in map coordinates
+     * @param b       - segment end in map coordinates
+     * @param on_wall - called with the map index of each wall tile the
+     *                    segment does pass through, in order from a, ending
+     *                    the walk when it returns true
+     */
+    template <typename WallFunc>
+    bool segmentClear(const Vector2d& a, const Vector2d& b,
+                      WallFunc&& on_wall) const;
+    /**
+     * @brief whether every segment from a point on segment a to a point on
+     *   segment b passes through a wall run
+     *
+     * @param run    - wall run
+     * @param a0, a1 - ends of first segment
+     * @param b0, b1 - ends of second segment
+     */
+    static bool runBlocksAll(const WallRun& run,
+                             const Vector2d& a0, const Vector2d& a1,
+                             const Vector2d& b0, const Vector2d& b1);
+    /**
+     * @brief whether some segment from a point on segment a to a point on
+     *   segment b may pass through no wall tile interior
+     *
+     * @param a0, a1 - ends of first segment
+     * @param b0, b1 - ends of second segment
+     * @param depth  - halvings of both segments so far
+     */
+    bool segmentsMaySee(const Vector2d& a0, const Vector2d& a1,
+                        const Vector2d& b0, const Vector2d& b1,
+                        const uint8_t depth) const;
+    /**
+     * @brief whether a wall face may be seen from some point in an empty tile
+     *
+     * @param x, y - empty tile
+     * @param face - wall face
+     */
+    bool tileMaySeeFace(const uint32_t x, const uint32_t y,
+                        const WallTileFace& face) const;
+    /**
+     * @brief whether some segment from a point in a tile to a point on a wall
+     *   face may pass through, or along an edge of, another tile: whether the
+     *   other tile meets the convex hull of the first tile and the face
+     *
+     * @param x, y             - tile segments start in
+     * @param face             - wall face segments end on
+     * @param cross_x, cross_y - tile passed through
+     */
+    static bool sightMayCross(const uint32_t x, const uint32_t y,
+                              const WallTileFace& face,
+                              const uint32_t cross_x, const uint32_t cross_y);
 
 public:
-    uint16_t w;  // cols
-    uint16_t h;  // rows
+    uint32_t w;  // cols
+    uint32_t h;  // rows
+
+    // largest map width or height in tiles, kept within int32_t so that rays
+    //   can step through tile coordinates as signed 32-bit integers
+    static constexpr uint32_t MAX_DIM { INT32_MAX };
 
-    void resize(const uint16_t _w, const uint16_t _h) {
+    // index of tile (x, y) in map and the other per tile vectors, in size_t
+    //   as maps may hold more than 2^32 tiles
+    size_t tileIndex(const uint32_t x, const uint32_t y) const {
+        return (size_t(y) * w) + x;
+    }
+
+    // Light levels scale texels linearly, with LIGHT_LEVEL_ONE leaving them
+    //   unchanged, so the brightest level is nearly twice as bright.
+    static constexpr uint8_t LIGHT_LEVEL_CT { 64 };
+    static constexpr uint8_t LIGHT_LEVEL_ONE { 32 };
+
+    // point lights placed by the map file, in map coordinates
+    std::vector<PointLight> lights;
+
+    // set before loadMapFile
+    LayoutStorage storage         { LayoutStorage::RowMajor };
+    uint32_t      chunk_budget_mb { 256 };
+
+    void resize(const uint32_t _w, const uint32_t _h) {
         w = _w;
         h = _h;
-        map.resize(w * h);
+        map.resize(size_t(w) * h);
     }
 
-    uint8_t& tile(const uint16_t x, const uint16_t y) {
+    // texture key of tile (x, y), 0 for empty; with Paged storage, also 0
+    //   for tiles of chunks not yet loaded (see TileChunkCache)
+    uint8_t tile(const uint32_t x, const uint32_t y) const {
         // assert(x < w && y < h);
-        return map[(y * w) + x];
+        if (storage == LayoutStorage::Paged)
+            return chunks->tile(x, y);
+        return map[tileIndex(x, y)];
     }
 
-    const uint8_t& tile(const uint16_t x, const uint16_t y) const {
+    // (with Paged storage, tiles of chunks not yet loaded are walls)
+    bool tileIsWall(const uint32_t x, const uint32_t y) const {
         // assert(x < w && y < h);
-        return map[(y * w) + x];
+        if (storage == LayoutStorage::Paged)
+            return chunks->tileIsWall(x, y);
+        if (storage == LayoutStorage::TiledBitmap) {
+            const uint64_t block { wall_bits[
+                (size_t(y >> WALL_BLOCK_LOG2) * wall_blocks_w) +
+                (x >> WALL_BLOCK_LOG2)] };
+            return (block >> (((y & WALL_BLOCK_MASK) << WALL_BLOCK_LOG2) |
+                              (x & WALL_BLOCK_MASK))) & 1;
+        }
+        return map[tileIndex(x, y)] != 0;
     }
 
-    bool tileIsWall(const uint16_t x, const uint16_t y) const {
+    /**
+     * @brief wall flags of N tiles at once, as by tileIsWall, with storage
+     *   checked once rather than per tile, so that row-major and tiled bitmap
+     *   lookups are branch-free indexed loads
+     *
+     * @param xs, ys  - map tiles
+     * @param is_wall - set per tile
+     */
+    template <uint16_t N>
+    void tilesAreWall(const int32_t (&xs)[N], const int32_t (&ys)[N],
+                      bool (&is_wall)[N]) const {
+        switch (storage) {
+        case LayoutStorage::Paged:
+            for (uint16_t i { 0 }; i < N; ++i)
+                is_wall[i] = chunks->tileIsWall(xs[i], ys[i]);
+            break;
+        case LayoutStorage::TiledBitmap:
+        {
+            const uint64_t* bits { wall_bits.data() };
+            for (uint16_t i { 0 }; i < N; ++i) {
+                const uint32_t x ( xs[i] );
+                const uint32_t y ( ys[i] );
+                const uint64_t block { bits[
+                    (size_t(y >> WALL_BLOCK_LOG2) * wall_blocks_w) +
+                    (x >> WALL_BLOCK_LOG2)] };
+                is_wall[i] = (block >> (((y & WALL_BLOCK_MASK) << WALL_BLOCK_LOG2) |
+                                        (x & WALL_BLOCK_MASK))) & 1;
+            }
+        }
+            break;
+        default:
+        {
+            const uint8_t* tiles { map.data() };
+            for (uint16_t i { 0 }; i < N; ++i)
+                is_wall[i] = tiles[tileIndex(xs[i], ys[i])] != 0;
+        }
+            break;
+        }
+    }
+
+    // tiles in each direction from (x, y) guaranteed to be empty (0 for
+    //   chunk maps, which have no distance field)
+    uint8_t emptyRadius(const uint32_t x, const uint32_t y) const {
+        // assert(x < w && y < h);
+        if (wall_dist.empty())
+            return 0;
+        const uint8_t dist { wall_dist[tileIndex(x, y)] };
+        return dist ? dist - 1 : 0;
+    }
+
+    // log2 of the side of the largest aligned block of tiles containing (x, y)
+    //   that the occupancy pyramid has flagged empty, or 0 if none (always
+    //   for chunk maps, which have no pyramid)
+    uint8_t emptyBlockLog2(const uint32_t x, const uint32_t y) const {
+        uint8_t block_log2 { 0 };
+        for (const auto& level : occupancy_levels) {
+            const uint8_t level_log2 ( block_log2 + OCCUPANCY_LEVEL_LOG2 );
+            if (level.occupied[(size_t(y >> level_log2) * level.w) +
+                               (x >> level_log2)])
+                break;
+            block_log2 = level_log2;
+        }
+        return block_log2;
+    }
+
+    // whether potentially visible sets were built
+    bool hasPvs() const { return !pvs_offsets.empty(); }
+
+    /**
+     * @brief find the wall faces potentially visible from each empty tile
+     *   (see pvsBegin), for Settings::pvs; tile maps only, as segment maps
+     *   have no tile faces and chunk maps are never whole in memory (call
+     *   after loadMapFile)
+     *
+     * @param thread_pool - workers to test tiles on
+     */
+    void buildPotentiallyVisibleSets(ThreadPool& thread_pool);
+
+    // Potentially visible sets files: built once by writePvsFile beside the
+    //   map file, named for it with PVS_FILE_SUFFIX added, for loading in
+    //   place of building them. After a PVS_FILE_HEADER line and a "w h
+    //   face_ct visible_ct" line come, as raw bytes in host byte order, the
+    //   wall flag of each tile (1 byte) that the sets were built for,
+    //   pvs_offsets and pvs_face_is (as 4 byte integers).
+    static constexpr char PVS_FILE_SUFFIX[] { ".pvs" };
+    /**
+     * @brief write built potentially visible sets to a file, which
+     *   readPvsFile can load for the same tiles
+     *
+     * @param pvs_filename - file to write
+     */
+    void writePvsFile(const std::string& pvs_filename) const;
+    /**
+     * @brief load potentially visible sets written by writePvsFile, in place
+     *   of buildPotentiallyVisibleSets, if the file exists and was written for
+     *   the walls of the tiles now loaded (call after loadMapFile)
+     *
+     * @param pvs_filename - file to read
+     *
+     * @return whether the sets were loaded
+     */
+    bool readPvsFile(const std::string& pvs_filename);
+
+    const WallTileFace& wallFace(const uint32_t face_i) const {
+        return wall_faces[face_i];
+    }
+
+    // indices (for wallFace()) of the faces potentially visible from empty
+    //   tile (x, y), from pvsBegin(x, y) to pvsEnd(x, y)
+    const uint32_t* pvsBegin(const uint32_t x, const uint32_t y) const {
+        // assert(hasPvs() && x < w && y < h);
+        return pvs_face_is.data() + pvs_offsets[tileIndex(x, y)];
+    }
+
+    const uint32_t* pvsEnd(const uint32_t x, const uint32_t y) const {
+        // assert(hasPvs() && x < w && y < h);
+        return pvs_face_is.data() + pvs_offsets[tileIndex(x, y) + 1];
+    }
+
+    // light level of tile (x, y): the light at its center, which also lights
+    //   the wall faces bordering it; LIGHT_LEVEL_ONE for every tile until
+    //   DdaRaycastEngine::bakeLighting, and always for chunk maps (which have
+    //   no lights)
+    uint8_t tileLight(const uint32_t x, const uint32_t y) const {
         // assert(x < w && y < h);
-        return map[(y * w) + x] != 0;
+        if (storage == LayoutStorage::Paged)
+            return LIGHT_LEVEL_ONE;
+        return tile_light[tileIndex(x, y)];
+    }
+
+    void setTileLight(const uint32_t x, const uint32_t y, const uint8_t level) {
+        // assert(x < w && y < h && storage != LayoutStorage::Paged);
+        tile_light[tileIndex(x, y)] = level;
+    }
+
+    // tiles whose centers a light may reach, clamped to the map
+    TileRect lightTiles(const PointLight& light) const;
+
+    /**
+     * @brief set tile (x, y) to tex_key (0 for empty) when applyTileEdits is
+     *   next called, after any edits queued before it; tiles of the perimeter,
+     *   of segment maps (whose walls are segments) and of chunk maps (whose
+     *   tiles are read back from the file as evicted) cannot be edited
+     *
+     * @param x, y    - tile to edit
+     * @param tex_key - new texture key, 0-9
+     */
+    void queueTileEdit(const uint32_t x, const uint32_t y, const uint8_t tex_key);
+    /**
+     * @brief apply queued tile edits to map, updating wall flags, the
+     *   distance field and the occupancy pyramid only around the tiles
+     *   changed, and potentially visible sets only for the tiles that may
+     *   see them. Not to be called while other threads read the layout, so
+     *   is called between frames (see DdaRaycastEngine::applyTileEdits,
+     *   which also updates lighting).
+     *
+     * @param dirty       - set to the tiles changed, if any
+     * @param thread_pool - workers to update potentially visible sets on
+     *
+     * @return whether any tile changed
+     */
+    bool applyTileEdits(TileRect& dirty, ThreadPool& thread_pool);
+    // times the map was loaded or had edits applied, so that results derived
+    //   from the layout elsewhere (eg cached rays) can tell when they are stale
+    uint32_t editCount() const { return edit_ct; }
+
+    // whether the map was loaded from a segment map file
+    bool hasSegments() const { return !segments.empty(); }
+
+    // whether the map was loaded from a chunk map file
+    bool isPaged() const { return storage == LayoutStorage::Paged; }
+
+    /**
+     * @brief with Paged storage, bring in chunks loaded since the last call
+     *   and evict those over the budget (see TileChunkCache::update); not to
+     *   be called while other threads read the layout, so is called between
+     *   frames
+     *
+     * @param player_pos - player position
+     * @param player_dir - player direction
+     *
+     * @return whether any tile changed (chunk loaded or evicted)
+     */
+    bool pageChunks(const Vector2d& player_pos, const Vector2d& player_dir);
+    /**
+     * @brief write a tile map as a chunk map file, which
+     *   loadMapFile can then page in from disk
+     *
+     * @param map_filename - chunk map file to write
+     * @param player_pos   - start position
+     */
+    void writeChunkMapFile(const std::string& map_filename,
+                           const Vector2d& player_pos) const;
+
+    // segments within SEGMENT_TILE_MARGIN of tile (x, y), from
+    //   segmentsBegin(x, y) to segmentsEnd(x, y)
+    const WallSegment* segmentsBegin(const uint32_t x, const uint32_t y) const {
+        // assert(hasSegments() && x < w && y < h);
+        return tile_segments.data() + tile_segment_offsets[tileIndex(x, y)];
+    }
+
+    const WallSegment* segmentsEnd(const uint32_t x, const uint32_t y) const {
+        // assert(hasSegments() && x < w && y < h);
+        return tile_segments.data() + tile_segment_offsets[tileIndex(x, y) + 1];
     }
 
-    // parses map file in with inverted rows
+    // Parses map file in with inverted rows, or, if its first line is
+    //   SEGMENT_MAP_HEADER, as a segment map: after the header, lines of
+    //   "x0 y0 x1 y1 tex_key" walls (tex_key 1-9) and one "player x y" start
+    //   position, in map coordinates with +y north (blank lines and lines
+    //   starting with '#' are skipped). Segment map coordinates must not be
+    //   negative, and are offset by one tile for the perimeter. Either may
+    //   place point lights with "light x y radius brightness" lines: after the
+    //   empty line ending the rows of a tile map, with x and y the column and
+    //   row of a map character (counted from 0 at the top left) and lights at
+    //   its center, or among the walls of a segment map. A file whose first
+    //   line is TileChunkCache::CHUNK_MAP_HEADER is instead opened as a chunk
+    //   map, setting storage to Paged, with its tiles loaded as needed.
     void loadMapFile(const std::string& map_filename, Vector2d& player_pos);
 };
 
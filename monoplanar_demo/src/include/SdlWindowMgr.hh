@@ -1,7 +1,7 @@
 #ifndef SDLWINDOWMGR_HH
 #define SDLWINDOWMGR_HH
 
-#include "DdaRaycastEngine.hh"    // FovRay
+#include "DdaRaycastEngine.hh"    // FovRayBuffer
 #include "KbdInputMgr.hh"
 #include "Settings.hh"
 #include "WindowMgr.hh"           // sdl2_unq
@@ -22,7 +22,6 @@ class SdlWindowMgr : public WindowMgr {
 private:
     static constexpr uint16_t WINDOW_HEIGHT { 480 };
     static constexpr uint16_t WINDOW_WIDTH { 853 };  // 853:480 ~ 16:9
-    static constexpr char SKY_TEX_PATH[] { "images/Vue1.jpg" };
     static constexpr char FONT_PATH[] { "fonts/Courier New.ttf" };
 
     // Best way in testing to prevent leaks and read errors with the freeing of
@@ -44,10 +43,7 @@ private:
 
     // element textures
     //
-    // sky plane (maze background when not texturing ceiling and floor)
-    sdl2_unq::Texture               sky_tex;
-    // wall textures (SDL_Surface instead of SDL_Texture for per-pixel access)
-    std::vector<sdl2_unq::Surface>  wall_texs;
+    // (wall, floor and ceiling textures in WindowMgr::wall_texs)
     // HUD chars
     std::unordered_map<
         uint8_t, sdl2_unq::Texture> font_cache;
@@ -70,8 +66,14 @@ private:
     void makeGlyphs(const char* font_filename);
     // render formatted line of text
     void renderHudLine(const std::string line, SDL_Rect glyph_rect);
-    // render one vertical wall segment
-    void renderPixelColumn(const uint16_t screen_x, const FovRay& ray);
+
+    // write one row of floor and one of ceiling around wall segments
+    void renderFloorCeilingRow(const Viewport& viewport,
+                               const uint16_t floor_view_y,
+                               const uint16_t begin_x, const uint16_t end_x,
+                               const Settings& settings);
+    // copy rendered view to window texture
+    void endView(const Settings& /*settings*/);
 
 public:
     SdlWindowMgr();
@@ -81,20 +83,34 @@ public:
     uint16_t width();
     uint16_t height();
 
-    void initialize(const Settings& settings, const uint16_t layout_h);
+    void initialize(const Settings& settings, const uint32_t layout_h);
 
     // adjusting rendering specs to after window resize event
-    void fitToWindow(const double map_proportion, const uint16_t layout_h);
+    void fitToWindow(const double map_proportion, const uint32_t layout_h);
+
+    // render one vertical wall segment
+    void renderPixelColumn(const Viewport& viewport, const uint16_t view_x,
+                           const FovRayBuffer& fov_rays,
+                           const Settings& settings);
+
+    // draw one vertical sprite segment over wall segment
+    void renderSpriteColumn(const Viewport& viewport, const uint16_t view_x,
+                            const ViewSprite& sprite,
+                            const uint32_t* tex_column,
+                            const Settings& settings);
 
-    void renderView(const std::vector<FovRay>& fov_rays,
-                    const Settings& /*settings*/);
+    // replicate rendered wall segment into skipped column
+    void copyPixelColumn(const Viewport& viewport, const uint16_t src_view_x,
+                         const uint16_t dst_view_x);
 
-    void renderMap(const DdaRaycastEngine& raycast_engine);
+    void renderMap(const DdaRaycastEngine& raycast_engine,
+                   const SpriteGrid& sprites);
 
     void renderHud(const double pt_frame_duration_mvg_avg,
                    const double rt_frame_duration_mvg_avg,
                    const Settings& settings,
                    const DdaRaycastEngine& raycast_engine,
+                   const AgentSim& agent_sim,
                    const KbdInputMgr* kbd_input_mgr);
 
     void drawFrame(const Settings& settings);
@@ -102,7 +118,6 @@ public:
 
 // C++11 static constexpr members that are not built-in types need redeclaration
 //   outside class: https://en.cppreference.com/w/cpp/language/static
-//constexpr char SdlWindowMgr::SKY_TEX_PATH[];
 //constexpr char SdlWindowMgr::FONT_PATH[];
 
 
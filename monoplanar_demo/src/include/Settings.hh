@@ -1,9 +1,80 @@
 #ifndef SETTINGS_HH
 #define SETTINGS_HH
 
+#include <cstdint>    // uint8_t uint16_t
+
 
 enum class TtyDisplayMode { Uninitialized, Ascii, ColorCode, TrueColor };
 
+// numeric type used for DDA raycasting
+enum class ScalarType { Double, Float, Fixed16_16 };
+
+/**
+ * @brief short name of scalar type, as given on command line
+ *
+ * @param scalar_type - scalar type to name
+ */
+inline const char* scalarTypeName(const ScalarType scalar_type) {
+    switch (scalar_type) {
+    case ScalarType::Float:      return "float";
+    case ScalarType::Fixed16_16: return "fixed";
+    case ScalarType::Double:
+    default:                     return "double";
+    }
+}
+
+// how DDA raycasting crosses runs of empty map tiles
+enum class EmptySpaceSkip { None, DistanceField, OccupancyPyramid };
+
+/**
+ * @brief short name of empty space skipping mode, as given on command line
+ *
+ * @param empty_space_skip - empty space skipping mode to name
+ */
+inline const char* emptySpaceSkipName(const EmptySpaceSkip empty_space_skip) {
+    switch (empty_space_skip) {
+    case EmptySpaceSkip::DistanceField:    return "distance";
+    case EmptySpaceSkip::OccupancyPyramid: return "pyramid";
+    case EmptySpaceSkip::None:
+    default:                               return "none";
+    }
+}
+
+// memory layout of map wall lookups (Paged is set by Layout for chunk map
+//   files, whatever was chosen)
+enum class LayoutStorage { RowMajor, TiledBitmap, Paged };
+
+/**
+ * @brief short name of layout storage, as given on command line
+ *
+ * @param layout_storage - layout storage to name
+ */
+inline const char* layoutStorageName(const LayoutStorage layout_storage) {
+    switch (layout_storage) {
+    case LayoutStorage::TiledBitmap: return "tiled";
+    case LayoutStorage::Paged:       return "paged";
+    case LayoutStorage::RowMajor:
+    default:                         return "rowmajor";
+    }
+}
+
+// cameras rendered into the window each frame
+enum class CameraLayout { Single, SplitScreen, RearInset };
+
+/**
+ * @brief short name of camera layout, as given on command line
+ *
+ * @param camera_layout - camera layout to name
+ */
+inline const char* cameraLayoutName(const CameraLayout camera_layout) {
+    switch (camera_layout) {
+    case CameraLayout::SplitScreen: return "split";
+    case CameraLayout::RearInset:   return "inset";
+    case CameraLayout::Single:
+    default:                        return "single";
+    }
+}
+
 struct Settings {
     TtyDisplayMode  tty_display_mode    { TtyDisplayMode::Uninitialized };
 
@@ -17,10 +88,70 @@ struct Settings {
     // when true, use real ray distance to wall rather than perpendicular
     //   camera plane distance
     bool            euclidean           { false };
-    // used to determine player movement speed, as pegged to frame rate
+    // when true, cast adjacent rays together as SIMD packets rather than
+    //   one at a time
+    bool            ray_packets         { false };
+    // when true, rays are only recast when the camera has changed, and after
+    //   pure rotations only for columns that cannot reuse a previous ray
+    bool            ray_cache           { true };
+    // when true, rays not reused from the previous frame are found a wall
+    //   face at a time, casting only the ends of each run of columns hitting
+    //   the same face
+    bool            wall_spans          { false };
+    // when true, frames after the camera has moved only cast every other
+    //   column, alternating each frame, and fill the rest from the
+    //   previous frame's hits
+    bool            interleave          { false };
+    // when not None, rays jump across empty map areas rather than stepping
+    //   one tile at a time
+    EmptySpaceSkip  empty_space_skip    { EmptySpaceSkip::None };
+    // rays stop at this perpendicular distance from the camera plane, with
+    //   walls fading into fog as they approach it (0 for unlimited)
+    double          draw_dist           { 0 };
+    // when true, far walls sample smaller copies of their textures
+    bool            texture_lod         { true };
+    // when nonzero, column_scale is raised while the real time frame rate is
+    //   below this, and lowered again once there is headroom
+    double          target_fps          { 0 };
+    // rays are cast and pixel columns rendered for only every column_scale
+    //   window columns (1, 2 or 4), with each copied to the columns on its
+    //   right; set by App when target_fps is nonzero
+    uint8_t         column_scale        { 1 };
+    // chosen at startup; tiled bitmap packs wall flags into 8x8 tile blocks
+    //   for fewer cache misses on large maps
+    LayoutStorage   layout_storage      { LayoutStorage::RowMajor };
+    // chosen at startup; memory for the chunks of a chunk map file held at
+    //   once, in MiB, with the least recently used evicted beyond it
+    uint32_t        chunk_budget_mb     { 256 };
+    // chosen at startup; when true, the wall faces visible from each empty
+    //   map tile are found when the map is loaded, and rays not reused from
+    //   the previous frame are found from the faces visible from the
+    //   player's tile rather than cast
+    bool            pvs                 { false };
+    // chosen at startup; split screen shows the player's view beside a
+    //   rear view, rear inset draws the rear view over the top of it
+    CameraLayout    camera_layout       { CameraLayout::Single };
+    // chosen at startup; agents wandering the map, simulated each frame
+    //   and drawn on the minimap
+    uint32_t        agent_ct            { 0 };
+    // chosen at startup; float halves memory per ray and doubles SIMD lanes
+    //   per packet, fixed point makes DDA stepping integer-only
+    ScalarType      scalar_type         { ScalarType::Double };
+    // when true, rays are cast in scalar_type relative to the corner of the
+    //   player's map tile rather than the map origin, so that float and fixed
+    //   point keep sub-tile precision far from the origin of large maps
+    bool            rebase_origin       { true };
+    // chosen at startup; player input and movement are simulated in fixed
+    //   steps at this rate (Hz) whatever the frame rate, with the camera
+    //   placed between the last two steps when rendering
+    double          sim_tick_rate       { 60.0 };
+    // player movement speed, in map units per second
     double          base_movement_rate  { 5.0 };
     // expressed as percentage of base_movement_rate
     double          turn_rate           { 0.6 };  // 3.0
+    // threads used to cast and render the FOV, including the main thread
+    //   (0 for hardware concurrency)
+    uint16_t        thread_ct           { 0 };
 };
 
 
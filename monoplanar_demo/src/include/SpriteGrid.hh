@@ -0,0 +1,131 @@
+#ifndef SPRITEGRID_HH
+#define SPRITEGRID_HH
+
+#include <cstdint>
+#include <cstddef>    // size_t
+
+#include <vector>
+#include <algorithm>  // min max
+
+
+// billboard drawn upright on the floor, always facing the camera
+struct Sprite {
+    // center of base in map coordinates
+    float   x;
+    float   y;
+    // width and height in map units (wall height is 1); at most
+    //   SpriteGrid::MAX_SPRITE_SCALE
+    float   scale;
+    // index of sprite texture (see WindowMgr::sprite_texs)
+    uint8_t tex_key;
+};
+
+// Sprites bucketed into square cells of CELL_SZ x CELL_SZ map tiles, so that
+//   finding the sprites in a camera's view only visits the cells its FOV
+//   overlaps, rather than every sprite on the map. Sprites are added with add
+//   and then bucketed with build, by counting sort into one array in cell
+//   order, so rebuilding every frame (eg for moving sprites) costs O(sprites).
+class SpriteGrid {
+public:
+    // map tiles per cell side
+    static constexpr uint16_t CELL_SZ { 8 };
+    // largest Sprite::scale, so that a sprite overlaps only map tiles within
+    //   half a tile of its cell
+    static constexpr float    MAX_SPRITE_SCALE { 1.0f };
+
+private:
+    uint32_t               cells_w { 0 };
+    uint32_t               cells_h { 0 };
+    // sprites as added since last clear
+    std::vector<Sprite>    added;
+    // sprites of cell (cell_x, cell_y) in cell_sprites from
+    //   cell_offsets[(cell_y * cells_w) + cell_x] to that + 1
+    std::vector<uint32_t>  cell_offsets;
+    std::vector<Sprite>    cell_sprites;
+
+    size_t cellIndex(const float x, const float y) const;
+
+public:
+    /**
+     * @brief size grid to cover a map, and remove all sprites
+     *
+     * @param map_w - map width in tiles
+     * @param map_h - map height in tiles
+     */
+    void resize(const uint32_t map_w, const uint32_t map_h);
+
+    uint32_t cellsWidth() const { return cells_w; }
+    uint32_t cellsHeight() const { return cells_h; }
+
+    /**
+     * @brief remove all sprites
+     */
+    void clear();
+    /**
+     * @brief add sprite, to be bucketed by next build
+     *
+     * @param sprite - sprite to add (coordinates outside the map are bucketed
+     *                   in the nearest edge cell)
+     */
+    void add(const Sprite& sprite) { added.push_back(sprite); }
+    /**
+     * @brief bucket sprites added since last clear into cells
+     */
+    void build();
+
+    uint32_t size() const { return cell_sprites.size(); }
+
+    /**
+     * @brief call func(const Sprite&) for each sprite in a rectangle of cells
+     *
+     * @param begin_cell_x - leftmost cell column
+     * @param begin_cell_y - lowest cell row
+     * @param end_cell_x   - one past rightmost cell column
+     * @param end_cell_y   - one past highest cell row
+     * @param func         - called for each sprite
+     */
+    template <typename FuncT>
+    void forEachInCells(const uint32_t begin_cell_x, const uint32_t begin_cell_y,
+                        const uint32_t end_cell_x, const uint32_t end_cell_y,
+                        FuncT&& func) const {
+        for (uint32_t cell_y { begin_cell_y }; cell_y < end_cell_y; ++cell_y) {
+            // cells in a row are contiguous in cell_sprites
+            const size_t row_i { size_t(cell_y) * cells_w };
+            for (uint32_t k { cell_offsets[row_i + begin_cell_x] };
+                 k < cell_offsets[row_i + end_cell_x]; ++k) {
+                func(cell_sprites[k]);
+            }
+        }
+    }
+    /**
+     * @brief call func(const Sprite&) for each sprite in cells overlapping a
+     *   rectangle of the map
+     *
+     * @param min_x - left edge in map coordinates
+     * @param min_y - bottom edge in map coordinates
+     * @param max_x - right edge in map coordinates
+     * @param max_y - top edge in map coordinates
+     * @param func  - called for each sprite
+     */
+    template <typename FuncT>
+    void forEachNear(const float min_x, const float min_y,
+                     const float max_x, const float max_y, FuncT&& func) const {
+        if (cells_w == 0 || !(max_x >= 0) || !(max_y >= 0) ||
+            !(min_x < cells_w * CELL_SZ) || !(min_y < cells_h * CELL_SZ)) {
+            return;
+        }
+        const uint32_t begin_cell_x ( std::max(min_x, 0.0f) / CELL_SZ );
+        const uint32_t begin_cell_y ( std::max(min_y, 0.0f) / CELL_SZ );
+        // clamp before narrowing, as out of range float to int is undefined
+        //   (in double, as float cannot hold every cell count exactly)
+        const uint32_t end_cell_x ( std::min(double(max_x) / CELL_SZ,
+                                             double(cells_w - 1)) + 1 );
+        const uint32_t end_cell_y ( std::min(double(max_y) / CELL_SZ,
+                                             double(cells_h - 1)) + 1 );
+        forEachInCells(begin_cell_x, begin_cell_y, end_cell_x, end_cell_y,
+                       func);
+    }
+};
+
+
+#endif  // SPRITEGRID_HH
@@ -0,0 +1,85 @@
+#ifndef THREADPOOL_HH
+#define THREADPOOL_HH
+
+#include <cstdint>
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>                // exception_ptr
+
+
+// Persistent set of worker threads, created once at startup and sleeping
+//   between jobs rather than being spawned and joined every frame. A job is a
+//   range of indices (eg screen columns) split into fixed-size strips, which
+//   the workers and the calling thread claim one at a time until none remain,
+//   so that strips of uneven cost still balance across cores.
+class ThreadPool {
+public:
+    // called once per strip with its index range [begin, end)
+    using StripFunc = std::function<void(const uint32_t begin, const uint32_t end)>;
+
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex               mtx;
+    // signals workers that a new job is available (or that pool is stopping)
+    std::condition_variable  job_cv;
+    // signals calling thread that all workers have left the current job
+    std::condition_variable  done_cv;
+    // incremented for every job, so waking workers can tell a new job from a
+    //   spurious wakeup
+    uint64_t                 job_id       { 0 };
+    // workers still inside current job
+    uint16_t                 busy_ct      { 0 };
+    bool                     stopping     { false };
+
+    // current job
+    //
+    const StripFunc*         strip_func   { nullptr };
+    uint32_t                 job_sz       { 0 };
+    uint32_t                 strip_sz     { 1 };
+    std::atomic<uint32_t>    next_strip_begin { 0 };
+    // first exception thrown by any strip, rethrown in calling thread
+    std::exception_ptr       job_exception;
+
+    void workerLoop();
+    // claim and process strips until the job range is exhausted
+    void workStrips();
+
+public:
+    /**
+     * @brief start worker threads
+     *
+     * @param thread_ct - total threads working each job, including the calling
+     *                      thread; 0 uses the hardware concurrency
+     */
+    explicit ThreadPool(const uint16_t thread_ct = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief threads working each job, including the calling thread
+     */
+    uint16_t size() const { return workers.size() + 1; }
+
+    /**
+     * @brief split [0, job_sz) into strips and process them across the pool,
+     *   blocking until all strips are done
+     *
+     * @param _job_sz   - total index count
+     * @param _strip_sz - indices per strip (last strip may be shorter)
+     * @param func      - strip function, must be safe to call concurrently on
+     *                      disjoint ranges
+     */
+    void forEachStrip(const uint32_t _job_sz, const uint32_t _strip_sz,
+                      const StripFunc& func);
+};
+
+
+#endif  // THREADPOOL_HH
@@ -0,0 +1,222 @@
+#ifndef TILECHUNKCACHE_HH
+#define TILECHUNKCACHE_HH
+
+#include "Vector2d.hh"
+
+#include <cstdint>
+#include <cstddef>    // size_t
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>     // unique_ptr
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <iosfwd>     // ifstream streamoff
+
+
+// Tiles of a chunk map, held in memory only in part: the map is split into
+//   square chunks of CHUNK_SZ x CHUNK_SZ tiles, read from the map file on
+//   demand by a loader thread, and dropped least recently used first once more
+//   are resident than fit in the memory budget.
+// A chunk map file is a text header of CHUNK_MAP_HEADER, then "w h chunk_log2"
+//   (map size in tiles, and log2 of CHUNK_SZ), then "player x y" (start
+//   position in map coordinates), each on its own line, followed directly by
+//   the chunks as raw bytes: in rows of chunks from the map origin, each
+//   chunk CHUNK_SZ rows of CHUNK_SZ texture keys (0 for empty) with +y north.
+//   Chunks past the map edge are padded with walls, and the map's outermost
+//   tiles must be walls, as for tile maps.
+// Lookups run on any thread while a frame is cast, and treat tiles of chunks
+//   that are not resident as walls with texture key 0 (drawn as fog), asking
+//   the loader for the chunk. Chunks loaded are only made visible to lookups,
+//   and evicted, by update, between frames.
+class TileChunkCache {
+public:
+    static constexpr uint8_t  CHUNK_LOG2 { 8 };
+    static constexpr uint32_t CHUNK_SZ { 1u << CHUNK_LOG2 };
+    static constexpr uint32_t CHUNK_MASK { CHUNK_SZ - 1 };
+    static constexpr size_t   CHUNK_TILE_CT { size_t(CHUNK_SZ) * CHUNK_SZ };
+    // first line of a chunk map file
+    static constexpr char     CHUNK_MAP_HEADER[] { "chunks" };
+
+private:
+    struct Chunk {
+        // last frame (see update) the chunk was looked up or wanted, for LRU
+        //   eviction; written by lookups on any thread
+        std::atomic<uint32_t> use_frame { 0 };
+        size_t                chunk_i;
+        uint8_t               tiles[CHUNK_TILE_CT];
+    };
+
+    // chunks within this many chunks (in x and y) of the player, and of the
+    //   point PREFETCH_AHEAD_DIST along its direction of travel, are loaded
+    //   before any ray reaches them
+    static constexpr uint8_t  PREFETCH_RADIUS { 1 };
+    static constexpr double   PREFETCH_AHEAD_DIST { 2.0 * CHUNK_SZ };
+    // budgets smaller than the chunks prefetched would evict them as they load
+    static constexpr uint32_t MIN_BUDGET_CHUNK_CT {
+        2 * (2 * PREFETCH_RADIUS + 1) * (2 * PREFETCH_RADIUS + 1) };
+
+    // states of each chunk in chunk_states
+    enum ChunkState : uint8_t { ABSENT, QUEUED, RESIDENT };
+
+    std::string               map_filename;
+    // file offset of first chunk
+    std::streamoff            data_offset { 0 };
+    uint32_t                  chunks_w { 0 };
+    uint32_t                  chunks_h { 0 };
+    uint32_t                  budget_chunk_ct { MIN_BUDGET_CHUNK_CT };
+
+    // per chunk, in rows of chunks: resident chunk, or nullptr (changed only
+    //   by update, between frames)
+    std::vector<Chunk*>       chunk_table;
+    // per chunk: ChunkState, so that each missing chunk is queued once
+    std::unique_ptr<std::atomic<uint8_t>[]> chunk_states;
+    // owners of the chunks in chunk_table
+    std::vector<std::unique_ptr<Chunk>> resident;
+    // frames so far, counted by update
+    uint32_t                  frame { 0 };
+    // player position at last update, to find its direction of travel
+    Vector2d                  prev_pos { 0, 0 };
+
+    // loader thread
+    //
+    std::thread               loader;
+    mutable std::mutex        load_mtx;
+    // signals loader that chunks are queued (or that cache is closing)
+    mutable std::condition_variable load_cv;
+    // chunk indices to load, nearest the player first (as of last update)
+    mutable std::deque<size_t> load_queue;
+    // chunks read by loader but not yet installed by update
+    std::vector<std::unique_ptr<Chunk>> loaded;
+    // chunks loader has taken from load_queue but not yet put in loaded
+    uint32_t                  loading_ct { 0 };
+    // first error reading the map file, rethrown by update
+    std::string               load_error;
+    bool                      stopping { false };
+
+    size_t chunkIndex(const uint32_t x, const uint32_t y) const {
+        return (size_t(y >> CHUNK_LOG2) * chunks_w) + (x >> CHUNK_LOG2);
+    }
+
+    static size_t tileOffset(const uint32_t x, const uint32_t y) {
+        return (size_t(y & CHUNK_MASK) << CHUNK_LOG2) | (x & CHUNK_MASK);
+    }
+
+    /**
+     * @brief chunk containing tile (x, y) if resident, marked as used this
+     *   frame; otherwise nullptr, with the chunk queued for loading
+     *
+     * @param x, y - map tile
+     */
+    Chunk* lookup(const uint32_t x, const uint32_t y) const {
+        const size_t chunk_i { chunkIndex(x, y) };
+        Chunk* chunk { chunk_table[chunk_i] };
+        if (chunk == nullptr) {
+            queueMissing(chunk_i);
+            return nullptr;
+        }
+        // stored only when changed, so that the cache line stays shared
+        //   between threads for the rest of the frame
+        if (chunk->use_frame.load(std::memory_order_relaxed) != frame)
+            chunk->use_frame.store(frame, std::memory_order_relaxed);
+        return chunk;
+    }
+    /**
+     * @brief queue a chunk for loading if not already resident or queued
+     *
+     * @param chunk_i - chunk index
+     */
+    void queueMissing(const size_t chunk_i) const;
+    /**
+     * @brief read a chunk from the map file
+     *
+     * @param map_ifs - map file, opened in binary mode
+     * @param chunk_i - chunk index
+     *
+     * @return chunk, or nullptr if it could not be read
+     */
+    std::unique_ptr<Chunk> readChunk(std::ifstream& map_ifs,
+                                     const size_t chunk_i) const;
+    // load queued chunks until stopping
+    void loaderLoop();
+    /**
+     * @brief call func(chunk_i) for each chunk within PREFETCH_RADIUS chunks
+     *   of a point, clamped to the map
+     *
+     * @param pos  - point in map coordinates
+     * @param func - called for each chunk
+     */
+    template <typename FuncT>
+    void forEachChunkNear(const Vector2d& pos, FuncT&& func) const;
+
+public:
+    TileChunkCache() {}
+    ~TileChunkCache();
+
+    TileChunkCache(const TileChunkCache&) = delete;
+    TileChunkCache& operator=(const TileChunkCache&) = delete;
+
+    uint32_t w { 0 };  // tiles
+    uint32_t h { 0 };  // tiles
+
+    /**
+     * @brief read a chunk map file's header, and the chunks around its start
+     *   position (so the first frame has them), then start the loader thread
+     *
+     * @param _map_filename - chunk map file
+     * @param budget_mb     - memory for resident chunks, in MiB (raised to
+     *                          fit at least the chunks prefetched)
+     * @param player_pos    - set to start position
+     */
+    void open(const std::string& _map_filename, const uint32_t budget_mb,
+              Vector2d& player_pos);
+
+    bool tileIsWall(const uint32_t x, const uint32_t y) const {
+        // assert(x < w && y < h);
+        const Chunk* chunk { lookup(x, y) };
+        return chunk == nullptr || chunk->tiles[tileOffset(x, y)] != 0;
+    }
+
+    // texture key of tile (x, y), or 0 if its chunk is not resident
+    uint8_t tile(const uint32_t x, const uint32_t y) const {
+        // assert(x < w && y < h);
+        const Chunk* chunk { lookup(x, y) };
+        return (chunk == nullptr) ? 0 : chunk->tiles[tileOffset(x, y)];
+    }
+
+    /**
+     * @brief install chunks loaded since the last call, queue chunks around
+     *   the player and ahead of it for prefetching, and evict the least
+     *   recently used chunks over the budget; not to be called while other
+     *   threads look up tiles, so is called between frames
+     *
+     * @param pos - player position
+     * @param dir - player direction, for prefetching ahead when the player
+     *                has not moved since the last call
+     *
+     * @return whether any chunk was installed or evicted
+     */
+    bool update(const Vector2d& pos, const Vector2d& dir);
+
+    // chunks currently resident
+    uint32_t residentCount() const { return resident.size(); }
+
+    /**
+     * @brief write a map held in memory as a chunk map file
+     *
+     * @param map_filename - file to write
+     * @param tiles        - texture keys of map, in rows from the origin
+     * @param _w, _h       - map size in tiles
+     * @param player_pos   - start position
+     */
+    static void writeFile(const std::string& map_filename,
+                          const uint8_t* tiles,
+                          const uint32_t _w, const uint32_t _h,
+                          const Vector2d& player_pos);
+};
+
+
+#endif  // TILECHUNKCACHE_HH
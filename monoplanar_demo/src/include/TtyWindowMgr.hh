@@ -3,7 +3,7 @@
 
 #include "WindowMgr.hh"
 #include "TtyPixelBuffer.hh"
-#include "DdaRaycastEngine.hh"  // WallOrientation FovRay
+#include "DdaRaycastEngine.hh"  // WallOrientation FovRayBuffer
 #include "Settings.hh"          // TtyDisplayMode
 #include "KbdInputMgr.hh"
 
@@ -17,32 +17,42 @@
 
 class TtyWindowMgr : public WindowMgr {
 private:
+    // rows needed to print debug mode HUD, including FPS line
+    static constexpr uint16_t HUD_DEBUG_LINE_CT { 17 };
+
     TtyPixelBuffer buffer;
 
     uint16_t minimap_w;
     uint16_t minimap_h;
 
-    void renderAsciiPixelColumn(const uint16_t screen_x,
-                                const int16_t ceiling_screen_y,
+    void renderAsciiPixelColumn(const Viewport& viewport,
+                                const uint16_t view_x,
+                                const int16_t ceiling_view_y,
                                 const uint16_t line_h,
-                                const WallOrientation wall_hit_algnmt);
+                                const char wall_c);
 
-    void render256ColorPixelColumn(const uint16_t screen_x,
-                                   const int16_t ceiling_screen_y,
+    void render256ColorPixelColumn(const Viewport& viewport,
+                                   const uint16_t view_x,
+                                   const int16_t ceiling_view_y,
                                    const uint16_t line_h,
-                                   const WallOrientation wall_hit_algnmt,
-                                   const SDL_Surface* texture,
-                                   const uint16_t tex_x);
+                                   const uint8_t* light_lut,
+                                   const WallTexColumn& tex_column,
+                                   const uint16_t fog_weight);
 
-    void renderTrueColorPixelColumn(const uint16_t screen_x,
-                                    const int16_t ceiling_screen_y,
+    void renderTrueColorPixelColumn(const Viewport& viewport,
+                                    const uint16_t view_x,
+                                    const int16_t ceiling_view_y,
                                     const uint16_t line_h,
-                                    const WallOrientation wall_hit_algnmt,
-                                    const SDL_Surface* texture,
-                                    const uint16_t tex_x);
+                                    const uint8_t* light_lut,
+                                    const WallTexColumn& tex_column,
+                                    const uint16_t fog_weight);
+
+    bool castsFloorCeiling(const Settings& settings) const;
 
-    void renderPixelColumn(const uint16_t screen_x, const FovRay& ray,
-                           const TtyDisplayMode tty_display_mode);
+    void renderFloorCeilingRow(const Viewport& viewport,
+                               const uint16_t floor_view_y,
+                               const uint16_t begin_x, const uint16_t end_x,
+                               const Settings& settings);
 
 public:
     std::string tty_name;
@@ -56,20 +66,31 @@ public:
     void resetBuffer();
     void drawEmptyFrame();
 
-    void initialize(const Settings& settings, const uint16_t layout_h);
+    void initialize(const Settings& settings, const uint32_t layout_h);
+
+    void fitToWindow(const double map_proportion, const uint32_t /*layout_h*/);
+
+    void renderPixelColumn(const Viewport& viewport, const uint16_t view_x,
+                           const FovRayBuffer& fov_rays,
+                           const Settings& settings);
 
-    void fitToWindow(const double map_proportion, const uint16_t /*layout_h*/);
+    void renderSpriteColumn(const Viewport& viewport, const uint16_t view_x,
+                            const ViewSprite& sprite,
+                            const uint32_t* tex_column,
+                            const Settings& settings);
 
-    void renderView(const std::vector<FovRay>& fov_rays,
-                    const Settings& settings);
+    void copyPixelColumn(const Viewport& viewport, const uint16_t src_view_x,
+                         const uint16_t dst_view_x);
 
-    void renderMap(const DdaRaycastEngine& raycast_engine);
+    void renderMap(const DdaRaycastEngine& raycast_engine,
+                   const SpriteGrid& sprites);
 
     // TBD: change to KbdInputMgr*?
     void renderHud(const double pt_frame_duration_mvg_avg,
                    const double rt_frame_duration_mvg_avg,
                    const Settings& settings,
                    const DdaRaycastEngine& raycast_engine,
+                   const AgentSim& agent_sim,
                    const KbdInputMgr* kbd_input_mgr);
 
     void drawFrame(const Settings& settings);
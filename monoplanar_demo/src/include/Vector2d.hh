@@ -1,7 +1,9 @@
 /*
  * @file Vector2d.hh was stripped down from Matrix.hh to improve the
  *   performance and readability of Vector2d use in monoplanar_demo, at the
- *   cost of Matrix's templated flexbility.
+ *   cost of Matrix's templated flexbility. The scalar type remains a template
+ *   parameter so that raycasting can be done in float or fixed point as well
+ *   as double.
  */
 
 #ifndef VECTOR2D_HH
@@ -13,7 +15,8 @@
 #include <type_traits>  // enable_if
 
 
-class Vector2d {
+template <typename ScalarType>
+class Vector2 {
 private:
     // https://stackoverflow.com/questions/6247153/angle-from-2d-unit-vector
     static constexpr inline double radiansToDegrees(const double radians) {
@@ -21,24 +24,39 @@ private:
     }
 
 public:
-    double x;
-    double y;
+    ScalarType x;
+    ScalarType y;
 
-    Vector2d() {}
-    Vector2d(const double _x, const double _y) : x(_x), y(_y) {}
+    Vector2() {}
+    Vector2(const ScalarType _x, const ScalarType _y) : x(_x), y(_y) {}
+    // conversion from vector of other scalar type
+    template <typename OtherScalarType>
+    explicit Vector2(const Vector2<OtherScalarType>& other) :
+        x(other.x), y(other.y) {}
 
     template <typename ScalarMultiplierType>
-    auto operator*(const ScalarMultiplierType sm) -> typename std::enable_if<
-        std::is_scalar<ScalarMultiplierType>::value, Vector2d>::type {
-        return Vector2d { this->x * sm, this->y * sm };
+    auto operator*(const ScalarMultiplierType sm) const -> typename std::enable_if<
+        std::is_scalar<ScalarMultiplierType>::value ||
+        std::is_same<ScalarMultiplierType, ScalarType>::value, Vector2>::type {
+        return Vector2 { this->x * ScalarType(sm), this->y * ScalarType(sm) };
     }
 
-    Vector2d operator+(const Vector2d other);
-    // degrees from +x axis
+    Vector2 operator+(const Vector2 other) const {
+        return Vector2 { this->x + other.x, this->y + other.y };
+    }
+
+    // degrees from +x axis (floating point types only)
     double angle() const;
-    // ccw rotation (QI to QIV)
+    // ccw rotation (QI to QIV) (floating point types only)
     void rotate(const double radians);
 };
 
+// angle() and rotate() instantiated in Vector2d.cc
+extern template class Vector2<double>;
+extern template class Vector2<float>;
+
+using Vector2d = Vector2<double>;
+using Vector2f = Vector2<float>;
+
 
 #endif  // VECTOR2D_HH
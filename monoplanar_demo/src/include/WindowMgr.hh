@@ -1,9 +1,12 @@
 #ifndef WINDOWMGR_HH
 #define WINDOWMGR_HH
 
-#include "DdaRaycastEngine.hh"  // FovRay
+#include "DdaRaycastEngine.hh"  // FovRayBuffer
+#include "AgentSim.hh"
+#include "SpriteGrid.hh"
 #include "KbdInputMgr.hh"
 #include "Settings.hh"
+#include "ThreadPool.hh"
 
 #include "sdl2_smart_ptr.hh"   // sdl2_smart_ptr::unique::
 
@@ -11,10 +14,26 @@
 
 #include <vector>
 #include <array>
+#include <algorithm>  // min
 
 
 namespace sdl2_unq = sdl2_smart_ptr::unique;
 
+// rectangle of the window buffer that one camera is rendered into, in pixels
+struct Viewport {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+};
+
+// camera to render, and where; the camera must have been fit to the size of
+//   its viewport (DdaRaycastEngine::fitToWindow)
+struct CameraView {
+    DdaRaycastEngine* camera;
+    Viewport          viewport;
+};
+
 class WindowMgr {
 protected:
     // wall textures (SDL_Surface instead of SDL_Texture for per-pixel access)
@@ -34,7 +53,312 @@ protected:
         ""
     };
 
+    // Wall texture texels packed as 0xRRGGBB, row-major; converted once from
+    //   the loaded SDL_Surface so that sampling needs no SDL_GetRGB
+    struct WallTexLevel {
+        uint16_t              w;
+        uint16_t              h;
+        std::vector<uint32_t> texels;
+    };
+    // Levels of detail per wall texture, indexed like wall_texs: level 0 is
+    //   full size, and each level after is a 2x2 box filtered half of the
+    //   last. Key 0 (FovRayBuffer::NO_HIT_TEX_KEY) holds a single fog colored
+    //   texel, for rays that reached the draw distance.
+    std::vector<std::vector<WallTexLevel>> wall_tex_levels;
+    // column of one WallTexLevel to sample for a wall strip
+    struct WallTexColumn {
+        // top texel
+        const uint32_t* texels;
+        uint16_t        w;
+        uint16_t        h;
+    };
+
+    // fog color, as WallTexLevel texel
+    static constexpr uint32_t FOG_RGB { 0x8c9aa6 };
+    // fraction of Settings::draw_dist at which walls start fading into fog
+    static constexpr float    FOG_START_RATIO { 0.5f };
+    // fogWeight of walls at the draw distance (fog color only)
+    static constexpr uint16_t FOG_WEIGHT_MAX { 256 };
+
+    /**
+     * @brief fill wall_tex_levels from wall_texs; called after loading
+     */
+    void buildWallTexLevels();
+    /**
+     * @brief find texture column to sample for a wall strip: with
+     *   settings.texture_lod, the smallest level still at least as tall as
+     *   the strip, so that texture sampling cost and cache footprint stay
+     *   proportional to the strip, with levels falling into distance bands
+     *   that double in width (as line_h is inversely proportional to dist)
+     *
+     * @param screen_x - horizontal pixel coordinate of strip
+     * @param fov_rays - rays cast for frame
+     * @param line_h   - height of wall strip in pixels
+     * @param settings - current game settings
+     */
+    WallTexColumn wallTexColumn(const uint16_t screen_x,
+                                const FovRayBuffer& fov_rays,
+                                const uint16_t line_h,
+                                const Settings& settings) const;
+    /**
+     * @brief how far a wall has faded into fog, from 0 (none) to
+     *   FOG_WEIGHT_MAX
+     *
+     * @param dist     - wall distance
+     * @param settings - current game settings
+     */
+    static uint16_t fogWeight(const float dist, const Settings& settings);
+    /**
+     * @brief light level a wall column is shaded at: the light of the face
+     *   it hit, halved for NS walls to differentiate
+     *
+     * @param light  - FovRayBuffer::light
+     * @param algnmt - FovRayBuffer::algnmt
+     */
+    static uint8_t wallLightLevel(const uint8_t light,
+                                  const WallOrientation algnmt) {
+        return (algnmt == WallOrientation::NS) ? light / 2 : light;
+    }
+    /**
+     * @brief light_luts row of a light level
+     *
+     * @param level - from 0 to Layout::LIGHT_LEVEL_CT - 1
+     */
+    const uint8_t* lightLut(const uint8_t level) const {
+        return light_luts[level].data();
+    }
+    /**
+     * @brief unpack texel, scaling it by a light level, and blending in fog
+     *
+     * @param texel      - 0xRRGGBB
+     * @param light_lut  - as returned by lightLut
+     * @param fog_weight - as returned by fogWeight
+     * @param r          - set to red
+     * @param g          - set to green
+     * @param b          - set to blue
+     */
+    static void shadeTexel(const uint32_t texel, const uint8_t* light_lut,
+                           const uint16_t fog_weight,
+                           uint8_t& r, uint8_t& g, uint8_t& b) {
+        r = light_lut[(texel >> 16) & 0xff];
+        g = light_lut[(texel >> 8) & 0xff];
+        b = light_lut[texel & 0xff];
+        if (fog_weight == 0)
+            return;
+        // integer lerp toward fog color
+        r += ((int32_t((FOG_RGB >> 16) & 0xff) - r) * fog_weight) / FOG_WEIGHT_MAX;
+        g += ((int32_t((FOG_RGB >> 8) & 0xff) - g) * fog_weight) / FOG_WEIGHT_MAX;
+        b += ((int32_t(FOG_RGB & 0xff) - b) * fog_weight) / FOG_WEIGHT_MAX;
+    }
+
+    /**
+     * @brief wall strip of a pixel column
+     *
+     * @param viewport_h     - viewport height in pixels
+     * @param dist           - wall distance (FovRayBuffer::dist)
+     * @param line_h         - set to height of wall strip in pixels
+     * @param ceiling_view_y - set to row index in viewport of highest pixel in
+     *                           strip (may be negative if camera is close to
+     *                           wall and wall unit does not fit in frame)
+     */
+    static void wallLine(const uint16_t viewport_h, const float dist,
+                         uint16_t& line_h, int16_t& ceiling_view_y) {
+        line_h = viewport_h / dist;
+        ceiling_view_y = viewport_h / 2 - line_h / 2;
+    }
+
+    // Floor and ceiling casting
+    //
+    // Every pixel row of floor below the horizon shows the floor at the same
+    //   distance (as does its mirror row of ceiling, with the camera halfway
+    //   up the walls), so map coordinates, and with them texture coordinates,
+    //   are linear in the column across a row. Row pairs are cast across each
+    //   strip after its wall strips are rendered, with castFloorCeilingRow
+    //   writing shaded texels to floor_row_rgb and ceiling_row_rgb, and
+    //   renderFloorCeilingRow then writing them to the pixels above and below
+    //   the wall strips, so each pixel is written once.
+    //
+    // wall_texs keys of the textures cast onto the floor and ceiling
+    static constexpr uint8_t FLOOR_TEX_KEY { 4 };
+    static constexpr uint8_t CEILING_TEX_KEY { 1 };
+    // Per window column (views rendered at once share no window columns, so
+    //   each entry is written by one thread at a time, like its pixel column):
+    //   viewport rows of first wall pixel and one past last wall pixel
+    std::vector<uint16_t> column_wall_begin_y;
+    std::vector<uint16_t> column_wall_end_y;
+    // per window column: shaded floor and ceiling texels (0xRRGGBB) of the
+    //   row pair last cast
+    std::vector<uint32_t> floor_row_rgb;
+    std::vector<uint32_t> ceiling_row_rgb;
+
+    /**
+     * @brief level of a floor or ceiling texture to sample for a row: with
+     *   settings.texture_lod, the smallest level with at least as many texels
+     *   per map unit as the row has pixels
+     *
+     * @param tex_key       - wall_texs key
+     * @param px_per_unit   - pixels per map unit across the row
+     * @param settings      - current game settings
+     */
+    const WallTexLevel& floorCeilingTexLevel(const uint8_t tex_key,
+                                             const float px_per_unit,
+                                             const Settings& settings) const;
+    /**
+     * @brief fill floor_row_rgb and ceiling_row_rgb for the cast columns of a
+     *   strip
+     *
+     * @param view         - camera and viewport
+     * @param floor_view_y - viewport row of floor, from viewport.h / 2; the
+     *                         ceiling row is viewport.h - 1 - floor_view_y
+     * @param begin_x      - first viewport column of strip
+     * @param end_x        - one past last viewport column of strip
+     * @param settings     - current game settings
+     */
+    void castFloorCeilingRow(const CameraView& view, const uint16_t floor_view_y,
+                             const uint16_t begin_x, const uint16_t end_x,
+                             const Settings& settings);
+    /**
+     * @brief whether floor and ceiling are cast in the current display mode
+     *   (otherwise renderPixelColumn fills them)
+     */
+    virtual bool castsFloorCeiling(const Settings& /*settings*/) const {
+        return true;
+    }
+    /**
+     * @brief write floor_row_rgb and ceiling_row_rgb to the pixels of a row
+     *   pair not covered by wall strips, for the cast columns of a strip; same
+     *   concurrency rules as renderPixelColumn, for the strip's columns
+     *
+     * @param viewport     - viewport of strip
+     * @param floor_view_y - as castFloorCeilingRow
+     * @param begin_x      - first viewport column of strip
+     * @param end_x        - one past last viewport column of strip
+     * @param settings     - current game settings
+     */
+    virtual void renderFloorCeilingRow(const Viewport& viewport,
+                                       const uint16_t floor_view_y,
+                                       const uint16_t begin_x,
+                                       const uint16_t end_x,
+                                       const Settings& settings) = 0;
+
+    // Sprite textures, indexed by Sprite::tex_key: SPRITE_TEX_SZ square,
+    //   texels packed as 0xAARRGGBB, where alpha 0 is transparent (and any
+    //   other alpha opaque.) Generated rather than loaded, as figures shaded
+    //   in each of sprite_rgbs.
+    std::vector<WallTexLevel> sprite_texs;
+    static constexpr uint16_t SPRITE_TEX_SZ { 32 };
+    static constexpr std::array<uint32_t, 4> sprite_rgbs {
+        0xffd700, 0xe04848, 0x48c048, 0x4888e8
+    };
+    // sprites nearer than this are not drawn, keeping their pixel height in
+    //   range (they would be inside the player anyway)
+    static constexpr float SPRITE_NEAR_DIST { 0.25f };
+
+    // Texel channel scaled by each light level (see Layout::tileLight), as
+    //   light_luts[level][channel], saturating at 255: a table shared by all
+    //   textures, as they are true color rather than palettized
+    std::array<std::array<uint8_t, 256>, Layout::LIGHT_LEVEL_CT> light_luts;
+
+    // sprite projected into one camera's viewport
+    struct ViewSprite {
+        // compared against FovRayBuffer::dist to occlude sprite columns behind
+        //   walls
+        float           dist;
+        // viewport column (fractional) of left edge, may be negative
+        float           left_x;
+        // texture columns per viewport column
+        float           tex_per_col;
+        // viewport row of top edge, may be negative
+        int16_t         top_y;
+        // height in pixels
+        uint16_t        h;
+        // viewport columns covered: begin_x to end_x - 1
+        uint16_t        begin_x;
+        uint16_t        end_x;
+        // as returned by fogWeight
+        uint16_t        fog_weight;
+        // as returned by lightLut, for the tile the sprite stands in
+        const uint8_t*  light_lut;
+        // top left texel of sprite texture
+        const uint32_t* texels;
+    };
+
+    /**
+     * @brief fill sprite_texs; called after loading
+     */
+    void buildSpriteTexs();
+    /**
+     * @brief fill light_luts; called after loading
+     */
+    void buildLightLuts();
+    /**
+     * @brief find the sprites in a camera's view, sorted far to near: only
+     *   the grid cells overlapping the FOV are searched, then each sprite in
+     *   them is projected and culled to the viewport columns it covers
+     *
+     * @param view         - camera and viewport
+     * @param sprites      - sprites to project
+     * @param settings     - current game settings
+     * @param view_sprites - set to visible sprites
+     */
+    void projectSprites(const CameraView& view, const SpriteGrid& sprites,
+                        const Settings& settings,
+                        std::vector<ViewSprite>& view_sprites) const;
+    /**
+     * @brief top texel of a sprite's texture column under a viewport column
+     *
+     * @param sprite - projected sprite
+     * @param view_x - viewport column, from sprite.begin_x to sprite.end_x - 1
+     */
+    static const uint32_t* spriteTexColumn(const ViewSprite& sprite,
+                                           const uint16_t view_x) {
+        const uint16_t tex_x ( std::min(
+            (view_x + 0.5f - sprite.left_x) * sprite.tex_per_col,
+            float(SPRITE_TEX_SZ - 1)) );
+        return sprite.texels + tex_x;
+    }
+
+    // minimum columns per strip when splitting FOV across threads, to keep
+    //   strip claiming overhead and cache line sharing at strip edges small
+    static constexpr uint16_t MIN_STRIP_W { 8 };
+    // strips per thread, so that threads finishing cheap strips (far walls)
+    //   early can take on more of the remaining work
+    static constexpr uint16_t STRIPS_PER_THREAD { 4 };
+
+    // column range of one camera view, claimed by one thread at a time
+    struct ViewStrip {
+        const CameraView*              view;
+        uint16_t                       begin_x;
+        uint16_t                       end_x;
+        // visible sprites of view, of which those overlapping the strip are
+        //   indexed by strip_sprite_is from sprite_is_begin to sprite_is_end
+        const std::vector<ViewSprite>* sprites;
+        uint32_t                       sprite_is_begin;
+        uint32_t                       sprite_is_end;
+    };
+    // strips of the current renderViews pass
+    std::vector<ViewStrip> view_strips;
+    // visible sprites of each view of the current renderViews pass
+    std::vector<std::vector<ViewSprite>> pass_view_sprites;
+    // indices into ViewStrip::sprites, far to near for each strip
+    std::vector<uint32_t>  strip_sprite_is;
+
+    /**
+     * @brief called on main thread before any columns of a viewport are
+     *   rendered
+     */
+    virtual void beginView(const Viewport& /*viewport*/,
+                           const Settings& /*settings*/) {}
+    /**
+     * @brief called on main thread after all columns of all viewports are
+     *   rendered
+     */
+    virtual void endView(const Settings& /*settings*/) {}
+
 public:
+    // valid Sprite::tex_key are below this
+    static constexpr uint8_t spriteTexCount() { return sprite_rgbs.size(); }
+
     virtual uint32_t id() { return 0; }
     virtual uint16_t width() = 0;
     virtual uint16_t height() = 0;
@@ -43,21 +367,93 @@ public:
     virtual void drawEmptyFrame() {}
 
     virtual void initialize(const Settings& settings,
-                            const uint16_t layout_h) = 0;
+                            const uint32_t layout_h) = 0;
 
     virtual void fitToWindow(const double map_proportion,
-                             const uint16_t layout_h) = 0;
+                             const uint32_t layout_h) = 0;
+
+    /**
+     * @brief cast and render all FOV columns, with each thread in thread_pool
+     *   casting a strip of rays and then immediately rendering their
+     *   respective pixel columns, without waiting for the others
+     *
+     * @param raycast_engine - engine to cast rays into
+     * @param sprites        - sprites to draw over walls
+     * @param settings       - current game settings
+     * @param thread_pool    - workers to split columns across
+     */
+    void renderView(DdaRaycastEngine& raycast_engine, const SpriteGrid& sprites,
+                    const Settings& settings, ThreadPool& thread_pool);
+    /**
+     * @brief cast and render several cameras (eg split screen or inset views)
+     *   in as few thread_pool jobs as possible: the strips of every camera in
+     *   a pass are claimed from one job, so threads done with one camera's
+     *   strips move straight on to another's, with map and textures still in
+     *   cache. Views sharing window columns with an earlier view start a new
+     *   pass, so those overlapping it are drawn over it. Sprites are drawn over the walls of each column as it
+     *   is rendered, far to near, skipping those behind the column's wall.
+     *
+     * @param views       - cameras and their viewports
+     * @param sprites     - sprites to draw over walls
+     * @param settings    - current game settings
+     * @param thread_pool - workers to split columns across
+     */
+    void renderViews(const std::vector<CameraView>& views,
+                     const SpriteGrid& sprites, const Settings& settings,
+                     ThreadPool& thread_pool);
+
+    // The core illusion of raycasting comes from rendering walls in vertical
+    //   strips, one per each ray cast in the FOV, with each strip being longer
+    //   as the ray is shorter/wall is closer, forcing perspective. Pixels
+    //   above and below the strip are left to renderFloorCeilingRow, unless
+    //   castsFloorCeiling is false.
+    // Called concurrently for different view_x, so must only write to
+    //   pixels in its own column of the viewport.
+    virtual void renderPixelColumn(const Viewport& viewport,
+                                   const uint16_t view_x,
+                                   const FovRayBuffer& fov_rays,
+                                   const Settings& settings) = 0;
+    /**
+     * @brief draw the opaque texels of one column of a sprite over a rendered
+     *   pixel column; same concurrency rules as renderPixelColumn
+     *
+     * @param viewport   - viewport of column
+     * @param view_x     - horizontal viewport pixel coordinate of column
+     * @param sprite     - projected sprite
+     * @param tex_column - top texel of sprite texture column to draw, from
+     *                       spriteTexColumn
+     * @param settings   - current game settings
+     */
+    virtual void renderSpriteColumn(const Viewport& viewport,
+                                    const uint16_t view_x,
+                                    const ViewSprite& sprite,
+                                    const uint32_t* tex_column,
+                                    const Settings& settings) = 0;
 
-    virtual void renderView(const std::vector<FovRay>& fov_rays,
-                            const Settings& settings) = 0;
+    /**
+     * @brief copy an already rendered pixel column to another column of the
+     *   viewport, to fill columns skipped by Settings::column_scale; same
+     *   concurrency rules as renderPixelColumn, for dst_view_x
+     *
+     * @param viewport   - viewport of both columns
+     * @param src_view_x - horizontal viewport pixel coordinate of rendered
+     *                       column
+     * @param dst_view_x - horizontal viewport pixel coordinate of column to
+     *                       fill
+     */
+    virtual void copyPixelColumn(const Viewport& viewport,
+                                 const uint16_t src_view_x,
+                                 const uint16_t dst_view_x) = 0;
 
-    virtual void renderMap(const DdaRaycastEngine& raycast_engine) = 0;
+    virtual void renderMap(const DdaRaycastEngine& raycast_engine,
+                           const SpriteGrid& sprites) = 0;
 
     // TBD: change to KbdInputMgr*?
     virtual void renderHud(const double pt_frame_duration_mvg_avg,
                            const double rt_frame_duration_mvg_avg,
                            const Settings& settings,
                            const DdaRaycastEngine& raycast_engine,
+                           const AgentSim& agent_sim,
                            const KbdInputMgr* kbd_input_mgr) = 0;
 
     virtual void drawFrame(const Settings& settings) = 0;
@@ -1,21 +1,30 @@
 #include "App.hh"
 #include "WindowMgr.hh"
 #include "SdlWindowMgr.hh"
-#include "Settings.hh"         // TtyDisplayMode
+#include "Settings.hh"         // TtyDisplayMode ScalarType
+#include "DdaRaycastEngine.hh"
+#include "ThreadPool.hh"
 #include "xterm_ctrl_seqs.hh"  // CtrlSeqs
 
 #include <getopt.h>            // option getopt_long optind
 #include <cctype>              // tolower
+#include <cstdlib>             // strtoul strtod
+#include <cstdint>             // UINT16_MAX
+#include <cmath>               // cos sin M_PI
 
 #include <iostream>
+#include <iomanip>             // setprecision
 #include <string>
+#include <chrono>
+#include <random>              // mt19937 uniform_real_distribution
+#include <stdexcept>           // runtime_error
 
 
 // static contexpr class members in C++11 require declaration outside of the
 //   class, doing so once here follows ODR
 constexpr std::array<const char*, 10> WindowMgr::wall_tex_paths;
+constexpr std::array<uint32_t, 4> WindowMgr::sprite_rgbs;
 
-constexpr char SdlWindowMgr::SKY_TEX_PATH[];
 constexpr char SdlWindowMgr::FONT_PATH[];
 
 
@@ -30,6 +39,11 @@ static void printUsage(const char* exec_filename) {
     std::cerr << "\nUsage: " << exec_filename << "...\n\n" <<
         "\t-m=mapfile\n" <<
         "\t--map=mapfile\t Opens mapfile path to initialize maze map (required)\n" <<
+        "\t\t\t (rows of tile digits, or a segment map: a first line\n" <<
+        "\t\t\t of 'segments', then 'x0 y0 x1 y1 tex_key' walls\n" <<
+        "\t\t\t and one 'player x y' start; either may add\n" <<
+        "\t\t\t 'light x y radius brightness' point lights; or a\n" <<
+        "\t\t\t chunk map written by --write-chunks)\n" <<
         "\n" <<
         "\t-X\n" <<
         "\t--SDL\t\t Display and keyboard capture via SDL2/X11\n" <<
@@ -42,6 +56,82 @@ static void printUsage(const char* exec_filename) {
         "\t\t\t   ascii: monochrome characters (default tty mode)\n" <<
         "\t\t\t   code/256color/1byte: terminal background colors (256 color mode)\n" <<
         "\t\t\t   rgb/truecolor/3byte: terminal background colors (true (RGB) color mode)\n" <<
+        "\n" <<
+        "\t-j threads\n" <<
+        "\t--threads=threads Threads used to cast and render the view, including\n" <<
+        "\t\t\t main thread (default: hardware concurrency)\n" <<
+        "\n" <<
+        "\t-s scalar\n" <<
+        "\t--scalar=scalar\t Numeric type used to cast rays:\n" <<
+        "\t\t\t   double: 64-bit floating point (default)\n" <<
+        "\t\t\t   float: 32-bit floating point\n" <<
+        "\t\t\t   fixed: 32-bit Q16.16 fixed point\n" <<
+        "\n" <<
+        "\t--accuracy-report Print error of float and fixed ray casting relative\n" <<
+        "\t\t\t to double, and of wall span casting relative to\n" <<
+        "\t\t\t casting every column, for the map, then exit\n" <<
+        "\n" <<
+        "\t--packets\t Cast adjacent rays together as SIMD packets (also\n" <<
+        "\t\t\t toggled in game with F5)\n" <<
+        "\n" <<
+        "\t--no-rebase\t Cast rays relative to the map origin rather than the\n" <<
+        "\t\t\t player's tile (loses float and fixed point precision\n" <<
+        "\t\t\t far from the origin of large maps)\n" <<
+        "\n" <<
+        "\t--skip=skipmode Empty space skipping in ray casting:\n" <<
+        "\t\t\t   none: step through every map tile (default)\n" <<
+        "\t\t\t   distance: jump by distance to nearest wall\n" <<
+        "\t\t\t   pyramid: jump across largest empty block of a 4x4,\n" <<
+        "\t\t\t     16x16, 64x64... hierarchy\n" <<
+        "\n" <<
+        "\t--layout=storage Memory layout of map wall lookups:\n" <<
+        "\t\t\t   rowmajor: 1 byte per tile in rows (default)\n" <<
+        "\t\t\t   tiled: 1 bit per tile in 8x8 tile blocks\n" <<
+        "\t\t\t (chunk maps are always paged in from disk)\n" <<
+        "\n" <<
+        "\t--chunk-budget=MB Memory for the chunks of a chunk map held at once,\n" <<
+        "\t\t\t least recently used evicted first (default: 256)\n" <<
+        "\n" <<
+        "\t--write-chunks=chunkfile Write the tile map as a chunk map, loaded\n" <<
+        "\t\t\t from disk in 256x256 tile chunks as the player\n" <<
+        "\t\t\t approaches them, then exit\n" <<
+        "\n" <<
+        "\t--draw-dist=dist Distance at which rays stop and walls fade fully into\n" <<
+        "\t\t\t fog, in map units (default: 0, unlimited)\n" <<
+        "\n" <<
+        "\t--wall-spans\t Cast rays a wall face at a time, filling the columns\n" <<
+        "\t\t\t between the ends of each face analytically\n" <<
+        "\n" <<
+        "\t--pvs\t\t Find the wall faces visible from each map tile on\n" <<
+        "\t\t\t loading, and find rays from the faces visible from\n" <<
+        "\t\t\t the player's tile (each empty tile is tested against\n" <<
+        "\t\t\t the faces it may reach, taking some seconds of work\n" <<
+        "\t\t\t across the threads for the 96x96 maps/open_map1;\n" <<
+        "\t\t\t maps over 256x256 tiles are refused), or load them\n" <<
+        "\t\t\t from mapfile.pvs if written by --write-pvs for the\n" <<
+        "\t\t\t same walls\n" <<
+        "\n" <<
+        "\t--write-pvs\t Find the wall faces visible from each map tile as\n" <<
+        "\t\t\t --pvs, write them to mapfile.pvs, then exit\n" <<
+        "\n" <<
+        "\t--cameras=layout Cameras rendered into the window:\n" <<
+        "\t\t\t   single: player view only (default)\n" <<
+        "\t\t\t   split: player and rear views side by side\n" <<
+        "\t\t\t   inset: rear view inset at top of player view\n" <<
+        "\n" <<
+        "\t--agents=count\t Agents wandering the map, simulated every tick and\n" <<
+        "\t\t\t shown on the minimap (default: 0)\n" <<
+        "\n" <<
+        "\t--target-fps=fps Cast and render only every 2nd or 4th column while\n" <<
+        "\t\t\t the frame rate is below fps, copying the rest\n" <<
+        "\t\t\t (default: 0, always full resolution)\n" <<
+        "\n" <<
+        "\t--tick-rate=hz\t Rate of the fixed simulation steps moving the player,\n" <<
+        "\t\t\t independent of frame rate (default: 60)\n" <<
+        "\n" <<
+        "\t--benchmark\t Print DDA steps per ray, and ray casting and batched\n" <<
+        "\t\t\t ray query rates, for each layout and skip mode on\n" <<
+        "\t\t\t the map, then exit\n" <<
         std::endl;
 }
 
@@ -53,20 +143,48 @@ static void printUsage(const char* exec_filename) {
  *                             getopt_long)
  * @param map_filename     - set by reference to layout map file name
  * @param io_mode          - enum set by reference to tty or sdl mode
- * @param tty_display_mode - enum set by reference to tty pixel mode
+ * @param settings         - set by reference to initial game settings
+ * @param accuracy_report  - set by reference to print accuracy report only
+ * @param benchmark        - set by reference to print benchmark only
+ * @param chunk_map_filename - set by reference to write chunk map only
+ * @param write_pvs        - set by reference to write potentially visible
+ *                             sets only
  *
  * @return 0 on success, 1 on failure
  */
 static int getOptions(const int argc, char* const argv[],
                       std::string& map_filename, IoMode& io_mode,
-                      TtyDisplayMode& tty_display_mode) {
+                      Settings& settings, bool& accuracy_report,
+                      bool& benchmark, std::string& chunk_map_filename,
+                      bool& write_pvs) {
     constexpr struct option long_options[] {
-        {"SDL", no_argument,       nullptr, 'X' },
-        {"tty", optional_argument, nullptr, 't' },
-        {"map", required_argument, nullptr, 'm' },
+        {"SDL",             no_argument,       nullptr, 'X' },
+        {"tty",             optional_argument, nullptr, 't' },
+        {"map",             required_argument, nullptr, 'm' },
+        {"threads",         required_argument, nullptr, 'j' },
+        {"scalar",          required_argument, nullptr, 's' },
+        // long options only, so 'a', 'v', 'r', 'k', 'l', 'u', 'o', 'd', 'w',
+        //   'p', 'e', 'c', 'n', 'f', 'i' and 'b'
+        //   intentionally absent from optstring
+        {"accuracy-report", no_argument,       nullptr, 'a' },
+        {"packets",         no_argument,       nullptr, 'v' },
+        {"no-rebase",       no_argument,       nullptr, 'r' },
+        {"skip",            required_argument, nullptr, 'k' },
+        {"layout",          required_argument, nullptr, 'l' },
+        {"chunk-budget",    required_argument, nullptr, 'u' },
+        {"write-chunks",    required_argument, nullptr, 'o' },
+        {"draw-dist",       required_argument, nullptr, 'd' },
+        {"wall-spans",      no_argument,       nullptr, 'w' },
+        {"pvs",             no_argument,       nullptr, 'p' },
+        {"write-pvs",       no_argument,       nullptr, 'e' },
+        {"cameras",         required_argument, nullptr, 'c' },
+        {"agents",          required_argument, nullptr, 'n' },
+        {"target-fps",      required_argument, nullptr, 'f' },
+        {"tick-rate",       required_argument, nullptr, 'i' },
+        {"benchmark",       no_argument,       nullptr, 'b' },
         {nullptr, 0, 0, 0 }   // required sentinel with null name field
     };
-    constexpr char optstring[] { "Xt::m:" };
+    constexpr char optstring[] { "Xt::m:j:s:" };
 
     int c;
     int option_i { 0 };
@@ -96,13 +214,13 @@ static int getOptions(const int argc, char* const argv[],
             for (auto& c : optarg_s)
                 c = std::tolower(c);
             if (optarg_s == "ascii") {
-                tty_display_mode = TtyDisplayMode::Ascii;
+                settings.tty_display_mode = TtyDisplayMode::Ascii;
             } else if (optarg_s == "code" || optarg_s == "256color" ||
                 optarg_s == "1byte") {
-                tty_display_mode = TtyDisplayMode::ColorCode;
+                settings.tty_display_mode = TtyDisplayMode::ColorCode;
             } else if (optarg_s == "rgb" || optarg_s == "truecolor" ||
                        optarg_s == "3byte") {
-                tty_display_mode = TtyDisplayMode::TrueColor;
+                settings.tty_display_mode = TtyDisplayMode::TrueColor;
             } else if (optarg_s != "") {
                 std::cerr << argv[0] << ": Unrecognized tty display mode: \"" <<
                     optarg_s << "\".\n";
@@ -113,6 +231,173 @@ static int getOptions(const int argc, char* const argv[],
         case 'm':
             map_filename = optarg;
             break;
+        case 'j':
+        {
+            char* end;
+            unsigned long thread_ct { std::strtoul(optarg, &end, 10) };
+            if (*end != '\0' || thread_ct == 0 || thread_ct > UINT16_MAX) {
+                std::cerr << argv[0] << ": Invalid thread count: \"" <<
+                    optarg << "\".\n";
+                return 1;
+            }
+            settings.thread_ct = thread_ct;
+        }
+            break;
+        case 's':
+        {
+            std::string optarg_s { optarg };
+            for (auto& c : optarg_s)
+                c = std::tolower(c);
+            if (optarg_s == "double") {
+                settings.scalar_type = ScalarType::Double;
+            } else if (optarg_s == "float") {
+                settings.scalar_type = ScalarType::Float;
+            } else if (optarg_s == "fixed") {
+                settings.scalar_type = ScalarType::Fixed16_16;
+            } else {
+                std::cerr << argv[0] << ": Unrecognized scalar type: \"" <<
+                    optarg_s << "\".\n";
+                return 1;
+            }
+        }
+            break;
+        case 'a':
+            accuracy_report = true;
+            break;
+        case 'v':
+            settings.ray_packets = true;
+            break;
+        case 'r':
+            settings.rebase_origin = false;
+            break;
+        case 'k':
+        {
+            std::string optarg_s { optarg };
+            for (auto& c : optarg_s)
+                c = std::tolower(c);
+            if (optarg_s == "none") {
+                settings.empty_space_skip = EmptySpaceSkip::None;
+            } else if (optarg_s == "distance") {
+                settings.empty_space_skip = EmptySpaceSkip::DistanceField;
+            } else if (optarg_s == "pyramid") {
+                settings.empty_space_skip = EmptySpaceSkip::OccupancyPyramid;
+            } else {
+                std::cerr << argv[0] << ": Unrecognized skip mode: \"" <<
+                    optarg_s << "\".\n";
+                return 1;
+            }
+        }
+            break;
+        case 'l':
+        {
+            std::string optarg_s { optarg };
+            for (auto& c : optarg_s)
+                c = std::tolower(c);
+            if (optarg_s == "rowmajor") {
+                settings.layout_storage = LayoutStorage::RowMajor;
+            } else if (optarg_s == "tiled") {
+                settings.layout_storage = LayoutStorage::TiledBitmap;
+            } else {
+                std::cerr << argv[0] << ": Unrecognized layout storage: \"" <<
+                    optarg_s << "\".\n";
+                return 1;
+            }
+        }
+            break;
+        case 'u':
+        {
+            char* end;
+            unsigned long chunk_budget_mb { std::strtoul(optarg, &end, 10) };
+            if (*end != '\0' || chunk_budget_mb == 0 ||
+                chunk_budget_mb > UINT32_MAX) {
+                std::cerr << argv[0] << ": Invalid chunk budget: \"" <<
+                    optarg << "\".\n";
+                return 1;
+            }
+            settings.chunk_budget_mb = chunk_budget_mb;
+        }
+            break;
+        case 'o':
+            chunk_map_filename = optarg;
+            break;
+        case 'd':
+        {
+            char* end;
+            double draw_dist { std::strtod(optarg, &end) };
+            if (*end != '\0' || !(draw_dist >= 0)) {
+                std::cerr << argv[0] << ": Invalid draw distance: \"" <<
+                    optarg << "\".\n";
+                return 1;
+            }
+            settings.draw_dist = draw_dist;
+        }
+            break;
+        case 'w':
+            settings.wall_spans = true;
+            break;
+        case 'p':
+            settings.pvs = true;
+            break;
+        case 'e':
+            write_pvs = true;
+            break;
+        case 'c':
+        {
+            std::string optarg_s { optarg };
+            for (auto& c : optarg_s)
+                c = std::tolower(c);
+            if (optarg_s == "single") {
+                settings.camera_layout = CameraLayout::Single;
+            } else if (optarg_s == "split") {
+                settings.camera_layout = CameraLayout::SplitScreen;
+            } else if (optarg_s == "inset") {
+                settings.camera_layout = CameraLayout::RearInset;
+            } else {
+                std::cerr << argv[0] << ": Unrecognized camera layout: \"" <<
+                    optarg_s << "\".\n";
+                return 1;
+            }
+        }
+            break;
+        case 'n':
+        {
+            char* end;
+            unsigned long agent_ct { std::strtoul(optarg, &end, 10) };
+            if (*end != '\0' || agent_ct > UINT32_MAX) {
+                std::cerr << argv[0] << ": Invalid agent count: \"" <<
+                    optarg << "\".\n";
+                return 1;
+            }
+            settings.agent_ct = agent_ct;
+        }
+            break;
+        case 'f':
+        {
+            char* end;
+            double target_fps { std::strtod(optarg, &end) };
+            if (*end != '\0' || !(target_fps >= 0)) {
+                std::cerr << argv[0] << ": Invalid target frame rate: \"" <<
+                    optarg << "\".\n";
+                return 1;
+            }
+            settings.target_fps = target_fps;
+        }
+            break;
+        case 'i':
+        {
+            char* end;
+            double sim_tick_rate { std::strtod(optarg, &end) };
+            if (*end != '\0' || !(sim_tick_rate > 0)) {
+                std::cerr << argv[0] << ": Invalid tick rate: \"" <<
+                    optarg << "\".\n";
+                return 1;
+            }
+            settings.sim_tick_rate = sim_tick_rate;
+        }
+            break;
+        case 'b':
+            benchmark = true;
+            break;
         case 0:    // long option parsed
             // should only return if longopts member without option.val matched
         case '?':  // unknown option
@@ -136,6 +421,164 @@ static int getOptions(const int argc, char* const argv[],
     return 0;
 }
 
+/**
+ * @brief cast rays from map starting position in each reduced precision scalar
+ *   type and print their error relative to double, then (tile maps only)
+ *   print the error of wall span casting relative to casting every column
+ *
+ * @param map_filename - map file
+ * @param settings     - initial game settings
+ */
+static void printAccuracyReport(const std::string& map_filename,
+                                const Settings& settings) {
+    // reference window size, rays are independent of display mode
+    static constexpr uint16_t REPORT_WINDOW_W { 853 };
+    static constexpr uint16_t REPORT_WINDOW_H { 480 };
+
+    DdaRaycastEngine raycast_engine;
+    raycast_engine.loadMapFile(map_filename, settings.layout_storage,
+                               settings.chunk_budget_mb);
+    raycast_engine.fitToWindow(false, REPORT_WINDOW_W, REPORT_WINDOW_H);
+    std::cout << std::setprecision(3);
+    for (const ScalarType scalar_type :
+             { ScalarType::Float, ScalarType::Fixed16_16 }) {
+        const ScalarAccuracyReport report {
+            raycast_engine.scalarAccuracyReport(scalar_type, settings) };
+        std::cout << scalarTypeName(scalar_type) << " vs double (" <<
+            report.ray_ct << " rays):\n" <<
+            "\twrong wall hit:          " << report.wall_mismatch_ct << "\n" <<
+            "\tmax distance error:      " << report.max_dist_err << "\n" <<
+            "\tmean distance error:     " << report.mean_dist_err << "\n" <<
+            "\tmax rel. distance error: " << report.max_rel_dist_err << "\n" <<
+            "\tmax texture u error:     " << report.max_hit_x_err << "\n";
+    }
+    // segment maps are never cast by wall spans
+    if (raycast_engine.layout.hasSegments())
+        return;
+    const ScalarAccuracyReport report {
+        raycast_engine.wallSpanAccuracyReport(settings) };
+    std::cout << "wall spans vs every column cast, in " <<
+        scalarTypeName(settings.scalar_type) << " (" << report.ray_ct <<
+        " rays):\n" <<
+        "\twrong wall hit:          " << report.wall_mismatch_ct << "\n" <<
+        "\tmax distance error:      " << report.max_dist_err << "\n" <<
+        "\tmean distance error:     " << report.mean_dist_err << "\n" <<
+        "\tmax rel. distance error: " << report.max_rel_dist_err << "\n" <<
+        "\tmax texture u error:     " << report.max_hit_x_err << "\n";
+}
+
+/**
+ * @brief write a tile map as a chunk map file
+ *
+ * @param map_filename       - tile map file
+ * @param chunk_map_filename - chunk map file to write
+ */
+static void writeChunkMap(const std::string& map_filename,
+                          const std::string& chunk_map_filename) {
+    DdaRaycastEngine raycast_engine;
+    raycast_engine.loadMapFile(map_filename);
+    raycast_engine.layout.writeChunkMapFile(chunk_map_filename,
+                                            raycast_engine.player_pos);
+    std::cout << "Wrote chunk map file: " << chunk_map_filename << "\n";
+}
+
+/**
+ * @brief build the potentially visible sets of a tile map and write them
+ *   beside it, for --pvs to load
+ *
+ * @param map_filename - tile map file
+ * @param settings     - current game settings (thread_ct used)
+ */
+static void writePvs(const std::string& map_filename, const Settings& settings) {
+    DdaRaycastEngine raycast_engine;
+    ThreadPool thread_pool { settings.thread_ct };
+    raycast_engine.loadMapFile(map_filename);
+    raycast_engine.layout.buildPotentiallyVisibleSets(thread_pool);
+    const std::string pvs_filename { map_filename + Layout::PVS_FILE_SUFFIX };
+    raycast_engine.layout.writePvsFile(pvs_filename);
+    std::cout << "Wrote potentially visible sets file: " << pvs_filename << "\n";
+}
+
+/**
+ * @brief cast every ray over a full turn of the player at the map starting
+ *   position with each layout storage and empty space skipping mode, printing
+ *   DDA loop iterations per ray and rays cast per second, then a batch of ray
+ *   queries from random points in random directions, printing queries cast
+ *   per second
+ *
+ * @param map_filename - map file
+ * @param settings     - initial game settings (scalar_type, ray_packets,
+ *                         draw_dist and thread_ct used)
+ */
+static void printBenchmark(const std::string& map_filename,
+                           const Settings& settings) {
+    static constexpr uint16_t BENCHMARK_WINDOW_W { 853 };
+    static constexpr uint16_t BENCHMARK_WINDOW_H { 480 };
+    static constexpr uint16_t BENCHMARK_FRAME_CT { 720 };
+    static constexpr uint32_t BENCHMARK_QUERY_CT { 1 << 20 };
+
+    ThreadPool thread_pool { settings.thread_ct };
+    Settings bench_settings { settings };
+    // every ray cast every frame
+    bench_settings.ray_cache = false;
+    std::cout << std::fixed << std::setprecision(2) <<
+        "scalar: " << scalarTypeName(settings.scalar_type) <<
+        " ray_packets: " << settings.ray_packets <<
+        " draw_dist: " << settings.draw_dist << "\n";
+    for (const LayoutStorage layout_storage :
+             { LayoutStorage::RowMajor, LayoutStorage::TiledBitmap }) {
+        DdaRaycastEngine raycast_engine;
+        raycast_engine.loadMapFile(map_filename, layout_storage);
+        raycast_engine.fitToWindow(false, BENCHMARK_WINDOW_W, BENCHMARK_WINDOW_H);
+        // same queries for each layout storage
+        const Layout& layout { raycast_engine.layout };
+        // (queries start anywhere on the map, and chunks are only loaded
+        //   between frames)
+        if (layout.isPaged()) {
+            throw std::runtime_error(
+                "Benchmark needs a map held in memory, not a chunk map");
+        }
+        std::mt19937 rng;
+        std::uniform_real_distribution<double> unit_dist { 0, 1 };
+        RayQueryBuffer rays;
+        rays.resize(BENCHMARK_QUERY_CT);
+        for (uint32_t i { 0 }; i < BENCHMARK_QUERY_CT; ++i) {
+            Vector2d origin;
+            do {
+                origin = { unit_dist(rng) * layout.w, unit_dist(rng) * layout.h };
+            } while (layout.tileIsWall(uint32_t(origin.x), uint32_t(origin.y)));
+            const double angle { unit_dist(rng) * 2 * M_PI };
+            rays.setRay(i, origin, { std::cos(angle), std::sin(angle) });
+        }
+        for (const EmptySpaceSkip empty_space_skip :
+                 { EmptySpaceSkip::None, EmptySpaceSkip::DistanceField,
+                   EmptySpaceSkip::OccupancyPyramid }) {
+            bench_settings.empty_space_skip = empty_space_skip;
+            double step_ct_sum { 0 };
+            const auto start { std::chrono::steady_clock::now() };
+            for (uint16_t frame_i { 0 }; frame_i < BENCHMARK_FRAME_CT; ++frame_i) {
+                raycast_engine.playerTurnLeft(2 * M_PI / BENCHMARK_FRAME_CT);
+                raycast_engine.castRays(bench_settings);
+                step_ct_sum += raycast_engine.frameStepsPerRay();
+            }
+            const std::chrono::duration<double> elapsed {
+                std::chrono::steady_clock::now() - start };
+            const auto query_start { std::chrono::steady_clock::now() };
+            raycast_engine.castRayQueries(rays, bench_settings, thread_pool);
+            const std::chrono::duration<double> query_elapsed {
+                std::chrono::steady_clock::now() - query_start };
+            std::cout << "layout " << std::setw(8) <<
+                layoutStorageName(layout_storage) << " skip " << std::setw(8) <<
+                emptySpaceSkipName(empty_space_skip) << ": " <<
+                std::setw(7) << step_ct_sum / BENCHMARK_FRAME_CT << " steps/ray " <<
+                std::setw(7) << (double(BENCHMARK_FRAME_CT) * BENCHMARK_WINDOW_W /
+                                 elapsed.count() / 1000000) << " Mrays/s " <<
+                std::setw(7) << (BENCHMARK_QUERY_CT / query_elapsed.count() /
+                                 1000000) << " Mqueries/s\n";
+        }
+    }
+}
+
 /**
  * @brief entry point
  *
@@ -147,20 +590,46 @@ static int getOptions(const int argc, char* const argv[],
 int main(const int argc, char* const argv[]) {
     std::string map_filename;
     IoMode io_mode  { IoMode::Uninitialized };
-    TtyDisplayMode tty_display_mode { TtyDisplayMode::Uninitialized };
+    Settings settings;
+    bool accuracy_report { false };
+    bool benchmark { false };
+    std::string chunk_map_filename;
+    bool write_pvs { false };
 
-    if (getOptions(argc, argv, map_filename, io_mode, tty_display_mode) != 0) {
+    if (getOptions(argc, argv, map_filename, io_mode, settings,
+                   accuracy_report, benchmark, chunk_map_filename,
+                   write_pvs) != 0) {
         printUsage(argv[0]);
         return EXIT_FAILURE;
     }
 
+    if (accuracy_report || benchmark || !chunk_map_filename.empty() ||
+        write_pvs) {
+        try {
+            if (!chunk_map_filename.empty())
+                writeChunkMap(map_filename, chunk_map_filename);
+            if (write_pvs)
+                writePvs(map_filename, settings);
+            if (accuracy_report)
+                printAccuracyReport(map_filename, settings);
+            if (benchmark)
+                printBenchmark(map_filename, settings);
+        } catch (const std::runtime_error& rte) {
+            std::cerr << argv[0] << " runtime error: " << rte.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
     if (io_mode == IoMode::Uninitialized)
         io_mode = IoMode::Sdl;
-    if (io_mode == IoMode::Tty && tty_display_mode == TtyDisplayMode::Uninitialized)
-        tty_display_mode = TtyDisplayMode::Ascii;
+    if (io_mode == IoMode::Tty &&
+        settings.tty_display_mode == TtyDisplayMode::Uninitialized) {
+        settings.tty_display_mode = TtyDisplayMode::Ascii;
+    }
 
     try {
-        App app(argv[0], map_filename, (io_mode == IoMode::Tty), tty_display_mode);
+        App app(argv[0], map_filename, (io_mode == IoMode::Tty), settings);
         app.run();
     } catch (const std::runtime_error& rte) {
         // sudden failure of app in tty mode can leave cursor hidden or terminal